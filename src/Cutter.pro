@@ -310,6 +310,7 @@ SOURCES += \
     widgets/DecompilerWidget.cpp \
     widgets/VisualNavbar.cpp \
     widgets/GraphView.cpp \
+    widgets/GraphSpatialIndex.cpp \
     dialogs/preferences/PreferencesDialog.cpp \
     dialogs/preferences/AppearanceOptionsWidget.cpp \
     dialogs/preferences/GraphOptionsWidget.cpp \
@@ -339,6 +340,7 @@ SOURCES += \
     widgets/ThreadsWidget.cpp \
     widgets/ProcessesWidget.cpp \
     widgets/BacktraceWidget.cpp \
+    widgets/TraceWidget.cpp \
     dialogs/OpenFileDialog.cpp \
     common/CommandTask.cpp \
     common/ProgressIndicator.cpp \
@@ -361,6 +363,23 @@ SOURCES += \
     common/QtResImporter.cpp \
     common/CutterSeekable.cpp \
     common/RefreshDeferrer.cpp \
+    common/StringsTask.cpp \
+    common/GraphLayoutTask.cpp \
+    common/HashTask.cpp \
+    common/NameIndex.cpp \
+    common/NameIndexTask.cpp \
+    common/SectionStatistics.cpp \
+    common/IOPageCache.cpp \
+    common/PreviewCache.cpp \
+    common/DebugStateSnapshot.cpp \
+    common/Telescope.cpp \
+    common/TraceFile.cpp \
+    common/TraceRecordTask.cpp \
+    common/TraceHitCountTask.cpp \
+    common/TraceApplyTask.cpp \
+    common/TraceManager.cpp \
+    common/EsilRunner.cpp \
+    common/EsilRunTask.cpp \
     dialogs/WelcomeDialog.cpp \
     common/RunScriptTask.cpp \
     dialogs/EditMethodDialog.cpp \
@@ -448,6 +467,7 @@ HEADERS  += \
     widgets/DecompilerWidget.h \
     widgets/VisualNavbar.h \
     widgets/GraphView.h \
+    widgets/GraphSpatialIndex.h \
     dialogs/preferences/PreferencesDialog.h \
     dialogs/preferences/AppearanceOptionsWidget.h \
     dialogs/preferences/PreferenceCategory.h \
@@ -477,8 +497,25 @@ HEADERS  += \
     widgets/ThreadsWidget.h \
     widgets/ProcessesWidget.h \
     widgets/BacktraceWidget.h \
+    widgets/TraceWidget.h \
     dialogs/OpenFileDialog.h \
     common/StringsTask.h \
+    common/GraphLayoutTask.h \
+    common/HashTask.h \
+    common/NameIndex.h \
+    common/NameIndexTask.h \
+    common/SectionStatistics.h \
+    common/IOPageCache.h \
+    common/PreviewCache.h \
+    common/DebugStateSnapshot.h \
+    common/Telescope.h \
+    common/TraceFile.h \
+    common/TraceRecordTask.h \
+    common/TraceHitCountTask.h \
+    common/TraceApplyTask.h \
+    common/TraceManager.h \
+    common/EsilRunner.h \
+    common/EsilRunTask.h \
     common/FunctionsTask.h \
     common/CommandTask.h \
     common/ProgressIndicator.h \
@@ -578,6 +615,7 @@ FORMS    += \
     widgets/ThreadsWidget.ui \
     widgets/ProcessesWidget.ui \
     widgets/BacktraceWidget.ui \
+    widgets/TraceWidget.ui \
     dialogs/OpenFileDialog.ui \
     dialogs/preferences/DebugOptionsWidget.ui \
     widgets/BreakpointWidget.ui \
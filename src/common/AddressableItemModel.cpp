@@ -1,5 +1,77 @@
 #include "AddressableItemModel.h"
 
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+namespace {
+
+/**
+ * Smaller models are sorted by comparing their rows directly
+ */
+const int MIN_RANKED_ROWS = 20000;
+
+using RowLessThan = std::function<bool(int, int)>;
+
+class SortRowsRunnable : public QRunnable
+{
+public:
+    SortRowsRunnable(int *begin, int *end, const RowLessThan *lessThan)
+        : begin(begin), end(end), lessThan(lessThan)
+    {
+    }
+
+    void run() override
+    {
+        std::sort(begin, end, *lessThan);
+    }
+
+private:
+    int *begin;
+    int *end;
+    const RowLessThan *lessThan;
+};
+
+/**
+ * @brief Sort rows in one chunk per thread, then merge the sorted chunks
+ */
+void sortRowsParallel(QVector<int> &rows, const RowLessThan &lessThan)
+{
+    int threads = std::max(1, QThread::idealThreadCount());
+    int chunkSize = std::max(1, (rows.size() + threads - 1) / threads);
+    int *data = rows.data();
+
+    QVector<int> bounds;
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    for (int from = 0; from < rows.size(); from += chunkSize) {
+        int to = std::min(from + chunkSize, rows.size());
+        pool.start(new SortRowsRunnable(data + from, data + to, &lessThan));
+        bounds.append(from);
+    }
+    bounds.append(rows.size());
+    pool.waitForDone();
+
+    while (bounds.size() > 2) {
+        QVector<int> merged;
+        for (int i = 0; i + 2 < bounds.size(); i += 2) {
+            std::inplace_merge(data + bounds[i], data + bounds[i + 1], data + bounds[i + 2], lessThan);
+            merged.append(bounds[i]);
+        }
+        if (bounds.size() % 2 == 0) {
+            // odd number of chunks, the last one is merged in the next pass
+            merged.append(bounds[bounds.size() - 2]);
+        }
+        merged.append(bounds.last());
+        bounds = merged;
+    }
+}
+
+}
+
 AddressableFilterProxyModel::AddressableFilterProxyModel(AddressableItemModelI *sourceModel,
                                                          QObject *parent) :
     AddressableItemModel<QSortFilterProxyModel>(parent)
@@ -25,6 +97,231 @@ void AddressableFilterProxyModel::setSourceModel(QAbstractItemModel *)
 
 void AddressableFilterProxyModel::setSourceModel(AddressableItemModelI *sourceModel)
 {
-    ParentClass::setSourceModel(sourceModel->asItemModel());
+    for (const QMetaObject::Connection &connection : sourceConnections) {
+        disconnect(connection);
+    }
+    sourceConnections.clear();
+
+    // Connected before QSortFilterProxyModel connects its own handlers, so keys and ranks are
+    // already up to date when the proxy filters and sorts the changed rows.
+    QAbstractItemModel *model = sourceModel->asItemModel();
+    sourceConnections << connect(model, &QAbstractItemModel::modelAboutToBeReset, this, [this]() {
+        invalidateRanks();
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::modelReset, this, [this]() {
+        rebuildFilterKeys();
+        updateRanks(sortColumn());
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::rowsAboutToBeInserted, this, [this]() {
+        invalidateRanks();
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::rowsInserted, this,
+    [this](const QModelIndex & parent, int first, int last) {
+        if (rowIndexEnabled && !parent.isValid()) {
+            filterKeys.insert(first, last - first + 1, QString());
+            updateFilterKeys(first, last);
+        }
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this]() {
+        invalidateRanks();
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::rowsRemoved, this,
+    [this](const QModelIndex & parent, int first, int last) {
+        if (rowIndexEnabled && !parent.isValid()) {
+            filterKeys.remove(first, last - first + 1);
+        }
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::rowsAboutToBeMoved, this, [this]() {
+        invalidateRanks();
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::rowsMoved, this, [this]() {
+        rebuildFilterKeys();
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::layoutAboutToBeChanged, this, [this]() {
+        invalidateRanks();
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::layoutChanged, this, [this]() {
+        rebuildFilterKeys();
+    });
+    sourceConnections << connect(model, &QAbstractItemModel::dataChanged, this,
+    [this](const QModelIndex & topLeft, const QModelIndex & bottomRight) {
+        if (!rowIndexEnabled || topLeft.parent().isValid()) {
+            return;
+        }
+        updateFilterKeys(topLeft.row(), bottomRight.row());
+        if (!ranksStillSorted(topLeft.row(), bottomRight.row())) {
+            invalidateRanks();
+        }
+    });
+
+    ParentClass::setSourceModel(model);
     addressableSourceModel = sourceModel;
+    rebuildFilterKeys();
+    invalidateRanks();
+}
+
+void AddressableFilterProxyModel::sort(int column, Qt::SortOrder order)
+{
+    updateRanks(column);
+    ParentClass::sort(column, order);
+}
+
+void AddressableFilterProxyModel::enableRowIndex()
+{
+    rowIndexEnabled = true;
+    rebuildFilterKeys();
+    invalidateRanks();
+}
+
+QString AddressableFilterProxyModel::rowFilterText(int row) const
+{
+    return sourceModel()->index(row, filterKeyColumn()).data(filterRole()).toString();
+}
+
+bool AddressableFilterProxyModel::lessThanRows(int column, int leftRow, int rightRow) const
+{
+    return ParentClass::lessThan(sourceModel()->index(leftRow, column),
+                                 sourceModel()->index(rightRow, column));
+}
+
+bool AddressableFilterProxyModel::rowMatchesFilter(int row) const
+{
+    const QRegExp regExp = filterRegExp();
+    if (regExp.isEmpty()) {
+        return true;
+    }
+    if (!(regExp == cachedFilter)) {
+        cachedFilter = regExp;
+        switch (regExp.patternSyntax()) {
+        case QRegExp::FixedString:
+            filterIsPlain = true;
+            break;
+        case QRegExp::Wildcard:
+        case QRegExp::WildcardUnix:
+            filterIsPlain = !regExp.pattern().contains(QRegExp(QStringLiteral("[*?\\[\\\\]")));
+            break;
+        default:
+            filterIsPlain = false;
+            break;
+        }
+        filterNeedle = regExp.caseSensitivity() == Qt::CaseInsensitive
+                       ? regExp.pattern().toLower()
+                       : regExp.pattern();
+    }
+
+    const QString key = row < filterKeys.size() ? filterKeys.at(row) : filterKey(row);
+    if (filterIsPlain) {
+        return key.contains(filterNeedle, Qt::CaseSensitive);
+    }
+    return key.contains(regExp);
+}
+
+bool AddressableFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    if (!rowIndexEnabled) {
+        return ParentClass::lessThan(left, right);
+    }
+    if (!left.isValid() || !right.isValid()) {
+        return false;
+    }
+    if (left.parent().isValid() || right.parent().isValid()) {
+        return false;
+    }
+    if (left.column() == rankColumn) {
+        return rowRanks.at(left.row()) < rowRanks.at(right.row());
+    }
+    return lessThanRows(left.column(), left.row(), right.row());
+}
+
+QString AddressableFilterProxyModel::filterKey(int row) const
+{
+    QString text = rowFilterText(row);
+    return filterCaseSensitivity() == Qt::CaseInsensitive ? text.toLower() : text;
+}
+
+void AddressableFilterProxyModel::updateFilterKeys(int first, int last)
+{
+    if (!rowIndexEnabled) {
+        return;
+    }
+    last = std::min(last, filterKeys.size() - 1);
+    for (int row = first; row <= last; row++) {
+        filterKeys[row] = filterKey(row);
+    }
+}
+
+void AddressableFilterProxyModel::rebuildFilterKeys()
+{
+    filterKeys.clear();
+    if (!rowIndexEnabled || !sourceModel()) {
+        return;
+    }
+    int count = sourceModel()->rowCount();
+    filterKeys.reserve(count);
+    for (int row = 0; row < count; row++) {
+        filterKeys.append(filterKey(row));
+    }
+}
+
+bool AddressableFilterProxyModel::rowLessThan(int column, int leftRow, int rightRow) const
+{
+    // break ties by row to get a strict total order, which matches a stable sort
+    if (lessThanRows(column, leftRow, rightRow)) {
+        return true;
+    }
+    if (lessThanRows(column, rightRow, leftRow)) {
+        return false;
+    }
+    return leftRow < rightRow;
+}
+
+void AddressableFilterProxyModel::updateRanks(int column)
+{
+    if (column == rankColumn && column >= 0) {
+        return;
+    }
+    invalidateRanks();
+    if (!rowIndexEnabled || column < 0 || !sourceModel()) {
+        return;
+    }
+    int count = sourceModel()->rowCount();
+    if (count < MIN_RANKED_ROWS) {
+        return;
+    }
+
+    rankedRows.resize(count);
+    std::iota(rankedRows.begin(), rankedRows.end(), 0);
+    sortRowsParallel(rankedRows, [this, column](int leftRow, int rightRow) {
+        return rowLessThan(column, leftRow, rightRow);
+    });
+    rowRanks.resize(count);
+    for (int i = 0; i < count; i++) {
+        rowRanks[rankedRows[i]] = i;
+    }
+    rankColumn = column;
+}
+
+void AddressableFilterProxyModel::invalidateRanks()
+{
+    rankColumn = -1;
+    rankedRows.clear();
+    rowRanks.clear();
+}
+
+bool AddressableFilterProxyModel::ranksStillSorted(int first, int last) const
+{
+    if (rankColumn < 0) {
+        return false;
+    }
+    // the ranked order stays valid as long as every changed row still fits between its neighbours
+    for (int row = first; row <= last && row < rowRanks.size(); row++) {
+        int rank = rowRanks[row];
+        if (rank > 0 && !rowLessThan(rankColumn, rankedRows[rank - 1], row)) {
+            return false;
+        }
+        if (rank + 1 < rankedRows.size() && !rowLessThan(rankColumn, row, rankedRows[rank + 1])) {
+            return false;
+        }
+    }
+    return true;
 }
@@ -1,10 +1,11 @@
-
 #ifndef ADDRESSABLEITEMMODEL_H
 #define ADDRESSABLEITEMMODEL_H
 
 #include <QAbstractItemModel>
 #include <QSortFilterProxyModel>
 #include <QAbstractItemModel>
+#include <QRegExp>
+#include <QVector>
 
 #include <core/CutterCommon.h>
 
@@ -41,9 +42,73 @@ public:
     RVA address(const QModelIndex &index) const override;
     QString name(const QModelIndex &) const override;
     void setSourceModel(AddressableItemModelI *sourceModel);
+
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+protected:
+    /**
+     * @brief Filter and sort top-level rows through rowFilterText() and lessThanRows()
+     *
+     * Meant for source models backed by a flat list, which subclasses access directly by row
+     * instead of going through data(). The filter text of every row is kept as a precomputed key,
+     * lowercase if the filter is case insensitive, and large models are sorted by ranks computed
+     * on several threads. Call it from the subclass constructor after setting the filter case
+     * sensitivity.
+     */
+    void enableRowIndex();
+
+    /**
+     * @return text of the top-level source row the filter is matched against
+     */
+    virtual QString rowFilterText(int row) const;
+
+    /**
+     * @brief Compare two top-level source rows by column
+     *
+     * May be called from several threads at once, so it must only read the source model's data.
+     */
+    virtual bool lessThanRows(int column, int leftRow, int rightRow) const;
+
+    /**
+     * @return true if the current filter matches the key of the top-level source row
+     */
+    bool rowMatchesFilter(int row) const;
+
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
 private:
     void setSourceModel(QAbstractItemModel *sourceModel) override; // Don't use this directly
     AddressableItemModelI *addressableSourceModel;
+
+    bool rowIndexEnabled = false;
+    QList<QMetaObject::Connection> sourceConnections;
+
+    QVector<QString> filterKeys;
+    mutable QRegExp cachedFilter;
+    mutable QString filterNeedle;
+    mutable bool filterIsPlain = true;
+
+    /**
+     * Column the ranks were computed for, -1 if they are not valid
+     */
+    int rankColumn = -1;
+    /**
+     * Source rows in sorted order
+     */
+    QVector<int> rankedRows;
+    /**
+     * Position of every source row in rankedRows
+     */
+    QVector<int> rowRanks;
+
+    QString filterKey(int row) const;
+    void updateFilterKeys(int first, int last);
+    void rebuildFilterKeys();
+
+    bool rowLessThan(int column, int leftRow, int rightRow) const;
+    void updateRanks(int column);
+    void invalidateRanks();
+    bool ranksStillSorted(int first, int last) const;
 };
 
 #endif // ADDRESSABLEITEMMODEL_H
@@ -1,6 +1,7 @@
 
 #include "CommandTask.h"
 #include "TempConfig.h"
+#include "IOPageCache.h"
 
 CommandTask::CommandTask(const QString &cmd, ColorMode colorMode, bool outFormatHtml)
     : cmd(cmd), colorMode(colorMode), outFormatHtml(outFormatHtml)
@@ -11,6 +12,9 @@ void CommandTask::runTask() {
     TempConfig tempConfig;
     tempConfig.set("scr.color", colorMode);
     auto res = Core()->cmdTask(cmd);
+    // Commands such as "wx" or "o" change memory behind the cached pages
+    Core()->getIOPageCache()->invalidate();
+    Core()->invalidateEmulatedCode();
     if (outFormatHtml) {
         res = CutterCore::ansiEscapeToHtml(res);
     }
@@ -707,3 +707,13 @@ void Configuration::setDecompilerAutoRefreshEnabled(bool enabled)
 {
     s.setValue("decompilerAutoRefresh", enabled);
 }
+
+int Configuration::getDebugRefreshRate()
+{
+    return s.value("debug.refreshRate", 30).toInt();
+}
+
+void Configuration::setDebugRefreshRate(int rate)
+{
+    s.setValue("debug.refreshRate", rate);
+}
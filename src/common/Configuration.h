@@ -171,6 +171,12 @@ public:
 
     bool getDecompilerAutoRefreshEnabled();
     void setDecompilerAutoRefreshEnabled(bool enabled);
+
+    /**
+     * @return how many times a second views are refreshed while queued debug steps are running
+     */
+    int getDebugRefreshRate();
+    void setDebugRefreshRate(int rate);
 public slots:
     void refreshFont();
 signals:
@@ -0,0 +1,112 @@
+#include "DebugStateSnapshot.h"
+#include "core/Cutter.h"
+
+DebugStateSnapshot::DebugStateSnapshot(QObject *parent)
+    : QObject(parent)
+{
+    // registersChanged and stackChanged are emitted several times after every stop, nothing
+    // is cached while a debug task runs, so invalidating once it started is enough
+    auto core = Core();
+    connect(core, &CutterCore::debugTaskStateChanged, this, &DebugStateSnapshot::debugTaskStateChanged);
+    connect(core, &CutterCore::toggleDebugView, this, &DebugStateSnapshot::invalidate);
+    connect(core, &CutterCore::codeRebased, this, &DebugStateSnapshot::invalidate);
+    connect(core, &CutterCore::instructionChanged, this, &DebugStateSnapshot::invalidate);
+    connect(core, &CutterCore::refreshAll, this, &DebugStateSnapshot::invalidate);
+}
+
+void DebugStateSnapshot::invalidate()
+{
+    stopId++;
+    validParts = 0;
+}
+
+void DebugStateSnapshot::setRegisters(RVA programCounter, const QJsonObject &registerValues)
+{
+    invalidate();
+    this->programCounter = programCounter;
+    this->registerValues = registerValues;
+    validParts = ProgramCounter | RegisterValues;
+}
+
+void DebugStateSnapshot::debugTaskStateChanged()
+{
+    if (Core()->isDebugTaskInProgress()) {
+        invalidate();
+    }
+}
+
+bool DebugStateSnapshot::needsUpdate(Part part)
+{
+    if (validParts & part) {
+        return false;
+    }
+    // The state of a running debuggee is outdated right away
+    if (!Core()->isDebugTaskInProgress()) {
+        validParts |= part;
+    }
+    return true;
+}
+
+RVA DebugStateSnapshot::getProgramCounter()
+{
+    if (needsUpdate(ProgramCounter)) {
+        programCounter = Core()->getProgramCounterValue();
+    }
+    return programCounter;
+}
+
+const QJsonObject &DebugStateSnapshot::getRegisterValues()
+{
+    if (needsUpdate(RegisterValues)) {
+        registerValues = Core()->getRegisterValues().object();
+    }
+    return registerValues;
+}
+
+const QList<RegisterRefDescription> &DebugStateSnapshot::getRegisterRefs()
+{
+    if (needsUpdate(RegisterRefs)) {
+        registerRefs = Core()->getRegisterRefs();
+    }
+    return registerRefs;
+}
+
+const QList<AddrRefChain> &DebugStateSnapshot::getStack()
+{
+    if (needsUpdate(Stack)) {
+        stack = Core()->getStack();
+    }
+    return stack;
+}
+
+const QJsonArray &DebugStateSnapshot::getBacktrace()
+{
+    if (needsUpdate(Backtrace)) {
+        backtrace = Core()->getBacktrace().array();
+    }
+    return backtrace;
+}
+
+const QJsonArray &DebugStateSnapshot::getThreads()
+{
+    if (needsUpdate(Threads)) {
+        threads = Core()->getProcessThreads(-1).array();
+    }
+    return threads;
+}
+
+const QJsonArray &DebugStateSnapshot::getProcesses()
+{
+    if (needsUpdate(Processes)) {
+        processes = Core()->getChildProcesses(-1).array();
+    }
+    return processes;
+}
+
+const QList<MemoryMapDescription> &DebugStateSnapshot::getMemoryMap()
+{
+    if (needsUpdate(MemoryMap)) {
+        memoryMap = Core()->getMemoryMap();
+    }
+    return memoryMap;
+}
@@ -0,0 +1,102 @@
+#ifndef DEBUGSTATESNAPSHOT_H
+#define DEBUGSTATESNAPSHOT_H
+
+#include "core/CutterCommon.h"
+#include "core/CutterDescriptions.h"
+
+#include <QObject>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+
+/**
+ * @brief State of the debuggee at its last stop, shared by all debug widgets.
+ *
+ * Every part is queried from r2 the first time any widget asks for it after a stop event and
+ * then reused by all other widgets until the next one, so stepping does not get slower with
+ * every debug widget that is open. Parts no open widget needs are never queried.
+ *
+ * The snapshot is dropped whenever a debug task starts, the code is rebased or memory and
+ * registers are edited. Only to be used from the main thread.
+ */
+class DebugStateSnapshot : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DebugStateSnapshot(QObject *parent = nullptr);
+
+    /**
+     * @brief Changes whenever the snapshot is invalidated, so widgets can tell if they already
+     * show the current state
+     */
+    quint64 getStopId() const           { return stopId; }
+
+    RVA getProgramCounter();
+    /**
+     * @brief Register names and values, as in "drj"
+     */
+    const QJsonObject &getRegisterValues();
+    const QList<RegisterRefDescription> &getRegisterRefs();
+    /**
+     * @brief Telescoped stack, as returned by CutterCore::getStack()
+     */
+    const QList<AddrRefChain> &getStack();
+    /**
+     * @brief Frames, as in "dbtj"
+     */
+    const QJsonArray &getBacktrace();
+    /**
+     * @brief Threads of the debugged process, as in "dptj"
+     */
+    const QJsonArray &getThreads();
+    /**
+     * @brief The debugged process and its children, as in "dpj"
+     */
+    const QJsonArray &getProcesses();
+    const QList<MemoryMapDescription> &getMemoryMap();
+
+    /**
+     * @brief Set the program counter and register values of a stop whose registers are already
+     * known, so they don't have to be queried again. Also used for the progress of a long
+     * emulation run, while the debug task is still in progress.
+     */
+    void setRegisters(RVA programCounter, const QJsonObject &registerValues);
+
+public slots:
+    void invalidate();
+
+private slots:
+    void debugTaskStateChanged();
+
+private:
+    enum Part {
+        ProgramCounter = 1 << 0,
+        RegisterValues = 1 << 1,
+        RegisterRefs = 1 << 2,
+        Stack = 1 << 3,
+        Backtrace = 1 << 4,
+        Threads = 1 << 5,
+        Processes = 1 << 6,
+        MemoryMap = 1 << 7
+    };
+
+    /**
+     * @return whether part has to be queried, marking it as valid if the debuggee is stopped
+     */
+    bool needsUpdate(Part part);
+
+    quint64 stopId = 0;
+    int validParts = 0;
+
+    RVA programCounter = RVA_INVALID;
+    QJsonObject registerValues;
+    QList<RegisterRefDescription> registerRefs;
+    QList<AddrRefChain> stack;
+    QJsonArray backtrace;
+    QJsonArray threads;
+    QJsonArray processes;
+    QList<MemoryMapDescription> memoryMap;
+};
+
+#endif // DEBUGSTATESNAPSHOT_H
@@ -4,40 +4,78 @@
 
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QTimer>
 
+#include <algorithm>
+
+/**
+ * Number of decompiled functions kept by each decompiler
+ */
+static const int MAX_CACHED_FUNCTIONS = 64;
+
+void AnnotatedCode::BuildIndex()
+{
+    positionIndex.clear();
+    offsetIndex.clear();
+    for (int i = 0; i < annotations.size(); i++) {
+        if (annotations[i].type == CodeAnnotation::Type::Offset) {
+            positionIndex.append(i);
+        }
+    }
+    offsetIndex = positionIndex;
+
+    // Stable, so that of equal annotations the first one still wins like with a linear scan
+    std::stable_sort(positionIndex.begin(), positionIndex.end(), [this](int a, int b) {
+        return annotations[a].start < annotations[b].start;
+    });
+    std::stable_sort(offsetIndex.begin(), offsetIndex.end(), [this](int a, int b) {
+        return annotations[a].offset.offset < annotations[b].offset.offset;
+    });
+
+    positionMaxEnd.resize(positionIndex.size());
+    size_t maxEnd = 0;
+    for (int i = 0; i < positionIndex.size(); i++) {
+        maxEnd = std::max(maxEnd, annotations[positionIndex[i]].end);
+        positionMaxEnd[i] = maxEnd;
+    }
+}
 
 ut64 AnnotatedCode::OffsetForPosition(size_t pos) const
 {
-    size_t closestPos = SIZE_MAX;
-    ut64 closestOffset = UT64_MAX;
-    for (const auto &annotation : annotations) {
-        if (annotation.type != CodeAnnotation::Type::Offset || annotation.start > pos || annotation.end <= pos) {
-            continue;
+    // Of the annotations containing pos, take the one starting last
+    auto it = std::upper_bound(positionIndex.begin(), positionIndex.end(), pos,
+    [this](size_t pos, int index) {
+        return pos < annotations[index].start;
+    });
+    int found = -1;
+    for (int i = int(it - positionIndex.begin()) - 1; i >= 0 && positionMaxEnd[i] > pos; i--) {
+        const CodeAnnotation &annotation = annotations[positionIndex[i]];
+        if (found >= 0 && annotation.start < annotations[found].start) {
+            break;
         }
-        if (closestPos != SIZE_MAX && closestPos >= annotation.start) {
-            continue;
+        if (annotation.end > pos) {
+            found = positionIndex[i];
         }
-        closestPos = annotation.start;
-        closestOffset = annotation.offset.offset;
     }
-    return closestOffset;
+    return found >= 0 ? annotations[found].offset.offset : UT64_MAX;
 }
 
 size_t AnnotatedCode::PositionForOffset(ut64 offset) const
 {
-    size_t closestPos = SIZE_MAX;
-    ut64 closestOffset = UT64_MAX;
-    for (const auto &annotation : annotations) {
-        if (annotation.type != CodeAnnotation::Type::Offset || annotation.offset.offset > offset) {
-            continue;
-        }
-        if (closestOffset != UT64_MAX && closestOffset >= annotation.offset.offset) {
-            continue;
-        }
-        closestPos = annotation.start;
-        closestOffset = annotation.offset.offset;
+    // Take the first annotation with the largest offset not above the given one
+    auto it = std::upper_bound(offsetIndex.begin(), offsetIndex.end(), offset,
+    [this](ut64 offset, int index) {
+        return offset < annotations[index].offset.offset;
+    });
+    if (it == offsetIndex.begin()) {
+        return SIZE_MAX;
     }
-    return closestPos;
+    ut64 closestOffset = annotations[*(it - 1)].offset.offset;
+    it = std::lower_bound(offsetIndex.begin(), it, closestOffset,
+    [this](int index, ut64 offset) {
+        return annotations[index].offset.offset < offset;
+    });
+    return annotations[*it].start;
 }
 
 
@@ -46,6 +84,107 @@ Decompiler::Decompiler(const QString &id, const QString &name, QObject *parent)
     id(id),
     name(name)
 {
+    cache.setMaxCost(MAX_CACHED_FUNCTIONS);
+    connect(this, &Decompiler::finished, this, &Decompiler::queuedDecompilationFinished);
+}
+
+void Decompiler::updateCacheRevision()
+{
+    quint64 revision = Core()->getAnalysisRevision();
+    if (revision != cacheRevision) {
+        cache.clear();
+        cacheRevision = revision;
+    }
+}
+
+void Decompiler::requestFunction(RVA fcnAddr)
+{
+    updateCacheRevision();
+    if (AnnotatedCode *code = cache.object(fcnAddr)) {
+        emit functionDecompiled(fcnAddr, *code);
+        return;
+    }
+    if (fcnAddr == runningAddr && runningRevision == cacheRevision && !runningPreempted) {
+        // Already on its way
+        return;
+    }
+    prefetchQueue.removeAll(fcnAddr);
+    // The latest request is the one somebody is looking at
+    requestQueue.removeAll(fcnAddr);
+    requestQueue.prepend(fcnAddr);
+
+    if (runningAddr != RVA_INVALID && runningPrefetch && !runningPreempted && isCancelable()) {
+        // Prefetched again later, unless it gets replaced by then
+        runningPreempted = true;
+        prefetchQueue.prepend(runningAddr);
+        cancel();
+        return;
+    }
+    startNext();
+}
+
+void Decompiler::prefetchFunctions(const QList<RVA> &fcnAddrs)
+{
+    updateCacheRevision();
+    prefetchQueue.clear();
+    for (RVA fcnAddr : fcnAddrs) {
+        if (fcnAddr == runningAddr || cache.contains(fcnAddr) || requestQueue.contains(fcnAddr)
+                || prefetchQueue.contains(fcnAddr)) {
+            continue;
+        }
+        prefetchQueue.append(fcnAddr);
+    }
+    startNext();
+}
+
+void Decompiler::startNext()
+{
+    if (runningAddr != RVA_INVALID || isRunning()) {
+        return;
+    }
+    updateCacheRevision();
+    while (!requestQueue.isEmpty() || !prefetchQueue.isEmpty()) {
+        bool prefetch = requestQueue.isEmpty();
+        RVA fcnAddr = prefetch ? prefetchQueue.takeFirst() : requestQueue.takeFirst();
+        if (cache.contains(fcnAddr)) {
+            continue;
+        }
+        runningAddr = fcnAddr;
+        runningRevision = cacheRevision;
+        runningPrefetch = prefetch;
+        runningPreempted = false;
+        decompileAt(fcnAddr);
+        return;
+    }
+}
+
+void Decompiler::queuedDecompilationFinished(const AnnotatedCode &code)
+{
+    RVA fcnAddr = runningAddr;
+    if (fcnAddr == RVA_INVALID) {
+        // decompileAt() was called directly
+        return;
+    }
+    runningAddr = RVA_INVALID;
+
+    if (runningPreempted) {
+        runningPreempted = false;
+    } else {
+        // Results that were computed while the analysis changed are passed on, but not kept.
+        // Neither are errors, which come as text without any offsets.
+        AnnotatedCode indexedCode = code;
+        indexedCode.BuildIndex();
+        updateCacheRevision();
+        if (runningRevision == cacheRevision && !code.annotations.isEmpty()) {
+            cache.insert(fcnAddr, new AnnotatedCode(indexedCode));
+        }
+        emit functionDecompiled(fcnAddr, indexedCode);
+    }
+
+    // Implementations may only be ready for the next function once they returned
+    QTimer::singleShot(0, this, [this]() {
+        startNext();
+    });
 }
 
 R2DecDecompiler::R2DecDecompiler(QObject *parent)
@@ -115,3 +254,10 @@ void R2DecDecompiler::decompileAt(RVA addr)
     });
     task->startTask();
 }
+
+void R2DecDecompiler::cancel()
+{
+    if (task) {
+        task->breakTask();
+    }
+}
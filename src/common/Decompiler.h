@@ -6,6 +6,8 @@
 
 #include <QString>
 #include <QObject>
+#include <QCache>
+#include <QVector>
 
 struct CodeAnnotation
 {
@@ -36,8 +38,28 @@ struct AnnotatedCode
 
     QList<CodeAnnotation> annotations;
 
+    /**
+     * Sort the offset annotations for OffsetForPosition() and PositionForOffset().
+     * Must be called again after annotations was modified.
+     */
+    void BuildIndex();
+
     ut64 OffsetForPosition(size_t pos) const;
     size_t PositionForOffset(ut64 offset) const;
+
+private:
+    /**
+     * Indices into annotations of the offset annotations, sorted by start
+     */
+    QVector<int> positionIndex;
+    /**
+     * Largest end of positionIndex[0..i]
+     */
+    QVector<size_t> positionMaxEnd;
+    /**
+     * Indices into annotations of the offset annotations, sorted by offset
+     */
+    QVector<int> offsetIndex;
 };
 
 /**
@@ -51,6 +73,30 @@ private:
     const QString id;
     const QString name;
 
+    /**
+     * Decompiled functions by address, valid for cacheRevision of the analysis
+     */
+    QCache<RVA, AnnotatedCode> cache;
+    quint64 cacheRevision = 0;
+
+    /**
+     * Functions waiting for decompileAt(), requested ones go before prefetched ones
+     */
+    QList<RVA> requestQueue;
+    QList<RVA> prefetchQueue;
+
+    RVA runningAddr = RVA_INVALID;
+    quint64 runningRevision = 0;
+    bool runningPrefetch = false;
+    /**
+     * The running prefetch was canceled for a requested function, its result is dropped
+     */
+    bool runningPreempted = false;
+
+    void updateCacheRevision();
+    void startNext();
+    void queuedDecompilationFinished(const AnnotatedCode &code);
+
 public:
     Decompiler(const QString &id, const QString &name, QObject *parent = nullptr);
     virtual ~Decompiler() = default;
@@ -61,10 +107,35 @@ public:
     virtual bool isCancelable() { return false; }
 
     virtual void decompileAt(RVA addr) =0;
+    /**
+     * @brief Stop the running decompileAt() early, finished() must still be emitted
+     */
     virtual void cancel() {}
 
+    /**
+     * @brief Decompile the function starting at fcnAddr, or take it from the cache.
+     * The result is delivered through functionDecompiled(), which may happen before this returns.
+     * A running prefetch is canceled first if the decompiler is cancelable.
+     * Results without any offset annotation are taken as errors and not cached.
+     */
+    void requestFunction(RVA fcnAddr);
+
+    /**
+     * @brief Decompile the given functions in the background, once no requested function is left.
+     * Replaces the functions passed to the previous call that were not decompiled yet.
+     */
+    void prefetchFunctions(const QList<RVA> &fcnAddrs);
+
 signals:
+    /**
+     * Emitted by implementations when decompileAt() is done
+     */
     void finished(AnnotatedCode code);
+
+    /**
+     * Emitted for every function decompiled through requestFunction() or prefetchFunctions()
+     */
+    void functionDecompiled(RVA fcnAddr, AnnotatedCode code);
 };
 
 class R2DecDecompiler: public Decompiler
@@ -77,8 +148,10 @@ private:
 public:
     explicit R2DecDecompiler(QObject *parent = nullptr);
     void decompileAt(RVA addr) override;
+    void cancel() override;
 
     bool isRunning() override    { return task != nullptr; }
+    bool isCancelable() override { return true; }
 
     static bool isAvailable();
 };
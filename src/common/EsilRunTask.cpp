@@ -0,0 +1,77 @@
+#include "EsilRunTask.h"
+#include "common/Configuration.h"
+#include "core/Cutter.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * Longest time the core lock is held at once
+ */
+static const int MAX_LOCK_MS = 20;
+
+/**
+ * Steps between checks for interruption and the lock time
+ */
+static const quint64 STEPS_PER_CHECK = 1024;
+
+EsilRunTask::EsilRunTask(EsilRunner *runner, RVA until, quint64 maxSteps)
+    : runner(runner),
+      until(until),
+      maxSteps(maxSteps ? maxSteps : std::numeric_limits<quint64>::max()),
+      analysisRevision(Core()->getAnalysisRevision()),
+      updateIntervalMs(1000 / std::max(1, Config()->getDebugRefreshRate()))
+{
+}
+
+EsilRunState EsilRunTask::getState()
+{
+    QMutexLocker locker(&stateMutex);
+    return state;
+}
+
+void EsilRunTask::runTask()
+{
+    EsilRunState current;
+    QElapsedTimer updateTimer;
+    updateTimer.start();
+    while (current.stopReason == EsilRunState::Running) {
+        bool publish;
+        {
+            RCoreLocked core = Core()->core();
+            QElapsedTimer lockTimer;
+            lockTimer.start();
+            while (current.stopReason == EsilRunState::Running && lockTimer.elapsed() < MAX_LOCK_MS) {
+                if (isInterrupted()) {
+                    current.stopReason = EsilRunState::Interrupted;
+                } else if (current.steps >= maxSteps) {
+                    current.stopReason = EsilRunState::StepLimit;
+                } else {
+                    runner->run(core, analysisRevision, std::min(STEPS_PER_CHECK, maxSteps - current.steps),
+                                until, &current);
+                }
+            }
+            // Reading all registers is only worth it when they are shown
+            publish = current.stopReason != EsilRunState::Running
+                      || updateTimer.elapsed() >= updateIntervalMs;
+            if (publish) {
+                runner->readRegisters(core, &current);
+            }
+        }
+
+        if (publish) {
+            {
+                QMutexLocker locker(&stateMutex);
+                state = current;
+            }
+            if (current.stopReason == EsilRunState::Running) {
+                emit stateUpdated();
+                updateTimer.restart();
+            }
+        }
+    }
+    log(tr("Emulated %1 instructions").arg(current.steps));
+}
@@ -0,0 +1,55 @@
+#ifndef ESILRUNTASK_H
+#define ESILRUNTASK_H
+
+#include "common/AsyncTask.h"
+#include "common/EsilRunner.h"
+
+#include <QMutex>
+
+/**
+ * @brief Emulates with an EsilRunner until a breakpoint, an address or a number of steps.
+ *
+ * The core lock is held for a few milliseconds at a time, so the UI stays responsive while
+ * millions of instructions are emulated.
+ */
+class EsilRunTask : public AsyncTask
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param until stop once the program counter is there, RVA_INVALID for no such address
+     * @param maxSteps stop after this many instructions, 0 for no limit
+     */
+    EsilRunTask(EsilRunner *runner, RVA until, quint64 maxSteps);
+
+    QString getTitle() override                     { return tr("Emulating"); }
+
+    /**
+     * @brief Progress as of the last stateUpdated() while running, the final state once
+     * finished
+     */
+    EsilRunState getState();
+
+signals:
+    /**
+     * @brief Emitted from the task's thread while running, with the registers read again, at
+     * most Configuration::getDebugRefreshRate() times a second
+     */
+    void stateUpdated();
+
+protected:
+    void runTask() override;
+
+private:
+    EsilRunner *runner;
+    RVA until;
+    quint64 maxSteps;
+    quint64 analysisRevision;
+    int updateIntervalMs;
+
+    QMutex stateMutex;
+    EsilRunState state;
+};
+
+#endif // ESILRUNTASK_H
@@ -0,0 +1,221 @@
+#include "EsilRunner.h"
+
+#include <algorithm>
+
+/**
+ * Bytes read to decode an instruction, more than any architecture needs
+ */
+static const int MAX_INSTRUCTION_SIZE = 32;
+
+/**
+ * Decoded instructions kept before the cache starts over
+ */
+static const int MAX_INSTRUCTIONS = 0x40000;
+
+/**
+ * Runner whose instructions are invalidated by memoryWritten(), set while attached
+ */
+static EsilRunner *attachedRunner = nullptr;
+static int (*previousMemoryWriteHook)(RAnalEsil *esil, ut64 addr, const ut8 *buf, int len) = nullptr;
+
+int EsilRunner::memoryWritten(RAnalEsil *esil, ut64 addr, const ut8 *buf, int len)
+{
+    if (attachedRunner && len > 0) {
+        attachedRunner->invalidate(addr, len);
+        for (const QPair<RVA, RVA> &range : attachedRunner->codeRanges) {
+            if (addr < range.second && addr + static_cast<RVA>(len) > range.first) {
+                attachedRunner->codeWritten = true;
+                break;
+            }
+        }
+    }
+    return previousMemoryWriteHook ? previousMemoryWriteHook(esil, addr, buf, len) : 0;
+}
+
+void EsilRunner::attach(RCore *core)
+{
+    RAnalEsil *esil = core->anal->esil;
+    if (!esil || esil->cb.hook_mem_write == memoryWritten) {
+        return;
+    }
+    previousMemoryWriteHook = esil->cb.hook_mem_write;
+    esil->cb.hook_mem_write = memoryWritten;
+    attachedRunner = this;
+
+    // Whatever the previous VM wrote was not seen
+    clear();
+    codeWritten = true;
+    codeRanges.clear();
+    RListIter *it;
+    RBinSection *section;
+    CutterRListForeach(r_bin_get_sections(core->bin), it, RBinSection, section) {
+        if (section->perm & R_PERM_X) {
+            codeRanges << qMakePair(section->vaddr, section->vaddr + section->vsize);
+        }
+    }
+}
+
+void EsilRunner::detach(RCore *core)
+{
+    RAnalEsil *esil = core->anal->esil;
+    if (esil && esil->cb.hook_mem_write == memoryWritten) {
+        esil->cb.hook_mem_write = previousMemoryWriteHook;
+    }
+    previousMemoryWriteHook = nullptr;
+    attachedRunner = nullptr;
+    codeWritten = false;
+    clear();
+}
+
+bool EsilRunner::takeCodeWritten()
+{
+    bool written = codeWritten;
+    codeWritten = false;
+    return written;
+}
+
+void EsilRunner::clear()
+{
+    instructions.clear();
+    instructionsBegin = RVA_MAX;
+    instructionsEnd = 0;
+}
+
+void EsilRunner::invalidate(RVA addr, int size)
+{
+    // Instructions starting before addr may still reach into it
+    RVA from = std::max(addr > MAX_INSTRUCTION_SIZE ? addr - MAX_INSTRUCTION_SIZE : 0,
+                        instructionsBegin);
+    RVA to = std::min(addr + static_cast<RVA>(size), instructionsEnd);
+    if (from >= to) {
+        return;
+    }
+    if (to - from > static_cast<RVA>(instructions.size())) {
+        for (auto it = instructions.begin(); it != instructions.end();) {
+            if (it.key() >= from && it.key() < to) {
+                it = instructions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return;
+    }
+    for (RVA a = from; a < to; a++) {
+        instructions.remove(a);
+    }
+}
+
+const EsilRunner::Instruction &EsilRunner::decode(RCore *core, RVA addr)
+{
+    auto it = instructions.constFind(addr);
+    if (it != instructions.constEnd()) {
+        return it.value();
+    }
+    if (instructions.size() >= MAX_INSTRUCTIONS) {
+        clear();
+    }
+
+    ut8 buf[MAX_INSTRUCTION_SIZE];
+    r_io_read_at(core->io, addr, buf, sizeof(buf));
+    RAnalOp op = {};
+    r_anal_op(core->anal, &op, addr, buf, sizeof(buf), R_ANAL_OP_MASK_ESIL);
+
+    Instruction instruction;
+    instruction.size = op.size;
+    instruction.invalid = op.size <= 0 || op.type == R_ANAL_OP_TYPE_ILL;
+    instruction.fallback = op.delay > 0;
+    instruction.esil = QByteArray(r_strbuf_get(&op.esil));
+    r_anal_op_fini(&op);
+
+    // Hints may override the size or the ESIL of the instruction
+    RAnalHint *hint = r_anal_hint_get(core->anal, addr);
+    if (hint) {
+        instruction.fallback = true;
+        r_anal_hint_free(hint);
+    }
+
+    instructionsBegin = std::min(instructionsBegin, addr);
+    instructionsEnd = std::max(instructionsEnd, addr + std::max(instruction.size, 1));
+    return instructions.insert(addr, instruction).value();
+}
+
+void EsilRunner::run(RCore *core, quint64 analysisRevision, quint64 steps, RVA until,
+                     EsilRunState *state)
+{
+    if (analysisRevision != this->analysisRevision) {
+        clear();
+        this->analysisRevision = analysisRevision;
+    }
+
+    RAnalEsil *esil = core->anal->esil;
+    RReg *reg = core->anal->reg;
+    RRegItem *pcItem = r_reg_get(reg, r_reg_get_name(reg, R_REG_NAME_PC), -1);
+    if (!esil || !pcItem) {
+        state->stopReason = EsilRunState::NotInitialized;
+        return;
+    }
+    bool breakOnInvalid = r_config_get_i(core->config, "esil.breakoninvalid");
+    attach(core);
+
+    RVA pc = r_reg_get_value(reg, pcItem);
+    for (quint64 i = 0; i < steps; i++) {
+        const Instruction &instruction = decode(core, pc);
+        if (instruction.invalid && breakOnInvalid) {
+            state->stopReason = EsilRunState::InvalidInstruction;
+            break;
+        }
+        if (instruction.fallback) {
+            r_core_cmd0(core, "aes");
+        } else {
+            // Copied, the instruction may overwrite itself
+            QByteArray code = instruction.esil;
+            r_reg_set_value(reg, pcItem, pc + std::max(instruction.size, 1));
+            r_anal_esil_set_pc(esil, pc);
+            esil->trap = 0;
+            if (!code.isEmpty()) {
+                r_anal_esil_parse(esil, code.constData());
+                r_anal_esil_stack_free(esil);
+            }
+        }
+        state->steps++;
+        pc = r_reg_get_value(reg, pcItem);
+
+        if (esil->trap) {
+            state->stopReason = EsilRunState::Trap;
+            break;
+        }
+        if (pc == until) {
+            state->stopReason = EsilRunState::Until;
+            break;
+        }
+        RBreakpointItem *bp = r_bp_get_at(core->dbg->bp, pc);
+        if (bp && bp->enabled) {
+            state->stopReason = EsilRunState::Breakpoint;
+            break;
+        }
+    }
+
+    state->pc = pc;
+}
+
+void EsilRunner::readRegisters(RCore *core, EsilRunState *state)
+{
+    RReg *reg = core->anal->reg;
+    RRegItem *pcItem = r_reg_get(reg, r_reg_get_name(reg, R_REG_NAME_PC), -1);
+    state->registerNames.clear();
+    state->registerValues.clear();
+    if (!pcItem) {
+        return;
+    }
+    state->pc = r_reg_get_value(reg, pcItem);
+    RList *list = r_reg_get_list(reg, R_REG_TYPE_GPR);
+    RListIter *it;
+    RRegItem *item;
+    CutterRListForeach(list, it, RRegItem, item) {
+        if (item->size != pcItem->size) {
+            continue;
+        }
+        state->registerNames << QString::fromUtf8(item->name);
+        state->registerValues << r_reg_get_value(reg, item);
+    }
+}
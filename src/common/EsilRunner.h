@@ -0,0 +1,116 @@
+#ifndef ESILRUNNER_H
+#define ESILRUNNER_H
+
+#include "core/CutterCommon.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Outcome and registers of an emulation run
+ */
+struct EsilRunState {
+    enum StopReason {
+        Running,
+        Interrupted,
+        StepLimit,
+        Breakpoint,
+        Until,
+        InvalidInstruction,
+        Trap,
+        /**
+         * The ESIL VM is not initialized
+         */
+        NotInitialized
+    };
+
+    StopReason stopReason = Running;
+    quint64 steps = 0;
+    RVA pc = RVA_INVALID;
+
+    /**
+     * General purpose registers as wide as the program counter, as in "arj"
+     */
+    QStringList registerNames;
+    QVector<ut64> registerValues;
+};
+
+/**
+ * @brief Runs the ESIL VM directly, without going through "aes" for every instruction.
+ *
+ * Instructions are decoded to ESIL once and kept by address, so loops only pay for evaluating
+ * their ESIL. The cache is dropped when the analysis revision changes. While attached, every
+ * memory write of the ESIL VM, including those of "aes" and friends, decodes the written
+ * instructions again, so self-modifying code such as unpacker stubs is emulated correctly.
+ * Anything else writing memory, like "wx" or restoring a trace state, must call clear()
+ * afterwards.
+ *
+ * Instructions with analysis hints or delay slots are left to "aes", which knows how to
+ * handle them.
+ *
+ * Must only be used with the core locked.
+ */
+class EsilRunner
+{
+public:
+    /**
+     * @brief Emulate at most steps instructions, stopping early at a breakpoint, at until or
+     * at an invalid instruction.
+     * @param state steps is increased, pc and stopReason are set if stopped early
+     */
+    void run(RCore *core, quint64 analysisRevision, quint64 steps, RVA until,
+             EsilRunState *state);
+
+    void readRegisters(RCore *core, EsilRunState *state);
+
+    /**
+     * @brief Forget all decoded instructions
+     */
+    void clear();
+
+    /**
+     * @brief Watch the memory written by the ESIL VM until detach().
+     *
+     * Does nothing if the VM is already watched, so it can be called again whenever "aei" may
+     * have created a new one.
+     */
+    void attach(RCore *core);
+    void detach(RCore *core);
+
+    /**
+     * @brief Whether the ESIL VM wrote into an executable section since the last call
+     */
+    bool takeCodeWritten();
+
+private:
+    struct Instruction {
+        int size;
+        bool invalid;
+        /**
+         * Executed with "aes" instead
+         */
+        bool fallback;
+        QByteArray esil;
+    };
+
+    QHash<RVA, Instruction> instructions;
+    RVA instructionsBegin = RVA_MAX;
+    RVA instructionsEnd = 0;
+    quint64 analysisRevision = 0;
+
+    /**
+     * Executable sections as [begin, end), taken when attached
+     */
+    QVector<QPair<RVA, RVA>> codeRanges;
+    bool codeWritten = false;
+
+    const Instruction &decode(RCore *core, RVA addr);
+    void invalidate(RVA addr, int size);
+
+    static int memoryWritten(RAnalEsil *esil, ut64 addr, const ut8 *buf, int len);
+};
+
+#endif // ESILRUNNER_H
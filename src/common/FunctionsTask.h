@@ -18,7 +18,8 @@ signals:
 protected:
     void runTask() override
     {
-        auto functions = Core()->getAllFunctions();
+        // arguments, locals and edges are loaded by the model for displayed rows only
+        auto functions = Core()->getAllFunctions(false);
         emit fetchFinished(functions);
     }
 };
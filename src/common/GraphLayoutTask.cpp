@@ -0,0 +1,16 @@
+#include "GraphLayoutTask.h"
+
+GraphLayoutTask::GraphLayoutTask(std::shared_ptr<GraphLayout> layout,
+                                 const GraphLayout::Graph &blocks, ut64 entry)
+    : layout(layout),
+      blocks(blocks),
+      entry(entry)
+{
+}
+
+void GraphLayoutTask::runTask()
+{
+    layout->CalculateLayoutInterruptible(blocks, entry, width, height, [this]() {
+        return isInterrupted();
+    });
+}
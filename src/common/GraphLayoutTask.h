@@ -0,0 +1,40 @@
+#ifndef GRAPHLAYOUTTASK_H
+#define GRAPHLAYOUTTASK_H
+
+#include "common/AsyncTask.h"
+#include "widgets/GraphLayout.h"
+
+#include <memory>
+
+/**
+ * @brief Runs a GraphLayout on a copy of the graph, so big graphs don't block the UI.
+ */
+class GraphLayoutTask : public AsyncTask
+{
+    Q_OBJECT
+
+public:
+    GraphLayoutTask(std::shared_ptr<GraphLayout> layout, const GraphLayout::Graph &blocks,
+                    ut64 entry);
+
+    QString getTitle() override                     { return tr("Computing graph layout"); }
+
+    /**
+     * @brief Blocks with the computed positions and edges, valid after the task finished
+     */
+    GraphLayout::Graph &getBlocks()                 { return blocks; }
+    int getWidth() const                            { return width; }
+    int getHeight() const                           { return height; }
+
+protected:
+    void runTask() override;
+
+private:
+    std::shared_ptr<GraphLayout> layout;
+    GraphLayout::Graph blocks;
+    ut64 entry;
+    int width = 0;
+    int height = 0;
+};
+
+#endif // GRAPHLAYOUTTASK_H
@@ -0,0 +1,108 @@
+#include "HashTask.h"
+
+#include <QCryptographicHash>
+
+#include <array>
+#include <cmath>
+
+namespace {
+
+/**
+ * Bytes read and hashed per core lock
+ */
+const int CHUNK_SIZE = 1024 * 1024;
+
+/**
+ * @brief CRC-32 (ISO-HDLC), the one "ph crc32" prints
+ */
+class Crc32
+{
+public:
+    Crc32()
+    {
+        for (ut32 i = 0; i < 256; i++) {
+            ut32 c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+    }
+
+    void addData(const ut8 *buf, int len)
+    {
+        for (int i = 0; i < len; i++) {
+            crc = table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+        }
+    }
+
+    ut32 result() const             { return crc ^ 0xffffffffu; }
+
+private:
+    std::array<ut32, 256> table;
+    ut32 crc = 0xffffffffu;
+};
+
+}
+
+HashTask::HashTask(RVA addr, ut64 size)
+    : addr(addr),
+      size(size)
+{
+    // Debugger io has to be read from the thread that owns the debuggee
+    if (Core()->currentlyDebugging) {
+        data = Core()->ioRead(addr, static_cast<int>(size));
+        prefetched = true;
+    }
+}
+
+QByteArray HashTask::readChunk(ut64 offset, int len)
+{
+    if (prefetched) {
+        return data.mid(static_cast<int>(offset), len);
+    }
+    return Core()->ioRead(addr + offset, len);
+}
+
+void HashTask::runTask()
+{
+    QCryptographicHash md5(QCryptographicHash::Md5);
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    QCryptographicHash sha256(QCryptographicHash::Sha256);
+    Crc32 crc32;
+    std::array<ut64, 256> histogram = {};
+
+    for (ut64 offset = 0; offset < size; offset += CHUNK_SIZE) {
+        if (isInterrupted()) {
+            return;
+        }
+        int len = static_cast<int>(std::min<ut64>(CHUNK_SIZE, size - offset));
+        QByteArray chunk = readChunk(offset, len);
+        const ut8 *buf = reinterpret_cast<const ut8 *>(chunk.constData());
+
+        md5.addData(chunk);
+        sha1.addData(chunk);
+        sha256.addData(chunk);
+        crc32.addData(buf, chunk.size());
+        for (int i = 0; i < chunk.size(); i++) {
+            histogram[buf[i]]++;
+        }
+
+        emit progress(static_cast<int>((offset + static_cast<ut64>(len)) * 100 / size));
+    }
+
+    // Shannon entropy in bits per byte, like r_hash_entropy()
+    double entropy = 0.0;
+    for (ut64 count : histogram) {
+        if (count) {
+            double p = static_cast<double>(count) / static_cast<double>(size);
+            entropy -= p * std::log2(p);
+        }
+    }
+
+    result.md5 = QString::fromLatin1(md5.result().toHex());
+    result.sha1 = QString::fromLatin1(sha1.result().toHex());
+    result.sha256 = QString::fromLatin1(sha256.result().toHex());
+    result.crc32 = QString("%1").arg(crc32.result(), 8, 16, QLatin1Char('0'));
+    result.entropy = QString::number(entropy, 'f', 6);
+}
@@ -0,0 +1,60 @@
+#ifndef HASHTASK_H
+#define HASHTASK_H
+
+#include "common/AsyncTask.h"
+#include "core/Cutter.h"
+
+#include <QByteArray>
+
+/**
+ * @brief Computes MD5, SHA1, SHA256, CRC32 and the entropy of a memory range in one pass.
+ *
+ * The range is read in chunks, each under a short core lock, and fed to all digests at once.
+ */
+class HashTask : public AsyncTask
+{
+    Q_OBJECT
+
+public:
+    struct Result {
+        QString md5;
+        QString sha1;
+        QString sha256;
+        QString crc32;
+        QString entropy;
+    };
+
+    HashTask(RVA addr, ut64 size);
+
+    QString getTitle() override                     { return tr("Hashing"); }
+
+    /**
+     * @brief Digests of the range, valid after the task finished without being interrupted
+     */
+    const Result &getResult() const                 { return result; }
+
+signals:
+    /**
+     * @brief Percentage of the range hashed so far
+     */
+    void progress(int percent);
+
+protected:
+    void runTask() override;
+
+private:
+    RVA addr;
+    ut64 size;
+
+    /**
+     * @brief Bytes read up front, when the range can't be read from the task's thread
+     */
+    QByteArray data;
+    bool prefetched = false;
+
+    Result result;
+
+    QByteArray readChunk(ut64 offset, int len);
+};
+
+#endif // HASHTASK_H
@@ -14,6 +14,8 @@
 #include <QDockWidget>
 #include <QMenu>
 #include <QComboBox>
+#include <QCursor>
+#include <QToolTip>
 
 static QAbstractItemView::ScrollMode scrollMode()
 {
@@ -269,5 +271,21 @@ void selectIndexByData(QComboBox *widget, QVariant data, int defaultIndex)
     widget->setCurrentIndex(defaultIndex);
 }
 
+void showPendingToolTip(QAbstractItemView *itemView)
+{
+    QWidget *viewport = itemView->viewport();
+    if (QToolTip::isVisible() || !viewport->underMouse() || !viewport->isActiveWindow()) {
+        return;
+    }
+    QPoint pos = viewport->mapFromGlobal(QCursor::pos());
+    QModelIndex index = itemView->indexAt(pos);
+    if (!index.isValid()) {
+        return;
+    }
+    QString toolTip = index.data(Qt::ToolTipRole).toString();
+    if (!toolTip.isEmpty()) {
+        QToolTip::showText(QCursor::pos(), toolTip, viewport, itemView->visualRect(index));
+    }
+}
 
 } // end namespace
@@ -64,6 +64,12 @@ qreal devicePixelRatio(const QPaintDevice *p);
  */
 void selectIndexByData(QComboBox *comboBox, QVariant data, int defaultIndex = -1);
 
+/**
+ * @brief Show the tooltip of the item under the mouse, for models that fill in tooltips
+ * asynchronously and had none yet when the view asked for it.
+ */
+void showPendingToolTip(QAbstractItemView *itemView);
+
 } // qhelpers
 
 #endif // HELPERS_H
@@ -0,0 +1,127 @@
+#include "IOPageCache.h"
+#include "core/Cutter.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include <algorithm>
+
+/**
+ * Number of pages kept, 16 MiB
+ */
+static const int MAX_CACHED_PAGES = 4096;
+
+/**
+ * Upper bound for a single prefetch request
+ */
+static const ut64 MAX_PREFETCH_PAGES = 64;
+
+class IOPagePrefetchRunnable : public QRunnable
+{
+public:
+    IOPagePrefetchRunnable(IOPageCache *cache, const QList<RVA> &pageAddrs, quint64 generation)
+        : cache(cache), pageAddrs(pageAddrs), generation(generation)
+    {
+    }
+
+    void run() override
+    {
+        for (RVA pageAddr : pageAddrs) {
+            {
+                QMutexLocker locker(&cache->mutex);
+                if (cache->generation != generation) {
+                    return;
+                }
+            }
+            QByteArray data = Core()->ioRead(pageAddr, static_cast<int>(IOPageCache::PAGE_BYTES));
+            cache->insertPage(pageAddr, data, generation);
+        }
+    }
+
+private:
+    IOPageCache *cache;
+    QList<RVA> pageAddrs;
+    quint64 generation;
+};
+
+IOPageCache::IOPageCache(QObject *parent)
+    : QObject(parent),
+      pages(MAX_CACHED_PAGES)
+{
+    // Pages are read one after another in the order they were requested
+    prefetchPool.setMaxThreadCount(1);
+
+    auto core = Core();
+    connect(core, &CutterCore::refreshAll, this, &IOPageCache::invalidate);
+    connect(core, &CutterCore::instructionChanged, this, &IOPageCache::invalidate);
+    connect(core, &CutterCore::stackChanged, this, &IOPageCache::invalidate);
+    connect(core, &CutterCore::registersChanged, this, &IOPageCache::invalidate);
+    connect(core, &CutterCore::codeRebased, this, &IOPageCache::invalidate);
+    connect(core, &CutterCore::debugTaskStateChanged, this, &IOPageCache::invalidate);
+}
+
+IOPageCache::~IOPageCache()
+{
+    invalidate();
+    prefetchPool.waitForDone();
+}
+
+QByteArray IOPageCache::page(RVA pageAddr)
+{
+    quint64 readGeneration;
+    {
+        QMutexLocker locker(&mutex);
+        if (QByteArray *data = pages.object(pageAddr)) {
+            return *data;
+        }
+        readGeneration = generation;
+    }
+    QByteArray data = Core()->ioRead(pageAddr, static_cast<int>(PAGE_BYTES));
+    insertPage(pageAddr, data, readGeneration);
+    return data;
+}
+
+void IOPageCache::prefetch(RVA addr, ut64 size)
+{
+    // ptrace based debuggers only allow the thread that attached to read process memory
+    if (Core()->currentlyDebugging) {
+        return;
+    }
+
+    RVA pageAddr = addr & ~(PAGE_BYTES - 1);
+    ut64 pageCount = std::min((addr - pageAddr + size + PAGE_BYTES - 1) / PAGE_BYTES,
+                              MAX_PREFETCH_PAGES);
+    QList<RVA> missing;
+    QMutexLocker locker(&mutex);
+    for (ut64 i = 0; i < pageCount; i++, pageAddr += PAGE_BYTES) {
+        if (!pages.contains(pageAddr) && !pendingPages.contains(pageAddr)) {
+            missing << pageAddr;
+            pendingPages.insert(pageAddr);
+        }
+        if (pageAddr > RVA_MAX - PAGE_BYTES) {
+            break;
+        }
+    }
+    if (!missing.isEmpty()) {
+        prefetchPool.start(new IOPagePrefetchRunnable(this, missing, generation));
+    }
+}
+
+void IOPageCache::invalidate()
+{
+    QMutexLocker locker(&mutex);
+    generation++;
+    pages.clear();
+    pendingPages.clear();
+}
+
+void IOPageCache::insertPage(RVA pageAddr, const QByteArray &data, quint64 readGeneration)
+{
+    QMutexLocker locker(&mutex);
+    if (readGeneration != generation) {
+        // memory may have changed while reading
+        return;
+    }
+    pendingPages.remove(pageAddr);
+    pages.insert(pageAddr, new QByteArray(data));
+}
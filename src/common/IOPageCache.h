@@ -0,0 +1,60 @@
+#ifndef IOPAGECACHE_H
+#define IOPAGECACHE_H
+
+#include "core/CutterCommon.h"
+
+#include <QObject>
+#include <QCache>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+
+/**
+ * @brief LRU cache of io pages shared by all views showing raw memory.
+ *
+ * Pages stay cached until memory is written, the debugged process may have changed it or
+ * a command was run through a CommandTask, as the console does.
+ * Pages that are likely to be shown next can be read on a worker thread with prefetch().
+ */
+class IOPageCache : public QObject
+{
+    Q_OBJECT
+
+    friend class IOPagePrefetchRunnable;
+
+public:
+    static const ut64 PAGE_BYTES = 0x1000;
+
+    explicit IOPageCache(QObject *parent = nullptr);
+    ~IOPageCache() override;
+
+    /**
+     * @brief Get the page at pageAddr, reading it if it is not cached
+     * @param pageAddr - address aligned to PAGE_BYTES
+     */
+    QByteArray page(RVA pageAddr);
+
+    /**
+     * @brief Read the pages overlapping [addr, addr + size) that are not cached yet
+     * in the background
+     */
+    void prefetch(RVA addr, ut64 size);
+
+public slots:
+    /**
+     * @brief Drop all pages, including those currently being prefetched
+     */
+    void invalidate();
+
+private:
+    void insertPage(RVA pageAddr, const QByteArray &data, quint64 readGeneration);
+
+    QMutex mutex;
+    QCache<RVA, QByteArray> pages;
+    QSet<RVA> pendingPages;
+    quint64 generation = 0;
+
+    QThreadPool prefetchPool;
+};
+
+#endif // IOPAGECACHE_H
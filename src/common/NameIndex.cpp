@@ -0,0 +1,193 @@
+#include "NameIndex.h"
+
+#include <QRegExp>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace {
+
+quint64 trigramKey(const QString &key, int pos)
+{
+    return (static_cast<quint64>(key.at(pos).unicode()) << 32)
+           | (static_cast<quint64>(key.at(pos + 1).unicode()) << 16)
+           | key.at(pos + 2).unicode();
+}
+
+/**
+ * @brief Key of the first one or two characters of a word, never equal to a trigram key
+ */
+quint64 wordStartKey(const QString &key, int pos, int length)
+{
+    quint64 ret = (Q_UINT64_C(1) << 63) | (static_cast<quint64>(length) << 48)
+                  | (static_cast<quint64>(key.at(pos).unicode()) << 16);
+    if (length > 1) {
+        ret |= key.at(pos + 1).unicode();
+    }
+    return ret;
+}
+
+bool isWordStart(const QString &key, int pos)
+{
+    return pos == 0 || (key.at(pos).isLetterOrNumber() && !key.at(pos - 1).isLetterOrNumber());
+}
+
+struct Match {
+    int score;
+    int entry;
+};
+
+}
+
+void NameIndex::add(const NameIndexEntry &entry)
+{
+    int index = entries.size();
+    entries.append(entry);
+    keys.append(entry.name.toLower());
+    removed.append(false);
+    entriesByName.insert(entry.name, index);
+    indexKey(index);
+}
+
+void NameIndex::remove(NameIndexEntry::Kind kind, RVA offset)
+{
+    for (int i = 0; i < entries.size(); i++) {
+        if (!removed[i] && entries[i].kind == kind && entries[i].offset == offset) {
+            removeEntry(i);
+        }
+    }
+}
+
+void NameIndex::rename(const QString &oldName, const QString &newName)
+{
+    // Re-added, so the posting lists of the new name stay sorted
+    for (int index : entriesByName.values(oldName)) {
+        NameIndexEntry entry = entries[index];
+        removeEntry(index);
+        entry.name = newName;
+        add(entry);
+    }
+}
+
+void NameIndex::removeEntry(int entry)
+{
+    removed[entry] = true;
+    removedCount++;
+    entriesByName.remove(entries[entry].name, entry);
+}
+
+void NameIndex::indexKey(int entry)
+{
+    const QString &key = keys[entry];
+    auto addPosting = [this, entry](quint64 gram) {
+        QVector<int> &list = postings[gram];
+        if (list.isEmpty() || list.last() != entry) {
+            list.append(entry);
+        }
+    };
+    for (int i = 0; i + 2 < key.size(); i++) {
+        addPosting(trigramKey(key, i));
+    }
+    for (int i = 0; i < key.size(); i++) {
+        if (isWordStart(key, i)) {
+            addPosting(wordStartKey(key, i, 1));
+            if (i + 1 < key.size()) {
+                addPosting(wordStartKey(key, i, 2));
+            }
+        }
+    }
+}
+
+const QVector<int> *NameIndex::postingsForToken(const QString &token) const
+{
+    if (token.size() < 3) {
+        auto it = postings.constFind(wordStartKey(token, 0, token.size()));
+        return it == postings.constEnd() ? nullptr : &it.value();
+    }
+    // The rarest trigram, every name containing token is in its list
+    const QVector<int> *ret = nullptr;
+    for (int i = 0; i + 2 < token.size(); i++) {
+        auto it = postings.constFind(trigramKey(token, i));
+        if (it == postings.constEnd()) {
+            return nullptr;
+        }
+        if (!ret || it.value().size() < ret->size()) {
+            ret = &it.value();
+        }
+    }
+    return ret;
+}
+
+QList<NameIndexEntry> NameIndex::search(const QString &query, int maxResults) const
+{
+    QList<NameIndexEntry> ret;
+    QStringList tokens = query.toLower().split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    if (tokens.isEmpty() || maxResults <= 0) {
+        return ret;
+    }
+
+    const QVector<int> *candidates = nullptr;
+    for (const QString &token : tokens) {
+        const QVector<int> *list = postingsForToken(token);
+        if (!list) {
+            return ret;
+        }
+        if (!candidates || list->size() < candidates->size()) {
+            candidates = list;
+        }
+    }
+
+    // Lower scores are better: exact name, then prefix, then word start, then anywhere
+    QVector<Match> matches;
+    for (int entry : *candidates) {
+        if (removed[entry]) {
+            continue;
+        }
+        const QString &key = keys[entry];
+        int score = 0;
+        for (const QString &token : tokens) {
+            int pos = key.indexOf(token);
+            while (pos > 0 && !isWordStart(key, pos)) {
+                int next = key.indexOf(token, pos + 1);
+                if (next < 0) {
+                    break;
+                }
+                pos = next;
+            }
+            if (pos < 0 || (token.size() < 3 && !isWordStart(key, pos))) {
+                score = -1;
+                break;
+            }
+            if (pos == 0) {
+                score += key.size() == token.size() ? 0 : 1;
+            } else {
+                score += isWordStart(key, pos) ? 2 : 3;
+            }
+        }
+        if (score >= 0) {
+            matches.append({ score, entry });
+        }
+    }
+
+    auto better = [this](const Match & a, const Match & b) {
+        if (a.score != b.score) {
+            return a.score < b.score;
+        }
+        const NameIndexEntry &entryA = entries[a.entry];
+        const NameIndexEntry &entryB = entries[b.entry];
+        if (entryA.kind != entryB.kind) {
+            return entryA.kind < entryB.kind;
+        }
+        if (entryA.name.size() != entryB.name.size()) {
+            return entryA.name.size() < entryB.name.size();
+        }
+        return a.entry < b.entry;
+    };
+    int count = std::min(maxResults, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), better);
+    ret.reserve(count);
+    for (int i = 0; i < count; i++) {
+        ret.append(entries[matches[i].entry]);
+    }
+    return ret;
+}
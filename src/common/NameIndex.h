@@ -0,0 +1,67 @@
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include "core/CutterCommon.h"
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Name of something that can be seeked to
+ */
+struct NameIndexEntry {
+    /**
+     * Ordered by how relevant a match is, among otherwise equal matches
+     */
+    enum Kind { Function, Symbol, ClassMethod, Flag, String };
+
+    QString name;
+    RVA offset;
+    Kind kind;
+};
+
+/**
+ * @brief Substring search over a large number of names, for the Omnibar.
+ *
+ * Every name is indexed by its lowercase trigrams and by the first one and two characters of its
+ * words (separated by '.', '_', ':' and similar), so a query only looks at names sharing all its
+ * trigrams. Queries are case insensitive. Whitespace separates words that must all match,
+ * which allows fuzzy queries like "imp print" for "sym.imp.printf".
+ *
+ * Entries can be added, removed and renamed in place. Removed entries stay in the posting lists
+ * until the index is built again.
+ */
+class NameIndex
+{
+public:
+    void add(const NameIndexEntry &entry);
+    void remove(NameIndexEntry::Kind kind, RVA offset);
+    void rename(const QString &oldName, const QString &newName);
+
+    int size() const                    { return entries.size() - removedCount; }
+
+    /**
+     * @return at most maxResults entries matching query, best matches first
+     */
+    QList<NameIndexEntry> search(const QString &query, int maxResults) const;
+
+private:
+    QVector<NameIndexEntry> entries;
+    QVector<QString> keys;
+    QVector<bool> removed;
+    int removedCount = 0;
+
+    /**
+     * Sorted entry indices by trigram or word start
+     */
+    QHash<quint64, QVector<int>> postings;
+    QMultiHash<QString, int> entriesByName;
+
+    void indexKey(int entry);
+    const QVector<int> *postingsForToken(const QString &token) const;
+    void removeEntry(int entry);
+};
+
+#endif // NAMEINDEX_H
@@ -0,0 +1,60 @@
+#include "NameIndexTask.h"
+#include "core/Cutter.h"
+
+#include <QPair>
+#include <QSet>
+
+void NameIndexTask::runTask()
+{
+    QSharedPointer<NameIndex> newIndex(new NameIndex());
+
+    // Functions and symbols usually have a flag of the same name, only the first one is kept
+    QSet<QPair<RVA, QString>> added;
+    auto add = [&](const QString &name, RVA offset, NameIndexEntry::Kind kind) {
+        if (name.isEmpty() || offset == RVA_INVALID) {
+            return;
+        }
+        QPair<RVA, QString> key(offset, name);
+        if (added.contains(key)) {
+            return;
+        }
+        added.insert(key);
+        newIndex->add({ name, offset, kind });
+    };
+
+    for (const FunctionDescription &function : Core()->getAllFunctions(false)) {
+        add(function.name, function.offset, NameIndexEntry::Function);
+    }
+    if (isInterrupted()) {
+        return;
+    }
+    for (const SymbolDescription &symbol : Core()->getAllSymbols()) {
+        add(symbol.name, symbol.vaddr, NameIndexEntry::Symbol);
+    }
+    if (isInterrupted()) {
+        return;
+    }
+    for (const BinClassDescription &cls : Core()->getAllClassesFromBin()) {
+        for (const BinClassMethodDescription &method : cls.methods) {
+            add(cls.name + "::" + method.name, method.addr, NameIndexEntry::ClassMethod);
+        }
+    }
+    if (isInterrupted()) {
+        return;
+    }
+    for (const FlagDescription &flag : Core()->getAllFlags()) {
+        add(flag.name, flag.offset, NameIndexEntry::Flag);
+    }
+    if (isInterrupted()) {
+        return;
+    }
+    for (const StringDescription &string : Core()->getAllStrings()) {
+        add(string.string, string.vaddr, NameIndexEntry::String);
+    }
+    if (isInterrupted()) {
+        return;
+    }
+
+    log(tr("Indexed %1 names").arg(newIndex->size()));
+    index = newIndex;
+}
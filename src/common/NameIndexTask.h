@@ -0,0 +1,31 @@
+#ifndef NAMEINDEXTASK_H
+#define NAMEINDEXTASK_H
+
+#include "common/AsyncTask.h"
+#include "common/NameIndex.h"
+
+#include <QSharedPointer>
+
+/**
+ * @brief Builds a NameIndex of all functions, symbols, class methods, flags and strings.
+ */
+class NameIndexTask : public AsyncTask
+{
+    Q_OBJECT
+
+public:
+    QString getTitle() override                     { return tr("Indexing Names"); }
+
+    /**
+     * @brief The index, valid after the task finished without being interrupted
+     */
+    QSharedPointer<NameIndex> getIndex() const      { return index; }
+
+protected:
+    void runTask() override;
+
+private:
+    QSharedPointer<NameIndex> index;
+};
+
+#endif // NAMEINDEXTASK_H
@@ -0,0 +1,154 @@
+#include "PreviewCache.h"
+#include "core/Cutter.h"
+#include "common/Configuration.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include <limits>
+
+/**
+ * Number of previews kept
+ */
+static const int MAX_PREVIEWS = 512;
+
+/**
+ * Requests waiting to be generated, older ones are dropped. About the rows of a list on screen,
+ * which are all requested when it is painted.
+ */
+static const int MAX_QUEUED_PREVIEWS = 64;
+
+/**
+ * Disassembly lines of a FunctionPreview
+ */
+static const int FUNCTION_PREVIEW_LINES = 10;
+
+class PreviewRunnable : public QRunnable
+{
+public:
+    PreviewRunnable(PreviewCache *owner, const PreviewCache::Key &key, quint64 generation)
+        : owner(owner), key(key), generation(generation)
+    {
+    }
+
+    const PreviewCache::Key &getKey() const     { return key; }
+
+    void run() override
+    {
+        owner->runnableStarted(this);
+        if (isCanceled()) {
+            return;
+        }
+        RVA address = key.second;
+        AddressPreview preview;
+        {
+            // Held across the whole preview, so the temporary config of
+            // getDisassemblyPreview() is never seen by other threads
+            RCoreLocked core = Core()->core();
+            switch (key.first) {
+            case PreviewCache::FunctionPreview:
+                preview.disassembly = Core()->getDisassemblyPreview(address, FUNCTION_PREVIEW_LINES);
+                preview.summary = Core()->cmdList(QString("pdsf @ %1").arg(address));
+                break;
+            case PreviewCache::InstructionPreview:
+                preview.disassembly << Core()->disassembleSingleInstruction(address);
+                break;
+            }
+        }
+        owner->insertPreview(key, preview, generation);
+    }
+
+private:
+    PreviewCache *owner;
+    PreviewCache::Key key;
+    quint64 generation;
+
+    bool isCanceled()
+    {
+        QMutexLocker locker(&owner->mutex);
+        return owner->generation != generation;
+    }
+};
+
+PreviewCache::PreviewCache(QObject *parent)
+    : QObject(parent),
+      previews(MAX_PREVIEWS)
+{
+    // Previews need the core lock anyway
+    pool.setMaxThreadCount(1);
+    connect(Config(), &Configuration::colorsUpdated, this, &PreviewCache::clear);
+    connect(Core(), &CutterCore::refreshAll, this, &PreviewCache::clear);
+}
+
+PreviewCache::~PreviewCache()
+{
+    clear();
+    pool.waitForDone();
+}
+
+bool PreviewCache::getPreview(PreviewType type, RVA address, AddressPreview *preview)
+{
+    quint64 revision = Core()->getAnalysisRevision();
+    if (revision != analysisRevision) {
+        clear();
+        analysisRevision = revision;
+    }
+
+    Key key(type, address);
+    QMutexLocker locker(&mutex);
+    AddressPreview *cached = previews.object(key);
+    if (cached) {
+        *preview = *cached;
+        return true;
+    }
+    if (!pendingPreviews.contains(key)) {
+        while (queuedRunnables.size() >= MAX_QUEUED_PREVIEWS) {
+            PreviewRunnable *oldest = queuedRunnables.takeFirst();
+            // Otherwise it just started, runnableStarted() waits for the mutex
+            if (pool.tryTake(oldest)) {
+                pendingPreviews.remove(oldest->getKey());
+                delete oldest;
+            }
+        }
+        pendingPreviews.insert(key);
+        if (requestPriority == std::numeric_limits<int>::max()) {
+            requestPriority = 0;
+        }
+        // newest requests first
+        auto runnable = new PreviewRunnable(this, key, generation);
+        queuedRunnables.append(runnable);
+        pool.start(runnable, ++requestPriority);
+    }
+    return false;
+}
+
+void PreviewCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    generation++;
+    previews.clear();
+    pendingPreviews.clear();
+    queuedRunnables.clear();
+    pool.clear();
+}
+
+void PreviewCache::runnableStarted(PreviewRunnable *runnable)
+{
+    QMutexLocker locker(&mutex);
+    queuedRunnables.removeOne(runnable);
+}
+
+void PreviewCache::insertPreview(const Key &key, const AddressPreview &preview,
+                                 quint64 requestGeneration)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (requestGeneration != generation) {
+            // The analysis changed meanwhile
+            return;
+        }
+        pendingPreviews.remove(key);
+        previews.insert(key, new AddressPreview(preview));
+    }
+    emit previewReady(key.first, key.second);
+}
@@ -0,0 +1,97 @@
+#ifndef PREVIEWCACHE_H
+#define PREVIEWCACHE_H
+
+#include "core/CutterCommon.h"
+
+#include <QObject>
+#include <QCache>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+
+/**
+ * @brief Disassembly shown for an address in tooltips and list columns
+ */
+struct AddressPreview {
+    /**
+     * Colored disassembly lines, or the single instruction of an InstructionPreview
+     */
+    QStringList disassembly;
+    /**
+     * Highlights (strings, calls, ...) of a FunctionPreview, as printed by "pdsf"
+     */
+    QStringList summary;
+};
+
+/**
+ * @brief Generates AddressPreviews on a worker thread and keeps the most recently used ones.
+ *
+ * Views ask for a preview while painting or showing a tooltip and get it right away if it is
+ * cached. Otherwise it is generated in the background and previewReady() is emitted, so they
+ * can update. The most recently requested previews are generated first, and only a few requests
+ * wait at a time, the oldest ones are dropped. So hovering across a long list does not queue up
+ * previews nobody looks at anymore. All previews are dropped once the analysis revision or the
+ * colors change.
+ */
+class PreviewCache : public QObject
+{
+    Q_OBJECT
+
+    friend class PreviewRunnable;
+
+public:
+    enum PreviewType {
+        /**
+         * First lines of a function and its highlights
+         */
+        FunctionPreview,
+        /**
+         * One instruction, as in "pi 1"
+         */
+        InstructionPreview
+    };
+
+    explicit PreviewCache(QObject *parent = nullptr);
+    ~PreviewCache() override;
+
+    /**
+     * @brief Get the preview of address if it is cached, otherwise start generating it and emit
+     * previewReady() once done.
+     * @return whether preview was filled
+     */
+    bool getPreview(PreviewType type, RVA address, AddressPreview *preview);
+
+signals:
+    /**
+     * @brief Emitted from the worker thread whenever a preview was added
+     * @param type PreviewType of the preview
+     */
+    void previewReady(int type, RVA address);
+
+public slots:
+    void clear();
+
+private:
+    using Key = QPair<int, RVA>;
+
+    void insertPreview(const Key &key, const AddressPreview &preview, quint64 requestGeneration);
+    void runnableStarted(PreviewRunnable *runnable);
+
+    QMutex mutex;
+    QCache<Key, AddressPreview> previews;
+    QSet<Key> pendingPreviews;
+    /**
+     * Runnables in the pool that did not start yet, oldest first
+     */
+    QList<PreviewRunnable *> queuedRunnables;
+    quint64 generation = 0;
+    quint64 analysisRevision = 0;
+    int requestPriority = 0;
+
+    QThreadPool pool;
+};
+
+#endif // PREVIEWCACHE_H
@@ -0,0 +1,172 @@
+#include "SectionStatistics.h"
+#include "core/Cutter.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef Q_OS_WIN
+#include <sys/stat.h>
+#endif
+
+/**
+ * Bytes read per core lock
+ */
+static const int CHUNK_SIZE = 4 * 1024 * 1024;
+
+/**
+ * Bytes from the start and the end of the file that identify it
+ */
+static const int FINGERPRINT_BYTES = 64 * 1024;
+
+class SectionStatisticsRunnable : public QRunnable
+{
+public:
+    SectionStatisticsRunnable(SectionStatistics *owner, ut64 paddr, ut64 size, quint64 generation)
+        : owner(owner), paddr(paddr), size(size), generation(generation)
+    {
+    }
+
+    void run() override
+    {
+        QCryptographicHash md5(QCryptographicHash::Md5);
+        QCryptographicHash sha256(QCryptographicHash::Sha256);
+        FileRangeStatistics statistics;
+        statistics.histogram.fill(0, 256);
+        ut64 total = 0;
+
+        for (ut64 offset = 0; offset < size; offset += CHUNK_SIZE) {
+            if (isCanceled()) {
+                return;
+            }
+            int len = static_cast<int>(std::min<ut64>(CHUNK_SIZE, size - offset));
+            QByteArray chunk = Core()->binFileRead(paddr + offset, len);
+            if (chunk.isEmpty()) {
+                break;
+            }
+            md5.addData(chunk);
+            sha256.addData(chunk);
+            const ut8 *buf = reinterpret_cast<const ut8 *>(chunk.constData());
+            for (int i = 0; i < chunk.size(); i++) {
+                statistics.histogram[buf[i]]++;
+            }
+            total += static_cast<ut64>(chunk.size());
+        }
+
+        for (ut64 count : statistics.histogram) {
+            if (count) {
+                double p = static_cast<double>(count) / static_cast<double>(total);
+                statistics.entropy -= p * std::log2(p);
+            }
+        }
+        statistics.md5 = QString::fromLatin1(md5.result().toHex());
+        statistics.sha256 = QString::fromLatin1(sha256.result().toHex());
+        owner->insertStatistics({ paddr, size }, statistics, generation);
+    }
+
+private:
+    SectionStatistics *owner;
+    ut64 paddr;
+    ut64 size;
+    quint64 generation;
+
+    bool isCanceled()
+    {
+        QMutexLocker locker(&owner->mutex);
+        return owner->generation != generation;
+    }
+};
+
+SectionStatistics::SectionStatistics(QObject *parent)
+    : QObject(parent)
+{
+    connect(Core(), &CutterCore::refreshAll, this, &SectionStatistics::checkFile);
+}
+
+SectionStatistics::~SectionStatistics()
+{
+    {
+        QMutexLocker locker(&mutex);
+        generation++;
+    }
+    pool.waitForDone();
+}
+
+bool SectionStatistics::getStatistics(ut64 paddr, ut64 size, FileRangeStatistics *statistics)
+{
+    if (size == 0) {
+        return false;
+    }
+    Range range(paddr, size);
+    QMutexLocker locker(&mutex);
+    auto it = statisticsCache.constFind(range);
+    if (it != statisticsCache.constEnd()) {
+        *statistics = it.value();
+        return true;
+    }
+    if (!pendingRanges.contains(range)) {
+        pendingRanges.insert(range);
+        pool.start(new SectionStatisticsRunnable(this, paddr, size, generation));
+    }
+    return false;
+}
+
+void SectionStatistics::checkFile()
+{
+    QByteArray newFingerprint = fileFingerprint();
+    QMutexLocker locker(&mutex);
+    if (newFingerprint == fingerprint) {
+        return;
+    }
+    fingerprint = newFingerprint;
+    generation++;
+    statisticsCache.clear();
+    pendingRanges.clear();
+}
+
+QByteArray SectionStatistics::fileFingerprint()
+{
+    // Hashing the whole file would cost as much as the statistics themselves. A file that was
+    // rewritten or replaced has another modification time or inode, even if its size, header
+    // and padding stayed the same.
+    ut64 fileSize = Core()->binFileSize();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(fileSize));
+    QString path = Core()->getConfig("file.path");
+    hash.addData(path.toUtf8());
+    hash.addData(QByteArray::number(QFileInfo(path).lastModified().toMSecsSinceEpoch()));
+#ifndef Q_OS_WIN
+    struct stat fileStat;
+    if (stat(QFile::encodeName(path).constData(), &fileStat) == 0) {
+        hash.addData(QByteArray::number(static_cast<qulonglong>(fileStat.st_dev)));
+        hash.addData(QByteArray::number(static_cast<qulonglong>(fileStat.st_ino)));
+        hash.addData(QByteArray::number(static_cast<qlonglong>(fileStat.st_ctime)));
+    }
+#endif
+    hash.addData(Core()->binFileRead(0, FINGERPRINT_BYTES));
+    if (fileSize > static_cast<ut64>(FINGERPRINT_BYTES)) {
+        hash.addData(Core()->binFileRead(fileSize - FINGERPRINT_BYTES, FINGERPRINT_BYTES));
+    }
+    return hash.result();
+}
+
+void SectionStatistics::insertStatistics(const Range &range, const FileRangeStatistics &statistics,
+                                         quint64 computeGeneration)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (computeGeneration != generation) {
+            // Another file was loaded meanwhile
+            return;
+        }
+        pendingRanges.remove(range);
+        statisticsCache.insert(range, statistics);
+    }
+    emit statisticsReady();
+}
@@ -0,0 +1,79 @@
+#ifndef SECTIONSTATISTICS_H
+#define SECTIONSTATISTICS_H
+
+#include "core/CutterCommon.h"
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+
+/**
+ * @brief Byte statistics of a range of the loaded bin file
+ */
+struct FileRangeStatistics {
+    /**
+     * Shannon entropy in bits per byte
+     */
+    double entropy = 0.0;
+    QVector<ut64> histogram;
+    QString md5;
+    QString sha256;
+};
+
+/**
+ * @brief Computes FileRangeStatistics of ranges of the bin file, like sections, on worker threads.
+ *
+ * Every range is computed on its own thread, so sections are processed in parallel. Results are
+ * kept as long as the same file is loaded, which is checked on every refreshAll with a fingerprint
+ * of its path, modification time, inode, size and the bytes at its start and end.
+ */
+class SectionStatistics : public QObject
+{
+    Q_OBJECT
+
+    friend class SectionStatisticsRunnable;
+
+public:
+    explicit SectionStatistics(QObject *parent = nullptr);
+    ~SectionStatistics() override;
+
+    /**
+     * @brief Get the statistics of [paddr, paddr + size) if they are computed already,
+     * otherwise start computing them and emit statisticsReady() once done.
+     * @return whether statistics was filled
+     */
+    bool getStatistics(ut64 paddr, ut64 size, FileRangeStatistics *statistics);
+
+signals:
+    /**
+     * @brief Emitted, possibly from a worker thread, whenever the statistics of a range were added
+     */
+    void statisticsReady();
+
+public slots:
+    /**
+     * @brief Drop all results, unless the loaded file is still the same
+     */
+    void checkFile();
+
+private:
+    using Range = QPair<ut64, ut64>;
+
+    void insertStatistics(const Range &range, const FileRangeStatistics &statistics,
+                          quint64 computeGeneration);
+    static QByteArray fileFingerprint();
+
+    QMutex mutex;
+    QHash<Range, FileRangeStatistics> statisticsCache;
+    QSet<Range> pendingRanges;
+    QByteArray fingerprint;
+    quint64 generation = 0;
+
+    QThreadPool pool;
+};
+
+#endif // SECTIONSTATISTICS_H
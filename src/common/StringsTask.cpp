@@ -0,0 +1,426 @@
+#include "StringsTask.h"
+
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+/**
+ * Size of the windows the file is split into for scanning
+ */
+const ut64 WINDOW_SIZE = 4 * 1024 * 1024;
+
+/**
+ * Used when bin.maxstr is 0. Longer runs are split into several strings, like r2 does
+ */
+const int DEFAULT_MAX_STRING_LENGTH = 2048;
+
+/**
+ * Upper bound for bin.maxstr, so the bytes read for a window stay far below INT_MAX
+ */
+const int MAX_STRING_LENGTH_LIMIT = 1024 * 1024;
+
+/**
+ * Most bytes a character takes in any encoding
+ */
+const int MAX_CHAR_SIZE = 4;
+
+const int DEFAULT_MIN_STRING_LENGTH = 4;
+
+enum Encoding {
+    Latin1 = 1 << 0,
+    Utf8 = 1 << 1,
+    Utf16le = 1 << 2,
+    Utf16be = 1 << 3,
+    Utf32le = 1 << 4,
+    Utf32be = 1 << 5
+};
+
+/**
+ * @brief Encodings to look for, from the value of bin.str.enc
+ */
+int encodingsFromConfig(const QString &enc)
+{
+    if (enc == "latin1") {
+        return Latin1;
+    } else if (enc == "utf8") {
+        return Utf8;
+    } else if (enc == "utf16le") {
+        return Utf16le;
+    } else if (enc == "utf16be") {
+        return Utf16be;
+    } else if (enc == "utf32le") {
+        return Utf32le;
+    } else if (enc == "utf32be") {
+        return Utf32be;
+    }
+    // "guess"
+    return Utf8 | Utf16le | Utf32le;
+}
+
+struct ScanOptions {
+    int encodings;
+    int minLength;
+    int maxLength;
+    bool va;
+};
+
+struct ScanSection {
+    ut64 paddr;
+    ut64 size;
+    RVA vaddr;
+    QString name;
+};
+
+struct WideEncoding {
+    Encoding encoding;
+    int unitSize;
+    bool bigEndian;
+    const char *type;
+};
+
+/**
+ * Tried in this order, before the single byte encodings
+ */
+const WideEncoding WIDE_ENCODINGS[] = {
+    { Utf32le, 4, false, "utf32le" },
+    { Utf32be, 4, true, "utf32be" },
+    { Utf16le, 2, false, "utf16le" },
+    { Utf16be, 2, true, "utf16be" }
+};
+
+bool isStringChar(ut8 c)
+{
+    return (c >= 0x20 && c < 0x7f) || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @brief Whether no string run of any encoding can contain c: not a string char, not part of
+ * UTF-8 or Latin-1 and not one of the zero bytes of UTF-16 or UTF-32
+ */
+bool isBreakChar(ut8 c)
+{
+    return c != 0 && c < 0x80 && !isStringChar(c);
+}
+
+/**
+ * @return length of a valid UTF-8 multibyte sequence starting at p, 0 if there is none
+ */
+int utf8SequenceLength(const ut8 *p, const ut8 *end)
+{
+    int len;
+    if ((p[0] & 0xe0) == 0xc0 && p[0] >= 0xc2) {
+        len = 2;
+    } else if ((p[0] & 0xf0) == 0xe0) {
+        len = 3;
+    } else if ((p[0] & 0xf8) == 0xf0 && p[0] <= 0xf4) {
+        len = 4;
+    } else {
+        return 0;
+    }
+    if (end - p < len) {
+        return 0;
+    }
+    for (int i = 1; i < len; i++) {
+        if ((p[i] & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+    return len;
+}
+
+/**
+ * @return the string char held by the code unit at p, 0 if there is none
+ */
+ut8 wideChar(const ut8 *p, const WideEncoding &encoding)
+{
+    ut8 c = encoding.bigEndian ? p[encoding.unitSize - 1] : p[0];
+    const ut8 *zeros = encoding.bigEndian ? p : p + 1;
+    for (int i = 0; i < encoding.unitSize - 1; i++) {
+        if (zeros[i]) {
+            return 0;
+        }
+    }
+    return isStringChar(c) ? c : 0;
+}
+
+class StringsScanRunnable : public QRunnable
+{
+public:
+    StringsScanRunnable(StringsTask *task, const QList<ScanSection> *sections,
+                        const ScanOptions &options, ut64 from, ut64 to, ut64 fileSize)
+        : task(task), sections(sections), options(options), from(from), to(to),
+          fileSize(fileSize)
+    {
+        // The zero bytes around a position that no run of the encodings can span
+        zerosBefore = 1;
+        zerosAfter = 0;
+        if (options.encodings & (Utf16le | Utf16be)) {
+            zerosBefore = 2;
+        }
+        if (options.encodings & (Utf32le | Utf32be)) {
+            zerosBefore = 4;
+        }
+        if (options.encodings & Utf16be) {
+            zerosAfter = 1;
+        }
+        if (options.encodings & Utf32be) {
+            zerosAfter = 3;
+        }
+    }
+
+    void run() override
+    {
+        if (task->isInterrupted()) {
+            return;
+        }
+        // Enough to hold any string starting before to, including its terminator
+        ut64 maxRunSize = static_cast<ut64>(options.maxLength + 1) * MAX_CHAR_SIZE;
+        ut64 overlap = std::min(from, maxRunSize);
+        ut64 readStart = from - overlap;
+        ut64 readEnd = std::min(to + maxRunSize, fileSize);
+        if (readEnd <= readStart || readEnd - readStart > static_cast<ut64>(INT_MAX)) {
+            return;
+        }
+        QByteArray data = Core()->binFileRead(readStart, static_cast<int>(readEnd - readStart));
+        if (task->isInterrupted() || static_cast<ut64>(data.size()) <= overlap) {
+            return;
+        }
+        QList<StringDescription> strings = scan(data, readStart,
+                                                syncPoint(data, static_cast<int>(overlap)));
+        if (!strings.isEmpty() && !task->isInterrupted()) {
+            emit task->stringsFound(strings);
+        }
+    }
+
+private:
+    StringsTask *task;
+    const QList<ScanSection> *sections;
+    ScanOptions options;
+    ut64 from;
+    ut64 to;
+    ut64 fileSize;
+    int zerosBefore;
+    int zerosAfter;
+
+    /**
+     * @brief Last index at or before limit in data where no string run is in progress.
+     *
+     * That is the file start, right after a byte no run can contain, or amid enough zero
+     * bytes. Scanning from there finds the same strings as scanning from the file start, so
+     * neighbouring windows agree on the strings crossing their border. Without such a point,
+     * which takes a run longer than bin.maxstr characters, the scan starts at index 0 and may
+     * split that run at other offsets than the previous window.
+     */
+    int syncPoint(const QByteArray &data, int limit) const
+    {
+        const ut8 *buf = reinterpret_cast<const ut8 *>(data.constData());
+        for (int i = limit; i > 0; i--) {
+            if (isBreakChar(buf[i - 1])) {
+                return i;
+            }
+            if (i < zerosBefore || i + zerosAfter > data.size()) {
+                continue;
+            }
+            bool zeros = true;
+            for (int j = i - zerosBefore; j < i + zerosAfter && zeros; j++) {
+                zeros = buf[j] == 0;
+            }
+            if (zeros) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    const ScanSection *sectionAt(ut64 paddr) const
+    {
+        auto it = std::upper_bound(sections->begin(), sections->end(), paddr,
+        [](ut64 addr, const ScanSection & section) {
+            return addr < section.paddr;
+        });
+        if (it == sections->begin()) {
+            return nullptr;
+        }
+        --it;
+        return paddr < it->paddr + it->size ? &*it : nullptr;
+    }
+
+    void addString(QList<StringDescription> &strings, ut64 paddr, QString string,
+                   const char *type, int length, int size) const
+    {
+        if (paddr < from || length < options.minLength) {
+            return;
+        }
+        StringDescription desc;
+        const ScanSection *section = sectionAt(paddr);
+        desc.vaddr = options.va && section ? section->vaddr + (paddr - section->paddr) : paddr;
+        desc.string = string;
+        desc.type = QString::fromLatin1(type);
+        desc.length = static_cast<ut32>(length);
+        desc.size = static_cast<ut32>(size);
+        desc.section = section ? section->name : QString();
+        strings << desc;
+    }
+
+    /**
+     * @brief Length in bytes of the run of encoding at i, 0 if there is none
+     */
+    int scanWide(const ut8 *buf, int i, int n, const WideEncoding &encoding,
+                 QByteArray *latin) const
+    {
+        int unit = encoding.unitSize;
+        if (i + 2 * unit > n || !wideChar(buf + i, encoding)
+                || !wideChar(buf + i + unit, encoding)) {
+            return 0;
+        }
+        int j = i;
+        while (j + unit <= n && latin->size() < options.maxLength) {
+            ut8 c = wideChar(buf + j, encoding);
+            if (!c) {
+                break;
+            }
+            latin->append(static_cast<char>(c));
+            j += unit;
+        }
+        return j - i;
+    }
+
+    /**
+     * @brief Find all strings starting in [from, to) in data, which starts at base and is
+     * scanned from index start
+     */
+    QList<StringDescription> scan(const QByteArray &data, ut64 base, int start) const
+    {
+        QList<StringDescription> strings;
+        const ut8 *buf = reinterpret_cast<const ut8 *>(data.constData());
+        const int n = data.size();
+        const bool utf8 = options.encodings & Utf8;
+        const bool latin1 = options.encodings & Latin1;
+        int i = start;
+        while (i < n) {
+            ut64 offset = base + static_cast<ut64>(i);
+            if (offset >= to) {
+                break;
+            }
+            if ((i & 0xffff) == 0 && task->isInterrupted()) {
+                break;
+            }
+
+            // UTF-16 and UTF-32, only the latin subset
+            int wideSize = 0;
+            for (const WideEncoding &encoding : WIDE_ENCODINGS) {
+                if (!(options.encodings & encoding.encoding)) {
+                    continue;
+                }
+                QByteArray latin;
+                wideSize = scanWide(buf, i, n, encoding, &latin);
+                if (!wideSize) {
+                    continue;
+                }
+                int size = wideSize;
+                int unit = encoding.unitSize;
+                if (i + size + unit <= n
+                        && std::all_of(buf + i + size, buf + i + size + unit,
+                                       [](ut8 b) { return b == 0; })) {
+                    size += unit;
+                }
+                addString(strings, offset, QString::fromLatin1(latin), encoding.type,
+                          latin.size(), size);
+                break;
+            }
+            if (wideSize) {
+                i += wideSize;
+                continue;
+            }
+
+            // ASCII, UTF-8 and Latin-1
+            int j = i;
+            int length = 0;
+            bool multibyte = false;
+            bool highLatin1 = false;
+            while ((utf8 || latin1) && j < n && length < options.maxLength) {
+                if (isStringChar(buf[j])) {
+                    j++;
+                    length++;
+                    continue;
+                }
+                if (latin1 && buf[j] >= 0xa0) {
+                    j++;
+                    length++;
+                    highLatin1 = true;
+                    continue;
+                }
+                int seqLen = utf8 ? utf8SequenceLength(buf + j, buf + n) : 0;
+                if (!seqLen) {
+                    break;
+                }
+                j += seqLen;
+                length++;
+                multibyte = true;
+            }
+            if (length == 0) {
+                i++;
+                continue;
+            }
+            int size = j - i;
+            if (j < n && buf[j] == 0) {
+                size++;
+            }
+            const char *chars = reinterpret_cast<const char *>(buf + i);
+            if (latin1) {
+                addString(strings, offset, QString::fromLatin1(chars, j - i),
+                          highLatin1 ? "latin1" : "ascii", length, size);
+            } else {
+                addString(strings, offset, QString::fromUtf8(chars, j - i),
+                          multibyte ? "utf8" : "ascii", length, size);
+            }
+            i = j;
+        }
+        return strings;
+    }
+};
+
+}
+
+void StringsTask::runTask()
+{
+    ut64 fileSize = Core()->binFileSize();
+
+    QList<ScanSection> sections;
+    for (const SectionDescription &section : Core()->getAllSections()) {
+        if (section.size > 0) {
+            sections.append({ section.paddr, section.size, section.vaddr, section.name });
+        }
+    }
+    std::sort(sections.begin(), sections.end(), [](const ScanSection & a, const ScanSection & b) {
+        return a.paddr < b.paddr;
+    });
+
+    ScanOptions options;
+    options.va = Core()->getConfigb("io.va");
+    options.encodings = encodingsFromConfig(Core()->getConfig("bin.str.enc"));
+    options.minLength = Core()->getConfigi("bin.minstr");
+    if (options.minLength <= 0) {
+        options.minLength = DEFAULT_MIN_STRING_LENGTH;
+    }
+    options.maxLength = Core()->getConfigi("bin.maxstr");
+    if (options.maxLength <= 0) {
+        options.maxLength = DEFAULT_MAX_STRING_LENGTH;
+    }
+    options.maxLength = std::min(std::max(options.maxLength, options.minLength),
+                                 MAX_STRING_LENGTH_LIMIT);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+    for (ut64 from = 0; from < fileSize; from += WINDOW_SIZE) {
+        ut64 to = std::min(from + WINDOW_SIZE, fileSize);
+        pool.start(new StringsScanRunnable(this, &sections, options, from, to, fileSize));
+    }
+    pool.waitForDone();
+
+    emit stringSearchFinished();
+}
@@ -5,6 +5,18 @@
 #include "common/AsyncTask.h"
 #include "core/Cutter.h"
 
+/**
+ * @brief Scans the loaded bin file for strings, like "izz".
+ *
+ * The file is split into fixed-size windows that are scanned in parallel. Strings are
+ * emitted in batches as soon as a window is done, so they arrive in no particular order.
+ *
+ * bin.minstr, bin.maxstr and bin.str.enc are honored like "izz" does, with these differences:
+ * - UTF-16 and UTF-32 strings only consist of printable ASCII characters.
+ * - Unknown values of bin.str.enc are treated as "guess", which looks for ASCII, UTF-8,
+ *   UTF-16LE and UTF-32LE.
+ * - bin.maxstr is capped at a million characters.
+ */
 class StringsTask : public AsyncTask
 {
 Q_OBJECT
@@ -13,14 +25,11 @@ public:
     QString getTitle() override                     { return tr("Searching for Strings"); }
 
 signals:
-    void stringSearchFinished(const QList<StringDescription> &strings);
+    void stringsFound(const QList<StringDescription> &strings);
+    void stringSearchFinished();
 
 protected:
-    void runTask() override
-    {
-        auto strings = Core()->getAllStrings();
-        emit stringSearchFinished(strings);
-    }
+    void runTask() override;
 };
 
 #endif //STRINGSASYNCTASK_H
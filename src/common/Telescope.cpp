@@ -0,0 +1,252 @@
+#include "Telescope.h"
+#include "core/Cutter.h"
+
+#include <cstring>
+
+/**
+ * Size and alignment of the memory chunks that are read
+ */
+static const RVA CHUNK_BYTES = 0x100;
+
+/**
+ * Bytes shown when a pointer looks like ascii
+ */
+static const int STRING_BYTES = 128;
+
+/**
+ * Bytes disassembled at executable addresses
+ */
+static const int ASM_BYTES = 32;
+
+/**
+ * Classifications kept before starting over
+ */
+static const int MAX_ADDRESS_INFOS = 0x4000;
+
+static quint64 combineSignature(quint64 signature, quint64 value)
+{
+    return (signature ^ value) * Q_UINT64_C(0x100000001b3);
+}
+
+void Telescope::begin(RCore *core)
+{
+    this->core = core;
+    chunks.clear();
+
+    // r_core_anal_address() looks at the debug maps while debugging and the io maps otherwise,
+    // the latter only change along with a rebase or a reload, which bump the analysis revision
+    quint64 signature = Q_UINT64_C(0xcbf29ce484222325);
+    signature = combineSignature(signature, reinterpret_cast<quintptr>(r_bin_cur_object(core->bin)));
+    signature = combineSignature(signature, r_config_get_i(core->config, "cfg.debug"));
+    RListIter *it;
+    RDebugMap *map;
+    CutterRListForeach(core->dbg->maps, it, RDebugMap, map) {
+        signature = combineSignature(signature, map->addr);
+        signature = combineSignature(signature, map->addr_end);
+        signature = combineSignature(signature, static_cast<quint64>(map->perm));
+    }
+
+    quint64 revision = Core()->getAnalysisRevision();
+    if (signature != mapsSignature || revision != analysisRevision
+            || addressInfos.size() > MAX_ADDRESS_INFOS) {
+        addressInfos.clear();
+        mapsSignature = signature;
+        analysisRevision = revision;
+    }
+}
+
+QList<AddrRefChain> Telescope::telescopeRange(RCore *core, RVA addr, int size, int depth)
+{
+    QList<AddrRefChain> ret;
+    begin(core);
+
+    // The whole window in one read, including the strings of its last slots
+    prefetch(addr, size + STRING_BYTES);
+
+    int base = core->anal->bits;
+    for (int i = 0; i < size; i += base / 8) {
+        if ((base == 32 && addr + i >= UT32_MAX) || (base == 16 && addr + i >= UT16_MAX)) {
+            break;
+        }
+        AddrRefChain chain;
+        appendRefs(addr + i, depth, chain);
+        ret.append(chain);
+    }
+    return ret;
+}
+
+AddrRefChain Telescope::telescope(RCore *core, RVA addr, int depth)
+{
+    AddrRefChain chain;
+    begin(core);
+    appendRefs(addr, depth, chain);
+    return chain;
+}
+
+void Telescope::appendRefs(RVA addr, int depth, AddrRefChain &chain)
+{
+    int bits = core->assembler->bits;
+    for (; depth >= 1 && addr != UT64_MAX; depth--) {
+        const AddressInfo &info = addressInfo(addr);
+        AddrRefDescription ref;
+        ref.addr = addr;
+        ref.type = info.typeName;
+        ref.perms = info.perms;
+        ref.fcn = info.fcn;
+
+        // Avoid duplication for heap/stack with type
+        if (!(info.type & R_ANAL_ADDR_TYPE_HEAP || info.type & R_ANAL_ADDR_TYPE_STACK)) {
+            ref.mapname = info.mapname;
+            ref.section = info.section;
+        }
+
+        // Register values change with every step, so they are never kept
+        RFlagItem *fi = r_flag_get_i(core->flags, addr);
+        if (fi) {
+            RRegItem *r = r_reg_get(core->dbg->reg, fi->name, -1);
+            if (r) {
+                ref.reg = r->name;
+            }
+        }
+
+        if (info.type & R_ANAL_ADDR_TYPE_EXEC) {
+            QByteArray buf = read(addr, ASM_BYTES);
+            RAsmOp op;
+            r_asm_set_pc(core->assembler, addr);
+            r_asm_disassemble(core->assembler, &op, reinterpret_cast<unsigned char *>(buf.data()),
+                              buf.size());
+            ref.asmText = r_asm_op_get_asm(&op);
+        } else if (info.type & R_ANAL_ADDR_TYPE_READ) {
+            QByteArray buf = read(addr, 8);
+            if (bits == 64) {
+                ut64 n64;
+                memcpy(&n64, buf.constData(), sizeof(n64));
+                ref.value = n64;
+            } else {
+                ut32 n32;
+                memcpy(&n32, buf.constData(), sizeof(n32));
+                ref.value = n32;
+            }
+            ref.hasValue = true;
+        }
+
+        // If the pointer of the previous address looks like ascii, it might be a string
+        if (!chain.isEmpty() && ref.type == "ascii") {
+            AddrRefDescription &prev = chain.last();
+            QByteArray buf = read(prev.addr, STRING_BYTES);
+            QString strVal = QString(buf);
+            // Indicate that the string is longer than the printed value
+            if (strVal.size() == buf.size()) {
+                strVal += "...";
+            }
+            prev.string = strVal;
+        }
+
+        chain.append(ref);
+        if (!ref.hasValue || ref.value == addr) {
+            // Make sure we aren't telescoping the same address
+            break;
+        }
+        addr = ref.value;
+    }
+}
+
+const Telescope::AddressInfo &Telescope::addressInfo(RVA addr)
+{
+    auto it = addressInfos.constFind(addr);
+    if (it != addressInfos.constEnd()) {
+        return it.value();
+    }
+
+    AddressInfo info;
+    ut64 type = r_core_anal_address(core, addr);
+    info.type = type;
+
+    if (!(type & R_ANAL_ADDR_TYPE_HEAP || type & R_ANAL_ADDR_TYPE_STACK)) {
+        // Attempt to find the address within a map
+        RDebugMap *map = r_debug_map_get(core->dbg, addr);
+        if (map && map->name && map->name[0]) {
+            info.mapname = map->name;
+        }
+
+        RBinSection *sect = r_bin_get_section_at(r_bin_cur_object(core->bin), addr, true);
+        if (sect && sect->name[0]) {
+            info.section = sect->name;
+        }
+    }
+
+    RAnalFunction *fcn = r_anal_get_fcn_in(core->anal, addr, 0);
+    if (fcn) {
+        info.fcn = fcn->name;
+    }
+
+    if (type & R_ANAL_ADDR_TYPE_HEAP) {
+        info.typeName = "heap";
+    } else if (type & R_ANAL_ADDR_TYPE_STACK) {
+        info.typeName = "stack";
+    } else if (type & R_ANAL_ADDR_TYPE_PROGRAM) {
+        info.typeName = "program";
+    } else if (type & R_ANAL_ADDR_TYPE_LIBRARY) {
+        info.typeName = "library";
+    } else if (type & R_ANAL_ADDR_TYPE_ASCII) {
+        info.typeName = "ascii";
+    } else if (type & R_ANAL_ADDR_TYPE_SEQUENCE) {
+        info.typeName = "sequence";
+    }
+
+    if (type & R_ANAL_ADDR_TYPE_READ) {
+        info.perms += "r";
+    }
+    if (type & R_ANAL_ADDR_TYPE_WRITE) {
+        info.perms += "w";
+    }
+    if (type & R_ANAL_ADDR_TYPE_EXEC) {
+        info.perms += "x";
+    }
+
+    return addressInfos.insert(addr, info).value();
+}
+
+void Telescope::prefetch(RVA addr, int size)
+{
+    RVA start = addr - addr % CHUNK_BYTES;
+    RVA end = addr + static_cast<RVA>(size);
+    if (end < addr) {
+        return;
+    }
+    end += (CHUNK_BYTES - end % CHUNK_BYTES) % CHUNK_BYTES;
+    if (end <= start) {
+        return;
+    }
+
+    QByteArray buf(static_cast<int>(end - start), '\0');
+    r_io_read_at(core->io, start, reinterpret_cast<unsigned char *>(buf.data()), buf.size());
+    for (RVA chunk = start; chunk < end; chunk += CHUNK_BYTES) {
+        chunks.insert(chunk, buf.mid(static_cast<int>(chunk - start), static_cast<int>(CHUNK_BYTES)));
+    }
+}
+
+QByteArray Telescope::read(RVA addr, int size)
+{
+    QByteArray ret(size, '\0');
+    int done = 0;
+    while (done < size) {
+        RVA current = addr + static_cast<RVA>(done);
+        RVA chunk = current - current % CHUNK_BYTES;
+        auto it = chunks.constFind(chunk);
+        if (it == chunks.constEnd()) {
+            QByteArray data(static_cast<int>(CHUNK_BYTES), '\0');
+            r_io_read_at(core->io, chunk, reinterpret_cast<unsigned char *>(data.data()), data.size());
+            it = chunks.insert(chunk, data);
+        }
+        int offset = static_cast<int>(current - chunk);
+        int count = qMin(size - done, static_cast<int>(CHUNK_BYTES) - offset);
+        memcpy(ret.data() + done, it.value().constData() + offset, static_cast<size_t>(count));
+        done += count;
+        if (chunk + CHUNK_BYTES < chunk) {
+            // End of the address space
+            break;
+        }
+    }
+    return ret;
+}
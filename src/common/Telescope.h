@@ -0,0 +1,63 @@
+#ifndef TELESCOPE_H
+#define TELESCOPE_H
+
+#include "core/CutterCommon.h"
+#include "core/CutterDescriptions.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+
+/**
+ * @brief Follows pointer chains for the stack view and CutterCore::getAddrRefs().
+ *
+ * Memory is read in aligned chunks shared by all chains of one call, so the stack window and
+ * every page its pointers lead to are read only once per call. How an address is classified
+ * (type, permissions, map, section and function) only depends on the memory maps and the
+ * analysis, so it is kept across calls until the maps change or the analysis revision moves.
+ * Steps that only write data keep it, steps writing executable memory move the revision too.
+ *
+ * Must only be used with the core locked.
+ */
+class Telescope
+{
+public:
+    /**
+     * @brief Telescope every pointer sized slot of [addr, addr + size)
+     */
+    QList<AddrRefChain> telescopeRange(RCore *core, RVA addr, int size, int depth);
+
+    /**
+     * @brief Dereference addr recursively, up to depth addresses
+     */
+    AddrRefChain telescope(RCore *core, RVA addr, int depth);
+
+private:
+    struct AddressInfo {
+        ut64 type;
+        QString typeName;
+        QString perms;
+        QString mapname;
+        QString section;
+        QString fcn;
+    };
+
+    void begin(RCore *core);
+    void appendRefs(RVA addr, int depth, AddrRefChain &chain);
+    const AddressInfo &addressInfo(RVA addr);
+    void prefetch(RVA addr, int size);
+    QByteArray read(RVA addr, int size);
+
+    RCore *core = nullptr;
+
+    QHash<RVA, AddressInfo> addressInfos;
+    quint64 analysisRevision = 0;
+    quint64 mapsSignature = 0;
+
+    /**
+     * Memory read during the current call, by chunk address
+     */
+    QHash<RVA, QByteArray> chunks;
+};
+
+#endif // TELESCOPE_H
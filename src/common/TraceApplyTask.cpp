@@ -0,0 +1,15 @@
+#include "TraceApplyTask.h"
+
+TraceApplyTask::TraceApplyTask(QSharedPointer<TraceFile> trace, quint64 index)
+    : trace(trace),
+      index(index)
+{
+}
+
+void TraceApplyTask::runTask()
+{
+    successful = trace->getMemory(index, &memory, [this]() { return isInterrupted(); });
+    if (successful) {
+        log(tr("Restored %1 memory ranges").arg(memory.size()));
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef TRACEAPPLYTASK_H
+#define TRACEAPPLYTASK_H
+
+#include "common/AsyncTask.h"
+#include "common/TraceFile.h"
+
+#include <QMap>
+#include <QSharedPointer>
+
+/**
+ * @brief Restores the memory written by a trace at one of its states, so it can be applied
+ */
+class TraceApplyTask : public AsyncTask
+{
+    Q_OBJECT
+
+public:
+    TraceApplyTask(QSharedPointer<TraceFile> trace, quint64 index);
+
+    QString getTitle() override                     { return tr("Restoring Trace State"); }
+
+    quint64 getIndex() const                        { return index; }
+
+    /**
+     * @brief Whether getMemory() is complete, false if the task was interrupted
+     */
+    bool isSuccessful() const                       { return successful; }
+
+    /**
+     * @brief Memory at the state as contiguous runs by address, valid if isSuccessful()
+     */
+    const QMap<RVA, QByteArray> &getMemory() const  { return memory; }
+
+protected:
+    void runTask() override;
+
+private:
+    QSharedPointer<TraceFile> trace;
+    quint64 index;
+    QMap<RVA, QByteArray> memory;
+    bool successful = false;
+};
+
+#endif // TRACEAPPLYTASK_H
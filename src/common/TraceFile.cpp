@@ -0,0 +1,594 @@
+#include "TraceFile.h"
+
+#include <QObject>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iterator>
+
+static const char HEADER_MAGIC[] = "CTRC";
+static const char TRAILER_MAGIC[] = "CTRE";
+static const quint32 VERSION = 2;
+
+/**
+ * Bytes kept in memory before they are written to the file
+ */
+static const int FLUSH_SIZE = 1024 * 1024;
+
+/**
+ * Bytes after the keyframe and checkpoint offsets: offset of the memory before the trace,
+ * state count, keyframe interval and magic
+ */
+static const quint64 TRAILER_SIZE = 8 + 8 + 4 + 4;
+
+/**
+ * Set in checkpoint offsets of snapshots, which hold all written bytes instead of a delta
+ */
+static const quint64 SNAPSHOT_FLAG = 1ULL << 63;
+
+namespace {
+
+void putVarint(QByteArray &out, ut64 value)
+{
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+void putSignedVarint(QByteArray &out, ut64 difference)
+{
+    auto value = static_cast<qint64>(difference);
+    putVarint(out, (static_cast<ut64>(value) << 1) ^ static_cast<ut64>(value >> 63));
+}
+
+void putFixed(QByteArray &out, ut64 value, int size)
+{
+    for (int i = 0; i < size; i++) {
+        out.append(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+/**
+ * Runs that merely touch a new write are only merged into it below this size, so memory
+ * written downwards, like a stack, doesn't copy an ever growing run on every write
+ */
+const int MAX_PREPEND_RUN_SIZE = 4096;
+
+/**
+ * @brief Store size bytes at addr in runs, which are kept sorted by address and disjoint
+ * @param overwrite whether bytes already in runs are replaced, otherwise only the missing ones
+ * are added
+ * @return how many of the bytes were not in runs before
+ */
+quint64 putRun(QMap<RVA, QByteArray> &runs, RVA addr, const char *bytes, int size,
+               bool overwrite)
+{
+    RVA end = addr + static_cast<RVA>(size);
+    if (size <= 0 || end < addr) {
+        return 0;
+    }
+
+    auto mergesWith = [end](QMap<RVA, QByteArray>::iterator run) {
+        return run.key() < end
+               || (run.key() == end && run.value().size() < MAX_PREPEND_RUN_SIZE);
+    };
+
+    auto it = runs.upperBound(addr);
+    if (it != runs.begin()) {
+        auto prev = std::prev(it);
+        RVA prevEnd = prev.key() + static_cast<RVA>(prev.value().size());
+        if (prevEnd >= addr) {
+            if (it == runs.end() || !mergesWith(it)) {
+                // Within or right after a single run, changed in place
+                QByteArray &run = prev.value();
+                int overlap = static_cast<int>(std::min(prevEnd, end) - addr);
+                if (overwrite) {
+                    memcpy(run.data() + (addr - prev.key()), bytes, static_cast<size_t>(overlap));
+                }
+                run.append(bytes + overlap, size - overlap);
+                return static_cast<quint64>(size - overlap);
+            }
+            it = prev;
+        }
+    }
+
+    RVA start = addr;
+    RVA stop = end;
+    quint64 covered = 0;
+    auto last = it;
+    for (; last != runs.end() && mergesWith(last); ++last) {
+        RVA runEnd = last.key() + static_cast<RVA>(last.value().size());
+        start = std::min(start, last.key());
+        stop = std::max(stop, runEnd);
+        RVA overlapBegin = std::max(addr, last.key());
+        RVA overlapEnd = std::min(end, runEnd);
+        covered += overlapEnd > overlapBegin ? overlapEnd - overlapBegin : 0;
+    }
+
+    QByteArray merged(static_cast<int>(stop - start), '\0');
+    if (!overwrite) {
+        memcpy(merged.data() + (addr - start), bytes, static_cast<size_t>(size));
+    }
+    while (it != last) {
+        memcpy(merged.data() + (it.key() - start), it.value().constData(),
+               static_cast<size_t>(it.value().size()));
+        it = runs.erase(it);
+    }
+    if (overwrite) {
+        memcpy(merged.data() + (addr - start), bytes, static_cast<size_t>(size));
+    }
+    runs.insert(start, merged);
+    return static_cast<quint64>(size) - covered;
+}
+
+/**
+ * @brief Write runs as their number, followed by address, size and contents of each
+ */
+void putMemory(QByteArray &out, const QMap<RVA, QByteArray> &runs)
+{
+    putVarint(out, static_cast<ut64>(runs.size()));
+    for (auto it = runs.constBegin(); it != runs.constEnd(); ++it) {
+        putVarint(out, it.key());
+        putVarint(out, static_cast<ut64>(it.value().size()));
+        out.append(it.value());
+    }
+}
+
+ut64 getFixed(const uchar *data, int size)
+{
+    ut64 value = 0;
+    for (int i = 0; i < size; i++) {
+        value |= static_cast<ut64>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Bounds checked decoding of records, everything reads as 0 after an error
+ */
+class RecordReader
+{
+public:
+    RecordReader(const uchar *data, quint64 pos, quint64 end)
+        : data(data), pos(pos), end(end)
+    {
+    }
+
+    bool isValid() const        { return valid; }
+    void fail()                 { valid = false; pos = end; }
+
+    ut64 varint()
+    {
+        ut64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= end) {
+                fail();
+                return 0;
+            }
+            uchar byte = data[pos++];
+            value |= static_cast<ut64>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        fail();
+        return 0;
+    }
+
+    /**
+     * @return the zigzag decoded difference, to be added with wrap-around
+     */
+    ut64 signedVarint()
+    {
+        ut64 value = varint();
+        return (value >> 1) ^ (~(value & 1) + 1);
+    }
+
+    const uchar *bytes(ut64 size)
+    {
+        if (size > end - pos) {
+            fail();
+            return nullptr;
+        }
+        const uchar *ret = data + pos;
+        pos += size;
+        return ret;
+    }
+
+private:
+    const uchar *data;
+    quint64 pos;
+    quint64 end;
+    bool valid = true;
+};
+
+/**
+ * @brief Apply the register part of a record to state
+ */
+bool readState(RecordReader &reader, bool keyframe, TraceState *state)
+{
+    if (keyframe) {
+        state->pc = reader.varint();
+        for (ut64 &value : state->registers) {
+            value = reader.varint();
+        }
+        return reader.isValid();
+    }
+    state->pc += reader.signedVarint();
+    ut64 changed = reader.varint();
+    for (ut64 i = 0; i < changed && reader.isValid(); i++) {
+        ut64 index = reader.varint();
+        ut64 difference = reader.signedVarint();
+        if (index >= static_cast<ut64>(state->registers.size())) {
+            reader.fail();
+            break;
+        }
+        state->registers[static_cast<int>(index)] += difference;
+    }
+    return reader.isValid();
+}
+
+/**
+ * @brief Read the memory part of a record, calling write for each write if given
+ */
+bool readWrites(RecordReader &reader,
+                const std::function<void(RVA, const uchar *, const uchar *, ut64)> &write)
+{
+    ut64 count = reader.varint();
+    for (ut64 i = 0; i < count && reader.isValid(); i++) {
+        RVA addr = reader.varint();
+        ut64 size = reader.varint();
+        const uchar *oldData = reader.bytes(size);
+        const uchar *newData = reader.bytes(size);
+        if (write && reader.isValid()) {
+            write(addr, oldData, newData, size);
+        }
+    }
+    return reader.isValid();
+}
+
+}
+
+TraceWriter::~TraceWriter()
+{
+    if (file.isOpen()) {
+        close();
+    }
+}
+
+bool TraceWriter::open(const QString &path, const QStringList &registerNames)
+{
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    buffer.clear();
+    buffer.append(HEADER_MAGIC, 4);
+    putFixed(buffer, VERSION, 4);
+    putFixed(buffer, static_cast<ut64>(registerNames.size()), 4);
+    for (const QString &name : registerNames) {
+        QByteArray utf8 = name.toUtf8().left(255);
+        buffer.append(static_cast<char>(utf8.size()));
+        buffer.append(utf8);
+    }
+    flushedSize = 0;
+    stateCount = 0;
+    keyframeOffsets.clear();
+    checkpointOffsets.clear();
+    memory.clear();
+    initialMemory.clear();
+    changedMemory.clear();
+    memorySize = 0;
+    changedMemorySize = 0;
+    changedSinceSnapshot = 0;
+    lastState = TraceState();
+    lastState.registers.fill(0, registerNames.size());
+    return true;
+}
+
+void TraceWriter::append(const TraceState &state, const QList<TraceMemoryWrite> &writes)
+{
+    if (stateCount % KEYFRAME_INTERVAL == 0) {
+        writeCheckpoint();
+        keyframeOffsets.append(flushedSize + static_cast<quint64>(buffer.size()));
+        putVarint(buffer, state.pc);
+        for (ut64 value : state.registers) {
+            putVarint(buffer, value);
+        }
+    } else {
+        putSignedVarint(buffer, state.pc - lastState.pc);
+        int changed = 0;
+        for (int i = 0; i < state.registers.size(); i++) {
+            changed += state.registers[i] != lastState.registers[i];
+        }
+        putVarint(buffer, static_cast<ut64>(changed));
+        for (int i = 0; i < state.registers.size(); i++) {
+            if (state.registers[i] != lastState.registers[i]) {
+                putVarint(buffer, static_cast<ut64>(i));
+                putSignedVarint(buffer, state.registers[i] - lastState.registers[i]);
+            }
+        }
+    }
+    putVarint(buffer, static_cast<ut64>(writes.size()));
+    for (const TraceMemoryWrite &write : writes) {
+        putVarint(buffer, write.addr);
+        putVarint(buffer, static_cast<ut64>(write.newData.size()));
+        QByteArray oldData = write.oldData.leftJustified(write.newData.size(), '\0', true);
+        buffer.append(oldData);
+        buffer.append(write.newData);
+
+        // Bytes not written before are missing from initialMemory as well
+        putRun(initialMemory, write.addr, oldData.constData(), oldData.size(), false);
+        memorySize += putRun(memory, write.addr, write.newData.constData(),
+                             write.newData.size(), true);
+        changedMemorySize += putRun(changedMemory, write.addr, write.newData.constData(),
+                                    write.newData.size(), true);
+    }
+    lastState = state;
+    stateCount++;
+    if (buffer.size() >= FLUSH_SIZE) {
+        flush();
+    }
+}
+
+void TraceWriter::writeCheckpoint()
+{
+    if (changedMemory.isEmpty()) {
+        checkpointOffsets.append(0);
+        return;
+    }
+    quint64 offset = flushedSize + static_cast<quint64>(buffer.size());
+    changedSinceSnapshot += changedMemorySize;
+    if (changedSinceSnapshot >= memorySize) {
+        putMemory(buffer, memory);
+        offset |= SNAPSHOT_FLAG;
+        changedSinceSnapshot = 0;
+    } else {
+        putMemory(buffer, changedMemory);
+    }
+    checkpointOffsets.append(offset);
+    changedMemory.clear();
+    changedMemorySize = 0;
+}
+
+bool TraceWriter::close()
+{
+    quint64 initialMemoryOffset = flushedSize + static_cast<quint64>(buffer.size());
+    putMemory(buffer, initialMemory);
+    for (quint64 offset : keyframeOffsets) {
+        putFixed(buffer, offset, 8);
+    }
+    for (quint64 offset : checkpointOffsets) {
+        putFixed(buffer, offset, 8);
+    }
+    putFixed(buffer, initialMemoryOffset, 8);
+    putFixed(buffer, stateCount, 8);
+    putFixed(buffer, KEYFRAME_INTERVAL, 4);
+    buffer.append(TRAILER_MAGIC, 4);
+    flush();
+    bool ok = file.error() == QFileDevice::NoError;
+    file.close();
+    return ok;
+}
+
+void TraceWriter::flush()
+{
+    file.write(buffer);
+    flushedSize += static_cast<quint64>(buffer.size());
+    buffer.clear();
+}
+
+bool TraceFile::open(const QString &path, QString *errorString)
+{
+    auto error = [errorString](const QString & message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        return false;
+    };
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return error(file.errorString());
+    }
+    auto size = static_cast<quint64>(file.size());
+    if (size < 12 + TRAILER_SIZE) {
+        return error(QObject::tr("The file is not a trace."));
+    }
+    data = file.map(0, file.size());
+    if (!data) {
+        return error(file.errorString());
+    }
+    if (memcmp(data, HEADER_MAGIC, 4) != 0 || memcmp(data + size - 4, TRAILER_MAGIC, 4) != 0) {
+        return error(QObject::tr("The file is not a trace or was not completely written."));
+    }
+    if (getFixed(data + 4, 4) != VERSION) {
+        return error(QObject::tr("Unsupported trace version."));
+    }
+
+    quint64 pos = 12;
+    ut64 registerCount = getFixed(data + 8, 4);
+    registerNames.clear();
+    for (ut64 i = 0; i < registerCount; i++) {
+        if (pos >= size) {
+            return error(QObject::tr("The trace is corrupted."));
+        }
+        quint64 length = data[pos++];
+        if (length > size - pos) {
+            return error(QObject::tr("The trace is corrupted."));
+        }
+        registerNames << QString::fromUtf8(reinterpret_cast<const char *>(data + pos),
+                                           static_cast<int>(length));
+        pos += length;
+    }
+    recordsBegin = pos;
+
+    initialMemoryOffset = getFixed(data + size - TRAILER_SIZE, 8);
+    stateCount = getFixed(data + size - 16, 8);
+    keyframeInterval = static_cast<quint32>(getFixed(data + size - 8, 4));
+    if (keyframeInterval == 0) {
+        return error(QObject::tr("The trace is corrupted."));
+    }
+    quint64 keyframeCount = (stateCount + keyframeInterval - 1) / keyframeInterval;
+    if (keyframeCount > (size - TRAILER_SIZE - recordsBegin) / 16) {
+        return error(QObject::tr("The trace is corrupted."));
+    }
+    recordsEnd = size - TRAILER_SIZE - keyframeCount * 16;
+    if (initialMemoryOffset < recordsBegin || initialMemoryOffset >= recordsEnd) {
+        return error(QObject::tr("The trace is corrupted."));
+    }
+    keyframeOffsets.resize(static_cast<int>(keyframeCount));
+    checkpointOffsets.resize(static_cast<int>(keyframeCount));
+    for (quint64 i = 0; i < keyframeCount; i++) {
+        quint64 offset = getFixed(data + recordsEnd + i * 8, 8);
+        quint64 checkpointOffset = getFixed(data + recordsEnd + (keyframeCount + i) * 8, 8);
+        if (offset < recordsBegin || offset >= recordsEnd
+                || (checkpointOffset & ~SNAPSHOT_FLAG) >= recordsEnd
+                || (i == 0 && checkpointOffset)) {
+            return error(QObject::tr("The trace is corrupted."));
+        }
+        keyframeOffsets[static_cast<int>(i)] = offset;
+        checkpointOffsets[static_cast<int>(i)] = checkpointOffset;
+    }
+    return true;
+}
+
+bool TraceFile::decode(quint64 index, TraceState *state, QList<TraceMemoryWrite> *writes) const
+{
+    if (index >= stateCount) {
+        return false;
+    }
+    quint64 keyframe = index / keyframeInterval;
+    RecordReader reader(data, keyframeOffsets[static_cast<int>(keyframe)], recordsEnd);
+    state->registers.fill(0, registerNames.size());
+    for (quint64 i = keyframe * keyframeInterval; i <= index; i++) {
+        if (!readState(reader, i % keyframeInterval == 0, state)) {
+            return false;
+        }
+        std::function<void(RVA, const uchar *, const uchar *, ut64)> collect;
+        if (writes && i == index) {
+            collect = [writes](RVA addr, const uchar * oldData, const uchar * newData, ut64 size) {
+                TraceMemoryWrite write;
+                write.addr = addr;
+                write.oldData = QByteArray(reinterpret_cast<const char *>(oldData), static_cast<int>(size));
+                write.newData = QByteArray(reinterpret_cast<const char *>(newData), static_cast<int>(size));
+                writes->append(write);
+            };
+        }
+        if (!readWrites(reader, collect)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TraceState TraceFile::getState(quint64 index) const
+{
+    TraceState state;
+    if (!decode(index, &state, nullptr)) {
+        return TraceState();
+    }
+    return state;
+}
+
+QList<TraceMemoryWrite> TraceFile::getWrites(quint64 index) const
+{
+    TraceState state;
+    QList<TraceMemoryWrite> writes;
+    decode(index, &state, &writes);
+    return writes;
+}
+
+bool TraceFile::readMemory(quint64 offset, QMap<RVA, QByteArray> *memory) const
+{
+    RecordReader reader(data, offset, recordsEnd);
+    ut64 runCount = reader.varint();
+    for (ut64 i = 0; i < runCount && reader.isValid(); i++) {
+        RVA addr = reader.varint();
+        ut64 size = reader.varint();
+        const uchar *bytes = reader.bytes(size);
+        if (size > INT_MAX) {
+            reader.fail();
+        }
+        if (reader.isValid()) {
+            putRun(*memory, addr, reinterpret_cast<const char *>(bytes), static_cast<int>(size),
+                   true);
+        }
+    }
+    return reader.isValid();
+}
+
+bool TraceFile::getMemory(quint64 index, QMap<RVA, QByteArray> *memory,
+                          const std::function<bool()> &isInterrupted) const
+{
+    if (index >= stateCount) {
+        return false;
+    }
+    // Bytes written after index keep their value from before the trace
+    QMap<RVA, QByteArray> runs;
+    if (!readMemory(initialMemoryOffset, &runs)) {
+        return false;
+    }
+
+    quint64 keyframe = index / keyframeInterval;
+    quint64 first = keyframe;
+    while (first > 0 && !(checkpointOffsets[static_cast<int>(first)] & SNAPSHOT_FLAG)) {
+        first--;
+    }
+    for (quint64 i = first; i <= keyframe; i++) {
+        if (isInterrupted && isInterrupted()) {
+            return false;
+        }
+        quint64 offset = checkpointOffsets[static_cast<int>(i)];
+        if (offset && !readMemory(offset & ~SNAPSHOT_FLAG, &runs)) {
+            return false;
+        }
+    }
+
+    RecordReader reader(data, keyframeOffsets[static_cast<int>(keyframe)], recordsEnd);
+    TraceState state;
+    state.registers.fill(0, registerNames.size());
+    for (quint64 i = keyframe * keyframeInterval; i <= index; i++) {
+        if (!readState(reader, i % keyframeInterval == 0, &state)) {
+            return false;
+        }
+        bool ok = readWrites(reader, [&runs](RVA addr, const uchar *, const uchar * newData,
+        ut64 size) {
+            putRun(runs, addr, reinterpret_cast<const char *>(newData),
+                   static_cast<int>(std::min<ut64>(size, INT_MAX)), true);
+        });
+        if (!ok) {
+            return false;
+        }
+    }
+    *memory = runs;
+    return true;
+}
+
+bool TraceFile::countHits(QHash<RVA, quint32> *hits,
+                          const std::function<bool()> &isInterrupted) const
+{
+    // The last state was reached but not executed
+    quint64 executed = stateCount ? stateCount - 1 : 0;
+    for (int keyframe = 0; keyframe < keyframeOffsets.size(); keyframe++) {
+        if (isInterrupted && isInterrupted()) {
+            return false;
+        }
+        // Memory checkpoints lie between the keyframes
+        RecordReader reader(data, keyframeOffsets[keyframe], recordsEnd);
+        TraceState state;
+        state.registers.fill(0, registerNames.size());
+        quint64 first = static_cast<quint64>(keyframe) * keyframeInterval;
+        quint64 last = std::min<quint64>(first + keyframeInterval, executed);
+        for (quint64 i = first; i < last; i++) {
+            if (!readState(reader, i == first, &state) || !readWrites(reader, nullptr)) {
+                return true;
+            }
+            (*hits)[state.pc]++;
+        }
+    }
+    return true;
+}
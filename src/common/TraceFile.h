@@ -0,0 +1,167 @@
+#ifndef TRACEFILE_H
+#define TRACEFILE_H
+
+#include "core/CutterCommon.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+/**
+ * @brief Bytes written by a single step of a trace
+ */
+struct TraceMemoryWrite {
+    RVA addr;
+    QByteArray oldData;
+    QByteArray newData;
+};
+
+/**
+ * @brief Program counter and general purpose registers at one point of a trace
+ */
+struct TraceState {
+    RVA pc = RVA_INVALID;
+    /**
+     * In the order of TraceFile::getRegisterNames()
+     */
+    QVector<ut64> registers;
+};
+
+/**
+ * @brief Writes an execution trace, one state per step.
+ *
+ * A trace file starts with a header ("CTRC", version, register names), followed by one record
+ * per state and a trailer. Every KEYFRAME_INTERVAL states a record holds all registers, in
+ * between only the registers that changed, as the difference to their previous value. All
+ * numbers are LEB128 varints, differences zigzag encoded, so a step of a typical program takes
+ * a handful of bytes. Each record also holds the memory written by the step leading to it, with
+ * the old and the new bytes, so memory can be restored both forwards and backwards.
+ *
+ * Right before every keyframe but the first, a memory checkpoint holds the bytes written since the
+ * previous keyframe with their latest values. Once these deltas add up to as many bytes as were
+ * written in total, the checkpoint is a snapshot of all written bytes instead. After the last
+ * record, the value every written byte had before its first write is stored the same way.
+ * So memory at any state is restored from the last snapshot, the deltas after it and at most
+ * KEYFRAME_INTERVAL records, about twice the written memory, no matter how long the trace is.
+ *
+ * The trailer lists the file offsets of all keyframes and of their memory checkpoints, followed
+ * by the offset of the memory before the trace, the state count, the keyframe interval and
+ * "CTRE", so a reader can seek to any state by decoding at most KEYFRAME_INTERVAL records.
+ */
+class TraceWriter
+{
+public:
+    static const quint32 KEYFRAME_INTERVAL = 4096;
+
+    ~TraceWriter();
+
+    bool open(const QString &path, const QStringList &registerNames);
+
+    /**
+     * @brief Append the state reached by one more step and the memory that step wrote.
+     * writes must be empty for the very first state.
+     */
+    void append(const TraceState &state, const QList<TraceMemoryWrite> &writes);
+
+    /**
+     * @brief Write the trailer, the file is only readable after this
+     */
+    bool close();
+
+    QString getErrorString() const      { return file.errorString(); }
+    quint64 getStateCount() const       { return stateCount; }
+
+private:
+    QFile file;
+    QByteArray buffer;
+    quint64 flushedSize = 0;
+    quint64 stateCount = 0;
+    QVector<quint64> keyframeOffsets;
+    QVector<quint64> checkpointOffsets;
+    TraceState lastState;
+
+    /**
+     * Current value of every byte written so far, as disjoint runs by their address
+     */
+    QMap<RVA, QByteArray> memory;
+    quint64 memorySize = 0;
+    /**
+     * Value of every byte written so far before its first write, as disjoint runs
+     */
+    QMap<RVA, QByteArray> initialMemory;
+    /**
+     * Bytes written since the last keyframe, as disjoint runs
+     */
+    QMap<RVA, QByteArray> changedMemory;
+    quint64 changedMemorySize = 0;
+    quint64 changedSinceSnapshot = 0;
+
+    void writeCheckpoint();
+    void flush();
+};
+
+/**
+ * @brief Read-only access to a trace written by TraceWriter.
+ *
+ * The file is memory mapped, so opening it is cheap regardless of its size and states are
+ * decoded on demand.
+ */
+class TraceFile
+{
+public:
+    bool open(const QString &path, QString *errorString);
+
+    QString getPath() const                             { return file.fileName(); }
+    quint64 getStateCount() const                       { return stateCount; }
+    const QStringList &getRegisterNames() const         { return registerNames; }
+
+    /**
+     * @brief Registers before step index, or after the last step for the last state
+     */
+    TraceState getState(quint64 index) const;
+
+    /**
+     * @brief Memory written by the step leading to state index
+     */
+    QList<TraceMemoryWrite> getWrites(quint64 index) const;
+
+    /**
+     * @brief Contents at state index of every byte the trace writes at some point
+     * @param memory contiguous runs by their address
+     * @return false if the trace is corrupted or isInterrupted returned true
+     */
+    bool getMemory(quint64 index, QMap<RVA, QByteArray> *memory,
+                   const std::function<bool()> &isInterrupted) const;
+
+    /**
+     * @brief How often each address was executed
+     * @return false if isInterrupted returned true before all states were counted
+     */
+    bool countHits(QHash<RVA, quint32> *hits, const std::function<bool()> &isInterrupted) const;
+
+private:
+    QFile file;
+    const uchar *data = nullptr;
+    quint64 recordsBegin = 0;
+    quint64 recordsEnd = 0;
+    quint64 stateCount = 0;
+    quint32 keyframeInterval = 0;
+    QStringList registerNames;
+    QVector<quint64> keyframeOffsets;
+    /**
+     * 0 if nothing was written before the keyframe, SNAPSHOT_FLAG set for snapshots
+     */
+    QVector<quint64> checkpointOffsets;
+    quint64 initialMemoryOffset = 0;
+
+    bool decode(quint64 index, TraceState *state, QList<TraceMemoryWrite> *writes) const;
+    bool readMemory(quint64 offset, QMap<RVA, QByteArray> *memory) const;
+};
+
+#endif // TRACEFILE_H
@@ -0,0 +1,16 @@
+#include "TraceHitCountTask.h"
+
+TraceHitCountTask::TraceHitCountTask(QSharedPointer<TraceFile> trace)
+    : trace(trace)
+{
+}
+
+void TraceHitCountTask::runTask()
+{
+    QHash<RVA, quint32> hits;
+    if (!trace->countHits(&hits, [this]() { return isInterrupted(); })) {
+        return;
+    }
+    log(tr("%1 addresses executed").arg(hits.size()));
+    hitCounts = hits;
+}
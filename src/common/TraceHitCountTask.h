@@ -0,0 +1,35 @@
+#ifndef TRACEHITCOUNTTASK_H
+#define TRACEHITCOUNTTASK_H
+
+#include "common/AsyncTask.h"
+#include "common/TraceFile.h"
+
+#include <QHash>
+#include <QSharedPointer>
+
+/**
+ * @brief Counts how often each address was executed in an opened trace
+ */
+class TraceHitCountTask : public AsyncTask
+{
+    Q_OBJECT
+
+public:
+    explicit TraceHitCountTask(QSharedPointer<TraceFile> trace);
+
+    QString getTitle() override                     { return tr("Counting Trace Hits"); }
+
+    /**
+     * @brief The hit counts, valid after the task finished without being interrupted
+     */
+    const QHash<RVA, quint32> &getHitCounts() const { return hitCounts; }
+
+protected:
+    void runTask() override;
+
+private:
+    QSharedPointer<TraceFile> trace;
+    QHash<RVA, quint32> hitCounts;
+};
+
+#endif // TRACEHITCOUNTTASK_H
@@ -0,0 +1,221 @@
+#include "TraceManager.h"
+#include "common/Configuration.h"
+#include "common/DebugStateSnapshot.h"
+#include "common/TraceApplyTask.h"
+#include "common/TraceHitCountTask.h"
+#include "common/TraceRecordTask.h"
+#include "core/Cutter.h"
+
+#include <algorithm>
+#include <cmath>
+
+TraceManager::TraceManager(QObject *parent)
+    : QObject(parent)
+{
+}
+
+TraceManager::~TraceManager()
+{
+    stopRecording();
+    stopApplyingState();
+    if (hitCountTask) {
+        hitCountTask->interrupt();
+        hitCountTask->wait();
+    }
+}
+
+void TraceManager::startRecording(const QString &path, quint64 maxSteps)
+{
+    if (!Core()->currentlyDebugging || Core()->isDebugTaskInProgress()) {
+        return;
+    }
+    closeTrace();
+
+    recordTask.reset(new TraceRecordTask(path, maxSteps));
+    TraceRecordTask *task = recordTask.data();
+    connect(task, &AsyncTask::finished, this, [this, task, path]() {
+        if (task != recordTask.data()) {
+            return;
+        }
+        TraceRecordTask::Result result = task->getResult();
+        recordTask.clear();
+        // Recording steps with "aes", which may write memory behind the runner's back
+        Core()->invalidateEmulatedCode();
+
+        QString errorString = result.errorString;
+        if (result.ok) {
+            QSharedPointer<TraceFile> recorded(new TraceFile());
+            if (recorded->open(path, &errorString)) {
+                setTrace(recorded);
+                setHitCounts(result.hitCounts);
+            }
+        }
+        if (!errorString.isEmpty()) {
+            emit recordingFailed(errorString);
+        }
+
+        if (Core()->currentlyDebugging) {
+            Core()->syncAndSeekProgramCounter();
+            emit Core()->stackChanged();
+            emit Core()->refreshCodeViews();
+        }
+        emit recordingChanged();
+        emit Core()->debugTaskStateChanged();
+    });
+    Core()->getAsyncTaskManager()->start(recordTask);
+
+    emit recordingChanged();
+    emit Core()->debugTaskStateChanged();
+}
+
+void TraceManager::stopRecording()
+{
+    if (recordTask) {
+        recordTask->interrupt();
+        recordTask->wait();
+    }
+}
+
+bool TraceManager::openTrace(const QString &path, QString *errorString)
+{
+    QSharedPointer<TraceFile> opened(new TraceFile());
+    if (!opened->open(path, errorString)) {
+        return false;
+    }
+    setTrace(opened);
+    setHitCounts(QHash<RVA, quint32>());
+
+    hitCountTask.reset(new TraceHitCountTask(opened));
+    TraceHitCountTask *task = hitCountTask.data();
+    connect(task, &AsyncTask::finished, this, [this, task]() {
+        if (task != hitCountTask.data()) {
+            return;
+        }
+        if (!task->isInterrupted()) {
+            setHitCounts(task->getHitCounts());
+        }
+        hitCountTask.clear();
+    });
+    Core()->getAsyncTaskManager()->start(hitCountTask);
+    return true;
+}
+
+void TraceManager::closeTrace()
+{
+    if (!trace) {
+        return;
+    }
+    setTrace(QSharedPointer<TraceFile>());
+    setHitCounts(QHash<RVA, quint32>());
+}
+
+void TraceManager::setTrace(QSharedPointer<TraceFile> trace)
+{
+    // The file may be recorded again right away, it must not be mapped anymore
+    stopApplyingState();
+    if (hitCountTask) {
+        hitCountTask->interrupt();
+        hitCountTask->wait();
+        hitCountTask.clear();
+    }
+    this->trace = trace;
+    emit traceChanged();
+}
+
+void TraceManager::setHitCounts(const QHash<RVA, quint32> &hitCounts)
+{
+    this->hitCounts = hitCounts;
+    maxHitCount = 0;
+    for (quint32 count : hitCounts) {
+        maxHitCount = std::max(maxHitCount, count);
+    }
+    emit hitCountsChanged();
+}
+
+bool TraceManager::canApplyState()
+{
+    return trace && !applyTask && Core()->currentlyEmulating && !Core()->isDebugTaskInProgress();
+}
+
+bool TraceManager::applyState(quint64 index)
+{
+    if (!canApplyState()) {
+        return false;
+    }
+    TraceState state = trace->getState(index);
+    if (state.pc == RVA_INVALID) {
+        return false;
+    }
+
+    applyTask.reset(new TraceApplyTask(trace, index));
+    TraceApplyTask *task = applyTask.data();
+    connect(task, &AsyncTask::finished, this, [this, task, state]() {
+        if (task != applyTask.data()) {
+            return;
+        }
+        bool successful = task->isSuccessful();
+        QMap<RVA, QByteArray> memory = task->getMemory();
+        applyTask.clear();
+        emit applyingStateChanged();
+
+        // Emulation may have stopped meanwhile
+        if (successful && canApplyState()) {
+            writeState(state, memory);
+        }
+    });
+    Core()->getAsyncTaskManager()->start(applyTask);
+    emit applyingStateChanged();
+    return true;
+}
+
+void TraceManager::stopApplyingState()
+{
+    if (!applyTask) {
+        return;
+    }
+    applyTask->interrupt();
+    applyTask->wait();
+    applyTask.clear();
+    emit applyingStateChanged();
+}
+
+void TraceManager::writeState(const TraceState &state, const QMap<RVA, QByteArray> &memory)
+{
+    {
+        RCoreLocked core = Core()->core();
+        RReg *reg = core->anal->reg;
+        const QStringList &registerNames = trace->getRegisterNames();
+        for (int i = 0; i < registerNames.size() && i < state.registers.size(); i++) {
+            RRegItem *item = r_reg_get(reg, registerNames[i].toUtf8().constData(), -1);
+            if (item) {
+                r_reg_set_value(reg, item, state.registers[i]);
+            }
+        }
+        RRegItem *pcItem = r_reg_get(reg, r_reg_get_name(reg, R_REG_NAME_PC), -1);
+        if (pcItem) {
+            r_reg_set_value(reg, pcItem, state.pc);
+        }
+        for (auto it = memory.constBegin(); it != memory.constEnd(); ++it) {
+            r_io_write_at(core->io, it.key(), reinterpret_cast<const ut8 *>(it.value().constData()),
+                          it.value().size());
+        }
+    }
+
+    Core()->invalidateEmulatedCode();
+    Core()->getDebugState()->invalidate();
+    Core()->syncAndSeekProgramCounter();
+    emit Core()->stackChanged();
+    emit Core()->refreshCodeViews();
+}
+
+QColor TraceManager::colorForHitCount(quint32 hitCount) const
+{
+    if (!hitCount || !maxHitCount) {
+        return QColor();
+    }
+    // Logarithmic, so loop bodies don't wash out everything executed only a few times
+    double heat = std::log(1.0 + std::min(hitCount, maxHitCount)) / std::log(1.0 + maxHitCount);
+    QColor color = ConfigColor("highlightPC");
+    color.setAlphaF(0.15 + 0.6 * heat);
+    return color;
+}
@@ -0,0 +1,99 @@
+#ifndef TRACEMANAGER_H
+#define TRACEMANAGER_H
+
+#include "core/CutterCommon.h"
+#include "common/TraceFile.h"
+
+#include <QColor>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+
+class TraceRecordTask;
+class TraceHitCountTask;
+class TraceApplyTask;
+
+/**
+ * @brief Records execution traces and holds the trace shown in the views.
+ *
+ * While a trace is open, the disassembly, the graph and the navigation bar highlight every
+ * executed address by how often it was executed. When emulating, any state of the trace can be
+ * applied to the emulator, which restores its registers and all memory the trace wrote.
+ */
+class TraceManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TraceManager(QObject *parent = nullptr);
+    ~TraceManager() override;
+
+    bool isRecording() const                            { return !recordTask.isNull(); }
+
+    /**
+     * @brief Start stepping the debugged or emulated program and write the trace to path.
+     * The trace is opened once recording stops.
+     */
+    void startRecording(const QString &path, quint64 maxSteps);
+
+    /**
+     * @brief Stop recording and wait until the trace file is complete
+     */
+    void stopRecording();
+
+    bool openTrace(const QString &path, QString *errorString);
+    void closeTrace();
+
+    QSharedPointer<TraceFile> getTrace() const          { return trace; }
+
+    /**
+     * @brief Whether applyState() is possible, only when emulating and no state is being applied
+     */
+    bool canApplyState();
+
+    /**
+     * @brief Set the registers of the emulator and the memory written by the trace to state index.
+     * The memory is restored in the background, the state is applied once it is done.
+     * @return whether applying was started
+     */
+    bool applyState(quint64 index);
+
+    const QHash<RVA, quint32> &getHitCounts() const     { return hitCounts; }
+    quint32 getHitCount(RVA addr) const                 { return hitCounts.value(addr); }
+    quint32 getMaxHitCount() const                      { return maxHitCount; }
+
+    /**
+     * @brief Background color for addr by its hit count, invalid if it was never executed
+     */
+    QColor getHitCountColor(RVA addr) const            { return colorForHitCount(getHitCount(addr)); }
+
+    /**
+     * @brief Background color for anything executed hitCount times, invalid for 0
+     */
+    QColor colorForHitCount(quint32 hitCount) const;
+
+signals:
+    void recordingChanged();
+    void recordingFailed(const QString &errorString);
+    void traceChanged();
+    void hitCountsChanged();
+    /**
+     * @brief Emitted when applying a state started or finished
+     */
+    void applyingStateChanged();
+
+private:
+    QSharedPointer<TraceRecordTask> recordTask;
+    QSharedPointer<TraceHitCountTask> hitCountTask;
+    QSharedPointer<TraceApplyTask> applyTask;
+    QSharedPointer<TraceFile> trace;
+    QHash<RVA, quint32> hitCounts;
+    quint32 maxHitCount = 0;
+
+    void setTrace(QSharedPointer<TraceFile> trace);
+    void setHitCounts(const QHash<RVA, quint32> &hitCounts);
+    void stopApplyingState();
+    void writeState(const TraceState &state, const QMap<RVA, QByteArray> &memory);
+};
+
+#endif // TRACEMANAGER_H
@@ -0,0 +1,140 @@
+#include "TraceRecordTask.h"
+#include "common/TraceFile.h"
+#include "core/Cutter.h"
+
+/**
+ * Steps executed per core lock
+ */
+static const int STEPS_PER_LOCK = 256;
+
+/**
+ * Writes of the current ESIL step, only set while the recording task holds the core lock
+ */
+static QList<TraceMemoryWrite> *recordedWrites = nullptr;
+static RIO *recordedIO = nullptr;
+static int (*previousMemoryWriteHook)(RAnalEsil *esil, ut64 addr, const ut8 *buf, int len) = nullptr;
+
+static int recordMemoryWrite(RAnalEsil *esil, ut64 addr, const ut8 *buf, int len)
+{
+    if (recordedWrites && len > 0) {
+        TraceMemoryWrite write;
+        write.addr = addr;
+        write.oldData.resize(len);
+        r_io_read_at(recordedIO, addr, reinterpret_cast<ut8 *>(write.oldData.data()), len);
+        write.newData = QByteArray(reinterpret_cast<const char *>(buf), len);
+        recordedWrites->append(write);
+    }
+    return previousMemoryWriteHook ? previousMemoryWriteHook(esil, addr, buf, len) : 0;
+}
+
+TraceRecordTask::TraceRecordTask(const QString &path, quint64 maxSteps)
+    : path(path),
+      maxSteps(maxSteps)
+{
+}
+
+void TraceRecordTask::runTask()
+{
+    bool emulating = Core()->currentlyEmulating;
+    QStringList registerNames;
+    {
+        RCoreLocked core = Core()->core();
+        RReg *reg = emulating ? core->anal->reg : core->dbg->reg;
+        if (!emulating) {
+            r_debug_reg_sync(core->dbg, R_REG_TYPE_GPR, false);
+        }
+        RList *list = r_reg_get_list(reg, R_REG_TYPE_GPR);
+        RListIter *it;
+        RRegItem *item;
+        CutterRListForeach(list, it, RRegItem, item) {
+            registerNames << QString::fromUtf8(item->name);
+        }
+    }
+
+    TraceWriter writer;
+    if (!writer.open(path, registerNames)) {
+        result.errorString = writer.getErrorString();
+        return;
+    }
+
+    TraceState state;
+    bool done = false;
+    while (!done && !isInterrupted()) {
+        RCoreLocked core = Core()->core();
+        RReg *reg = emulating ? core->anal->reg : core->dbg->reg;
+
+        // Looked up again for every batch, the register profile may change meanwhile
+        QVector<RRegItem *> items;
+        for (const QString &name : registerNames) {
+            items << r_reg_get(reg, name.toUtf8().constData(), -1);
+        }
+        RRegItem *pcItem = r_reg_get(reg, r_reg_get_name(reg, R_REG_NAME_PC), -1);
+        if (!pcItem) {
+            result.errorString = tr("The program counter register is unknown.");
+            break;
+        }
+        auto readState = [&]() {
+            TraceState ret;
+            ret.pc = r_reg_get_value(reg, pcItem);
+            ret.registers.reserve(items.size());
+            for (RRegItem *item : items) {
+                ret.registers << (item ? r_reg_get_value(reg, item) : 0);
+            }
+            return ret;
+        };
+
+        if (writer.getStateCount() == 0) {
+            state = readState();
+            writer.append(state, {});
+        }
+
+        RAnalEsil *esil = emulating ? core->anal->esil : nullptr;
+        QList<TraceMemoryWrite> writes;
+        if (esil) {
+            previousMemoryWriteHook = esil->cb.hook_mem_write;
+            esil->cb.hook_mem_write = recordMemoryWrite;
+            recordedWrites = &writes;
+            recordedIO = core->io;
+        }
+
+        for (int i = 0; i < STEPS_PER_LOCK; i++) {
+            if (writer.getStateCount() > maxSteps || isInterrupted()) {
+                done = true;
+                break;
+            }
+            writes.clear();
+            if (emulating) {
+                r_core_cmd0(core, "aes");
+            } else {
+                r_core_cmd0(core, "ds");
+                r_debug_reg_sync(core->dbg, R_REG_TYPE_GPR, false);
+            }
+            TraceState next = readState();
+            result.hitCounts[state.pc]++;
+            writer.append(next, writes);
+
+            // Instructions like "rep movsb" step in place, but change registers
+            bool stuck = next.pc == state.pc && next.registers == state.registers;
+            state = next;
+            if (stuck || r_bp_get_at(core->dbg->bp, state.pc)) {
+                done = true;
+                break;
+            }
+        }
+
+        if (esil) {
+            esil->cb.hook_mem_write = previousMemoryWriteHook;
+            previousMemoryWriteHook = nullptr;
+            recordedWrites = nullptr;
+            recordedIO = nullptr;
+        }
+    }
+
+    result.stateCount = writer.getStateCount();
+    if (!writer.close()) {
+        result.errorString = writer.getErrorString();
+        return;
+    }
+    result.ok = result.errorString.isEmpty();
+    log(tr("Recorded %1 steps").arg(result.stateCount ? result.stateCount - 1 : 0));
+}
@@ -0,0 +1,46 @@
+#ifndef TRACERECORDTASK_H
+#define TRACERECORDTASK_H
+
+#include "common/AsyncTask.h"
+#include "core/CutterCommon.h"
+
+#include <QHash>
+
+/**
+ * @brief Steps the debugged or emulated program and writes every state to a trace file.
+ *
+ * Recording stops when the task is interrupted, after maxSteps steps, at a breakpoint or
+ * when a step makes no progress. The core lock is only held for a batch of steps at a time,
+ * so the rest of the UI stays responsive.
+ *
+ * Memory writes are recorded when emulating, through the ESIL memory write hook.
+ * Native debugging only records registers.
+ */
+class TraceRecordTask : public AsyncTask
+{
+    Q_OBJECT
+
+public:
+    struct Result {
+        bool ok = false;
+        QString errorString;
+        quint64 stateCount = 0;
+        QHash<RVA, quint32> hitCounts;
+    };
+
+    TraceRecordTask(const QString &path, quint64 maxSteps);
+
+    QString getTitle() override                     { return tr("Recording Trace"); }
+
+    const Result &getResult() const                 { return result; }
+
+protected:
+    void runTask() override;
+
+private:
+    QString path;
+    quint64 maxSteps;
+    Result result;
+};
+
+#endif // TRACERECORDTASK_H
@@ -3,14 +3,25 @@
 #include <QRegularExpression>
 #include <QDir>
 #include <QCoreApplication>
+#include <QThread>
+#include <QHash>
 
 #include <cassert>
 #include <memory>
+#include <algorithm>
 
 #include "common/TempConfig.h"
 #include "common/BasicInstructionHighlighter.h"
 #include "common/Configuration.h"
 #include "common/AsyncTask.h"
+#include "common/IOPageCache.h"
+#include "common/SectionStatistics.h"
+#include "common/PreviewCache.h"
+#include "common/DebugStateSnapshot.h"
+#include "common/Telescope.h"
+#include "common/TraceManager.h"
+#include "common/EsilRunner.h"
+#include "common/EsilRunTask.h"
 #include "common/R2Task.h"
 #include "common/Json.h"
 #include "core/Cutter.h"
@@ -31,10 +42,12 @@ namespace RJsonKey {
     R_JSON_KEY(blocks);
     R_JSON_KEY(blocksize);
     R_JSON_KEY(bytes);
+    R_JSON_KEY(callrefs);
     R_JSON_KEY(calltype);
     R_JSON_KEY(cc);
     R_JSON_KEY(classname);
     R_JSON_KEY(code);
+    R_JSON_KEY(codexrefs);
     R_JSON_KEY(comment);
     R_JSON_KEY(comments);
     R_JSON_KEY(cost);
@@ -111,27 +124,15 @@ static void updateOwnedCharPtr(char *&variable, const QString &newValue)
     variable = strdup(data.data());
 }
 
-RCoreLocked::RCoreLocked(CutterCore *core)
+RCoreLocked::RCoreLocked(CutterCore *core, CoreAccess access, const char *caller)
     : core(core)
 {
-    core->coreMutex.lock();
-    assert(core->coreLockDepth >= 0);
-    core->coreLockDepth++;
-    if (core->coreLockDepth == 1) {
-        assert(core->coreBed);
-        r_cons_sleep_end(core->coreBed);
-        core->coreBed = nullptr;
-    }
+    core->lockCore(access, caller);
 }
 
 RCoreLocked::~RCoreLocked()
 {
-    assert(core->coreLockDepth > 0);
-    core->coreLockDepth--;
-    if (core->coreLockDepth == 0) {
-        core->coreBed = r_cons_sleep_begin();
-    }
-    core->coreMutex.unlock();
+    core->unlockCore();
 }
 
 RCoreLocked::operator RCore *() const
@@ -144,7 +145,74 @@ RCore *RCoreLocked::operator->() const
     return core->core_;
 }
 
-#define CORE_LOCK() RCoreLocked core(this)
+#define CORE_LOCK() RCoreLocked core(this, CoreAccess::Write, Q_FUNC_INFO)
+#define CORE_LOCK_READ() RCoreLocked core(this, CoreAccess::Read, Q_FUNC_INFO)
+
+/**
+ * GUI thread waits longer than this are reported together with the caller holding the core.
+ */
+static const qint64 CORE_LOCK_SLOW_WAIT_NS = 200 * 1000 * 1000;
+
+/**
+ * Bytes of writable and executable debugger maps that are hashed at most by
+ * nativeCodeSignature(), beyond that their code is assumed to have changed
+ */
+static const RVA MAX_HASHED_CODE_BYTES = 16 * 1024 * 1024;
+static const int CODE_HASH_CHUNK = 0x10000;
+
+static quint64 combineSignature(quint64 signature, quint64 value)
+{
+    return (signature ^ value) * Q_UINT64_C(0x100000001b3);
+}
+
+/**
+ * @brief Signature of the executable memory of the debugged process.
+ *
+ * Code that is not writable can only change along with the maps, so only maps that are both
+ * writable and executable are read.
+ * @return false if there is too much writable code to hash
+ */
+static bool nativeCodeSignature(RCore *core, quint64 *signature)
+{
+    r_debug_map_sync(core->dbg);
+    quint64 result = Q_UINT64_C(0xcbf29ce484222325);
+    RVA hashed = 0;
+    QByteArray buf;
+    RListIter *it;
+    RDebugMap *map;
+    CutterRListForeach(core->dbg->maps, it, RDebugMap, map) {
+        result = combineSignature(result, map->addr);
+        result = combineSignature(result, map->addr_end);
+        result = combineSignature(result, static_cast<quint64>(map->perm));
+        if (!(map->perm & R_PERM_X) || !(map->perm & R_PERM_W) || map->addr_end <= map->addr) {
+            continue;
+        }
+        if (map->addr_end - map->addr > MAX_HASHED_CODE_BYTES - hashed) {
+            return false;
+        }
+        hashed += map->addr_end - map->addr;
+        for (RVA addr = map->addr; addr < map->addr_end; addr += CODE_HASH_CHUNK) {
+            int size = static_cast<int>(std::min<RVA>(CODE_HASH_CHUNK, map->addr_end - addr));
+            buf.resize(size);
+            r_io_read_at(core->io, addr, reinterpret_cast<ut8 *>(buf.data()), size);
+            result = combineSignature(result, qHashBits(buf.constData(),
+                                                        static_cast<size_t>(size)));
+        }
+    }
+    *signature = result;
+    return true;
+}
+
+/**
+ * @brief Map a bin address to the address shown to the user, the same way "i*j" commands do.
+ */
+static RVA binVirtualAddress(RCore *core, ut64 paddr, ut64 vaddr)
+{
+    if (!r_config_get_i(core->config, "io.va")) {
+        return paddr;
+    }
+    return r_bin_get_vaddr(core->bin, paddr, vaddr);
+}
 
 static void cutterREventCallback(REvent *, int type, void *user, void *data)
 {
@@ -153,8 +221,137 @@ static void cutterREventCallback(REvent *, int type, void *user, void *data)
 }
 
 CutterCore::CutterCore(QObject *parent) :
-    QObject(parent), coreMutex(QMutex::Recursive)
+    QObject(parent)
+{
+    connect(this, &CutterCore::breakpointsChanged, this, &CutterCore::invalidateBreakpointAddresses);
+    connect(this, &CutterCore::refreshCodeViews, this, &CutterCore::invalidateBreakpointAddresses);
+    connect(this, &CutterCore::refreshAll, this, &CutterCore::invalidateBreakpointAddresses);
+    // Breakpoints get moved when the debugged process is rebased
+    connect(this, &CutterCore::codeRebased, this, &CutterCore::invalidateBreakpointAddresses);
+    connect(this, &CutterCore::debugTaskStateChanged, this,
+            &CutterCore::invalidateBreakpointAddresses);
+
+    // Connected before any view, so views refreshing on these see the new revision
+    connect(this, &CutterCore::refreshAll, this, &CutterCore::bumpAnalysisRevision);
+    connect(this, &CutterCore::refreshCodeViews, this, &CutterCore::bumpAnalysisRevision);
+    connect(this, &CutterCore::functionsChanged, this, &CutterCore::bumpAnalysisRevision);
+    connect(this, &CutterCore::functionRenamed, this, &CutterCore::bumpAnalysisRevision);
+    connect(this, &CutterCore::varsChanged, this, &CutterCore::bumpAnalysisRevision);
+    connect(this, &CutterCore::flagsChanged, this, &CutterCore::bumpAnalysisRevision);
+    connect(this, &CutterCore::commentsChanged, this, &CutterCore::bumpAnalysisRevision);
+    connect(this, &CutterCore::instructionChanged, this, &CutterCore::bumpAnalysisRevision);
+    connect(this, &CutterCore::asmOptionsChanged, this, &CutterCore::bumpAnalysisRevision);
+    connect(this, &CutterCore::codeRebased, this, &CutterCore::bumpAnalysisRevision);
+    // Steps and debug tasks may write code, e.g. when unpacking, but mostly only write data
+    connect(this, &CutterCore::registersChanged, this, &CutterCore::checkCodeWritten);
+    connect(this, &CutterCore::debugTaskStateChanged, this, &CutterCore::checkCodeWritten);
+}
+
+void CutterCore::lockCore(CoreAccess access, const char *caller)
+{
+    Qt::HANDLE self = QThread::currentThreadId();
+    QMutexLocker locker(&coreLockStateMutex);
+    if (coreLockOwner == self) {
+        assert(coreLockDepth > 0);
+        coreLockDepth++;
+        return;
+    }
+
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    const char *blockedBy = coreLockCaller;
+    bool isRead = access == CoreAccess::Read;
+    if (isRead) {
+        // Writers let every waiting reader go first, but a reader arriving while writers
+        // wait only gets in after those writers, so a stream of reads can't starve a write.
+        quint64 turn = coreLockWritersServed + coreLockWriteWaiters;
+        if (turn == coreLockWritersServed) {
+            coreLockReadWaiters++;
+        } else {
+            coreLockDeferredReaders[turn]++;
+        }
+        while (coreLockOwner || coreLockWritersServed < turn) {
+            coreLockReleased.wait(&coreLockStateMutex);
+        }
+        coreLockReadWaiters--;
+    } else {
+        coreLockWriteWaiters++;
+        while (coreLockOwner || coreLockReadWaiters > 0) {
+            coreLockReleased.wait(&coreLockStateMutex);
+        }
+        coreLockWriteWaiters--;
+        coreLockWritersServed++;
+        // Readers that were queued behind this writer are now ahead of any later writer
+        auto it = coreLockDeferredReaders.begin();
+        while (it != coreLockDeferredReaders.end() && it.key() <= coreLockWritersServed) {
+            coreLockReadWaiters += it.value();
+            it = coreLockDeferredReaders.erase(it);
+        }
+    }
+    qint64 waitNs = waitTimer.nsecsElapsed();
+
+    assert(coreLockDepth == 0);
+    coreLockOwner = self;
+    coreLockDepth = 1;
+    coreLockCaller = caller;
+
+    CoreLockStatistics &stats = coreLockStats[caller];
+    stats.count++;
+    stats.totalWaitNs += waitNs;
+    stats.maxWaitNs = std::max(stats.maxWaitNs, waitNs);
+    locker.unlock();
+
+    if (waitNs > CORE_LOCK_SLOW_WAIT_NS && QCoreApplication::instance()
+            && QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        qWarning() << (caller ? caller : "unknown") << "waited" << waitNs / 1000000
+                   << "ms for the core held by" << (blockedBy ? blockedBy : "unknown");
+    }
+
+    assert(coreBed);
+    r_cons_sleep_end(coreBed);
+    coreBed = nullptr;
+    coreLockHoldTimer.start();
+}
+
+void CutterCore::unlockCore()
 {
+    assert(coreLockOwner == QThread::currentThreadId());
+    assert(coreLockDepth > 0);
+    if (coreLockDepth > 1) {
+        coreLockDepth--;
+        return;
+    }
+
+    qint64 holdNs = coreLockHoldTimer.nsecsElapsed();
+    coreBed = r_cons_sleep_begin();
+
+    QMutexLocker locker(&coreLockStateMutex);
+    CoreLockStatistics &stats = coreLockStats[coreLockCaller];
+    stats.totalHoldNs += holdNs;
+    stats.maxHoldNs = std::max(stats.maxHoldNs, holdNs);
+
+    coreLockDepth = 0;
+    coreLockOwner = nullptr;
+    coreLockCaller = nullptr;
+    coreLockReleased.wakeAll();
+}
+
+QList<CoreLockStatistics> CutterCore::getCoreLockStatistics()
+{
+    QMutexLocker locker(&coreLockStateMutex);
+    QList<CoreLockStatistics> ret;
+    for (auto it = coreLockStats.constBegin(); it != coreLockStats.constEnd(); ++it) {
+        CoreLockStatistics stats = it.value();
+        stats.caller = it.key() ? QString::fromUtf8(it.key()) : QStringLiteral("unknown");
+        ret << stats;
+    }
+    return ret;
+}
+
+void CutterCore::resetCoreLockStatistics()
+{
+    QMutexLocker locker(&coreLockStateMutex);
+    coreLockStats.clear();
 }
 
 CutterCore *CutterCore::instance()
@@ -207,10 +404,31 @@ void CutterCore::initialize()
 
     // Initialize Async tasks manager
     asyncTaskManager = new AsyncTaskManager(this);
+
+    // Created before any view so it is invalidated before views refresh
+    ioPageCache = new IOPageCache(this);
+    sectionStatistics = new SectionStatistics(this);
+    previewCache = new PreviewCache(this);
+    debugState = new DebugStateSnapshot(this);
+    telescope = new Telescope();
+    traceManager = new TraceManager(this);
+    esilRunner = new EsilRunner();
 }
 
 CutterCore::~CutterCore()
 {
+    // Wait for pending reads and recordings before the core is freed
+    delete traceManager;
+    delete ioPageCache;
+    delete sectionStatistics;
+    delete previewCache;
+    delete debugState;
+    delete telescope;
+    if (esilRunTask) {
+        esilRunTask->interrupt();
+        esilRunTask->wait();
+    }
+    delete esilRunner;
     delete bbHighlighter;
     r_cons_sleep_end(coreBed);
     r_core_task_sync_end(&core_->tasks);
@@ -220,7 +438,7 @@ CutterCore::~CutterCore()
 
 RCoreLocked CutterCore::core()
 {
-    return RCoreLocked(this);
+    return RCoreLocked(this, CoreAccess::Write, Q_FUNC_INFO);
 }
 
 void CutterCore::loadCutterRC()
@@ -242,7 +460,7 @@ void CutterCore::loadCutterRC()
 
 QList<QString> CutterCore::sdbList(QString path)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<QString> list = QList<QString>();
     Sdb *root = sdb_ns_path(core->sdb, path.toUtf8().constData(), 0);
     if (root) {
@@ -264,7 +482,7 @@ static SdbListPtr makeSdbListPtr(SdbList *list)
 
 QList<QString> CutterCore::sdbListKeys(QString path)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<QString> list = QList<QString>();
     Sdb *root = sdb_ns_path(core->sdb, path.toUtf8().constData(), 0);
     if (root) {
@@ -281,7 +499,7 @@ QList<QString> CutterCore::sdbListKeys(QString path)
 
 QString CutterCore::sdbGet(QString path, QString key)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     Sdb *db = sdb_ns_path(core->sdb, path.toUtf8().constData(), 0);
     if (db) {
         const char *val = sdb_const_get(db, key.toUtf8().constData(), 0);
@@ -340,7 +558,11 @@ bool CutterCore::isRedirectableDebugee()
 
 bool CutterCore::isDebugTaskInProgress()
 {
-    if (!debugTask.isNull()) {
+    if (!debugTask.isNull() || !esilRunTask.isNull()) {
+        return true;
+    }
+
+    if (traceManager && traceManager->isRecording()) {
         return true;
     }
 
@@ -355,6 +577,12 @@ bool CutterCore::asyncCmdEsil(const char *command, QSharedPointer<R2Task> &task)
         return false;
     }
 
+    {
+        // So the decoded instructions and the analysis revision follow what it writes
+        CORE_LOCK();
+        esilRunner->attach(core);
+    }
+
     connect(task.data(), &R2Task::finished, task.data(), [this, task] () {
         QString res = task.data()->getResult();
 
@@ -582,7 +810,12 @@ void CutterCore::renameFunction(const QString &oldName, const QString &newName)
 
 void CutterCore::delFunction(RVA addr)
 {
+    RAnalFunction *fcn = functionIn(addr);
+    RVA offset = fcn ? fcn->addr : RVA_INVALID;
     cmd("af- " + RAddressString(addr));
+    if (offset != RVA_INVALID && !functionAt(offset)) {
+        emit functionRemoved(offset);
+    }
     emit functionsChanged();
 }
 
@@ -641,6 +874,7 @@ void CutterCore::editBytes(RVA addr, const QString &bytes)
 void CutterCore::editBytesEndian(RVA addr, const QString &bytes)
 {
     cmd("wv " + bytes + " @ " + RAddressString(addr));
+    debugState->invalidate();
     emit stackChanged();
 }
 
@@ -887,19 +1121,19 @@ void CutterCore::setConfig(const char *k, bool v)
 
 int CutterCore::getConfigi(const char *k)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     return static_cast<int>(r_config_get_i(core->config, k));
 }
 
 ut64 CutterCore::getConfigut64(const char *k)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     return r_config_get_i(core->config, k);
 }
 
 bool CutterCore::getConfigb(const char *k)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     return r_config_get_i(core->config, k) != 0;
 }
 
@@ -908,6 +1142,16 @@ void CutterCore::triggerRefreshAll()
     emit refreshAll();
 }
 
+void CutterCore::triggerDebugStateChanged()
+{
+    if (!currentlyDebugging) {
+        return;
+    }
+    debugState->invalidate();
+    emit registersChanged();
+    emit stackChanged();
+}
+
 void CutterCore::triggerAsmOptionsChanged()
 {
     emit asmOptionsChanged();
@@ -932,7 +1176,7 @@ void CutterCore::message(const QString &msg, bool debug)
 
 QString CutterCore::getConfig(const char *k)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     return QString(r_config_get(core->config, k));
 }
 
@@ -998,7 +1242,7 @@ QString CutterCore::disassembleSingleInstruction(RVA addr)
 
 RAnalFunction *CutterCore::functionIn(ut64 addr)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     RList *fcns = r_anal_get_functions_in (core->anal, addr);
     RAnalFunction *fcn = !r_list_empty(fcns) ? reinterpret_cast<RAnalFunction *>(r_list_first(fcns)) : nullptr;
     r_list_free(fcns);
@@ -1007,7 +1251,7 @@ RAnalFunction *CutterCore::functionIn(ut64 addr)
 
 RAnalFunction *CutterCore::functionAt(ut64 addr)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     return r_anal_get_function_at(core->anal, addr);
 }
 
@@ -1018,7 +1262,7 @@ RAnalFunction *CutterCore::functionAt(ut64 addr)
  */
 RVA CutterCore::getFunctionStart(RVA addr)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     RAnalFunction *fcn = Core()->functionIn(addr);
     return fcn ? fcn->addr : RVA_INVALID;
 }
@@ -1030,11 +1274,39 @@ RVA CutterCore::getFunctionStart(RVA addr)
  */
 RVA CutterCore::getFunctionEnd(RVA addr)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     RAnalFunction *fcn = Core()->functionIn(addr);
     return fcn ? fcn->addr : RVA_INVALID;
 }
 
+QList<RVA> CutterCore::getCallNeighbourFunctions(RVA addr)
+{
+    CORE_LOCK_READ();
+    QList<RVA> result;
+    RAnalFunction *fcn = functionIn(addr);
+    if (!fcn) {
+        return result;
+    }
+    QJsonArray functionsArray = cmdj("afij @ " + QString::number(fcn->addr)).array();
+    if (functionsArray.isEmpty()) {
+        return result;
+    }
+    QJsonObject fcnObject = functionsArray.first().toObject();
+    for (const QString &key : { RJsonKey::callrefs, RJsonKey::codexrefs }) {
+        for (const QJsonValue &value : fcnObject[key].toArray()) {
+            QJsonObject refObject = value.toObject();
+            if (refObject[RJsonKey::type].toString() != QLatin1String("C")) {
+                continue;
+            }
+            RAnalFunction *other = functionIn(refObject[RJsonKey::addr].toVariant().toULongLong());
+            if (other && other != fcn && !result.contains(other->addr)) {
+                result << other->addr;
+            }
+        }
+    }
+    return result;
+}
+
 /**
  * @brief finds the last instruction of a function in a given address
  * @param addr - an address which belongs to a function
@@ -1042,7 +1314,7 @@ RVA CutterCore::getFunctionEnd(RVA addr)
  */
 RVA CutterCore::getLastFunctionInstruction(RVA addr)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     RAnalFunction *fcn = Core()->functionIn(addr);
     if (!fcn) {
         return RVA_INVALID;
@@ -1074,6 +1346,9 @@ void CutterCore::cmdEsil(const char *command)
 QString CutterCore::createFunctionAt(RVA addr)
 {
     QString ret = cmd("af " + RAddressString(addr));
+    if (functionAt(addr)) {
+        emit functionAdded(addr);
+    }
     emit functionsChanged();
     return ret;
 }
@@ -1084,6 +1359,9 @@ QString CutterCore::createFunctionAt(RVA addr, QString name)
     name.remove(regExp);
     QString command = "af " + name + " @ " + RAddressString(addr);
     QString ret = cmd(command);
+    if (functionAt(addr)) {
+        emit functionAdded(addr);
+    }
     emit functionsChanged();
     return ret;
 }
@@ -1147,142 +1425,53 @@ QJsonDocument CutterCore::getSignatureInfo()
     return cmdj("iCj");
 }
 
-QList<QJsonObject> CutterCore::getStack(int size, int depth)
+QList<AddrRefChain> CutterCore::getStack(int size, int depth)
 {
-    QList<QJsonObject> stack;
+    QList<AddrRefChain> stack;
     if (!currentlyDebugging) {
         return stack;
     }
 
-    CORE_LOCK();
+    CORE_LOCK_READ();
     bool ret;
     RVA addr = cmd("dr SP").toULongLong(&ret, 16);
     if (!ret) {
         return stack;
     }
 
-    int base = core->anal->bits;
-    for (int i = 0; i < size; i += base / 8) {
-        if ((base == 32 && addr + i >= UT32_MAX) || (base == 16 && addr + i >= UT16_MAX)) {
-            break;
-        }
-
-        stack.append(getAddrRefs(addr + i, depth));
-    }
-
-    return stack;
+    return telescope->telescopeRange(core, addr, size, depth);
 }
 
 QJsonObject CutterCore::getAddrRefs(RVA addr, int depth) {
-    QJsonObject json;
-    if (depth < 1 || addr == UT64_MAX) {
-        return json;
-    }
+    CORE_LOCK_READ();
+    AddrRefChain chain = telescope->telescope(core, addr, depth);
 
-    CORE_LOCK();
-    int bits = core->assembler->bits;
-    QByteArray buf = QByteArray();
-    ut64 type = r_core_anal_address(core, addr);
-
-    json["addr"] = QString::number(addr);
-
-    // Search for the section the addr is in, avoid duplication for heap/stack with type
-    if(!(type & R_ANAL_ADDR_TYPE_HEAP || type & R_ANAL_ADDR_TYPE_STACK)) {
-        // Attempt to find the address within a map
-        RDebugMap *map = r_debug_map_get(core->dbg, addr);
-        if (map && map->name && map->name[0]) {
-            json["mapname"] = map->name;
-        }
-
-        RBinSection *sect = r_bin_get_section_at(r_bin_cur_object (core->bin), addr, true);
-        if (sect && sect->name[0]) {
-            json["section"] = sect->name;
-        }
-    }
-
-    // Check if the address points to a register
-    RFlagItem *fi = r_flag_get_i(core->flags, addr);
-    if (fi) {
-        RRegItem *r = r_reg_get(core->dbg->reg, fi->name, -1);
-        if (r) {
-            json["reg"] = r->name;
-        }
-    }
-
-    // Attempt to find the address within a function
-    RAnalFunction *fcn = r_anal_get_fcn_in(core->anal, addr, 0);
-    if (fcn) {
-        json["fcn"] = fcn->name;
-    }
-
-    // Update type and permission information
-    if (type != 0) {
-        if (type & R_ANAL_ADDR_TYPE_HEAP) {
-            json["type"] = "heap";
-        } else if (type & R_ANAL_ADDR_TYPE_STACK) {
-            json["type"] = "stack";
-        } else if (type & R_ANAL_ADDR_TYPE_PROGRAM) {
-            json["type"] = "program";
-        } else if (type & R_ANAL_ADDR_TYPE_LIBRARY) {
-            json["type"] = "library";
-        } else if (type & R_ANAL_ADDR_TYPE_ASCII) {
-            json["type"] = "ascii";
-        } else if (type & R_ANAL_ADDR_TYPE_SEQUENCE) {
-            json["type"] = "sequence";
-        }
-
-        QString perms = "";
-        if (type & R_ANAL_ADDR_TYPE_READ) {
-            perms += "r";
-        }
-        if (type & R_ANAL_ADDR_TYPE_WRITE) {
-            perms += "w";
-        }
-        if (type & R_ANAL_ADDR_TYPE_EXEC) {
-            RAsmOp op;
-            buf.resize(32);
-            perms += "x";
-            // Instruction disassembly
-            r_io_read_at(core->io, addr, (unsigned char*)buf.data(), buf.size());
-            r_asm_set_pc(core->assembler, addr);
-            r_asm_disassemble(core->assembler, &op, (unsigned char*)buf.data(), buf.size());
-            json["asm"] = r_asm_op_get_asm(&op);
-        }
-
-        if (!perms.isEmpty()) {
-            json["perms"] = perms;
-        }
-    }
-
-    // Try to telescope further if depth permits it
-    if ((type & R_ANAL_ADDR_TYPE_READ) && !(type & R_ANAL_ADDR_TYPE_EXEC)) {
-        buf.resize(64);
-        ut32 *n32 = (ut32 *)buf.data();
-        ut64 *n64 = (ut64 *)buf.data();
-        r_io_read_at(core->io, addr, (unsigned char*)buf.data(), buf.size());
-        ut64 n = (bits == 64)? *n64: *n32;
-        // The value of the next address will serve as an indication that there's more to
-        // telescope if we have reached the depth limit
-        json["value"] = QString::number(n);
-        if (depth && n != addr) {
-            // Make sure we aren't telescoping the same address
-            QJsonObject ref = getAddrRefs(n, depth - 1);
-            if (!ref.empty() && !ref["type"].isNull()) {
-                // If the dereference of the current pointer is an ascii character we
-                // might have a string in this address
-                if (ref["type"].toString().contains("ascii")) {
-                    buf.resize(128);
-                    r_io_read_at(core->io, addr, (unsigned char*)buf.data(), buf.size());
-                    QString strVal = QString(buf);
-                    // Indicate that the string is longer than the printed value
-                    if (strVal.size() == buf.size()) {
-                        strVal += "...";
-                    }
-                    json["string"] = strVal;
-                }
-                json["ref"] = ref;
+    // Nested from the innermost address outwards
+    QJsonObject json;
+    for (int i = chain.size() - 1; i >= 0; i--) {
+        const AddrRefDescription &ref = chain.at(i);
+        QJsonObject refJson;
+        refJson["addr"] = QString::number(ref.addr);
+        auto insertIfSet = [&refJson](const QString &key, const QString &value) {
+            if (!value.isEmpty()) {
+                refJson[key] = value;
             }
+        };
+        insertIfSet("mapname", ref.mapname);
+        insertIfSet("section", ref.section);
+        insertIfSet("reg", ref.reg);
+        insertIfSet("fcn", ref.fcn);
+        insertIfSet("type", ref.type);
+        insertIfSet("perms", ref.perms);
+        insertIfSet("asm", ref.asmText);
+        insertIfSet("string", ref.string);
+        if (ref.hasValue) {
+            refJson["value"] = QString::number(ref.value);
+        }
+        if (!json.isEmpty()) {
+            refJson["ref"] = json;
         }
+        json = refJson;
     }
     return json;
 }
@@ -1393,6 +1582,7 @@ RVA CutterCore::getProgramCounterValue()
 void CutterCore::setRegister(QString regName, QString regValue)
 {
     cmd("dr " + regName + "=" + regValue);
+    debugState->invalidate();
     emit registersChanged();
     emit refreshCodeViews();
 }
@@ -1505,6 +1695,10 @@ void CutterCore::startEmulation()
             currentlyEmulating = true;
             emit toggleDebugView();
         }
+        {
+            CORE_LOCK();
+            esilRunner->attach(core);
+        }
 
         emit registersChanged();
         emit stackChanged();
@@ -1618,6 +1812,14 @@ void CutterCore::attachDebug(int pid)
 
 void CutterCore::suspendDebug()
 {
+    if (traceManager->isRecording()) {
+        traceManager->stopRecording();
+        return;
+    }
+    if (esilRunTask) {
+        esilRunTask->interrupt();
+        return;
+    }
     debugTask->breakTask();
 }
 
@@ -1627,14 +1829,21 @@ void CutterCore::stopDebug()
         return;
     }
 
-    if (!debugTask.isNull()) {
+    if (isDebugTaskInProgress()) {
         suspendDebug();
     }
+    if (esilRunTask) {
+        esilRunTask->wait();
+    }
 
     currentlyDebugging = false;
     emit debugTaskStateChanged();
 
     if (currentlyEmulating) {
+        {
+            CORE_LOCK();
+            esilRunner->detach(core);
+        }
         cmdEsil("aeim-; aei-; wcr; .ar-");
         currentlyEmulating = false;
     } else if (currentlyAttachedToPID != -1) {
@@ -1671,6 +1880,35 @@ void CutterCore::syncAndSeekProgramCounter()
     emit registersChanged();
 }
 
+void CutterCore::invalidateEmulatedCode()
+{
+    if (!esilRunner) {
+        return;
+    }
+    CORE_LOCK();
+    esilRunner->clear();
+}
+
+void CutterCore::checkCodeWritten()
+{
+    // Anything written by a task still running is seen once it is finished
+    if (!currentlyDebugging || isDebugTaskInProgress()) {
+        return;
+    }
+    CORE_LOCK();
+    bool written;
+    if (currentlyEmulating) {
+        written = esilRunner->takeCodeWritten();
+    } else {
+        quint64 signature;
+        written = !nativeCodeSignature(core, &signature) || signature != codeSignature;
+        codeSignature = signature;
+    }
+    if (written) {
+        bumpAnalysisRevision();
+    }
+}
+
 void CutterCore::continueDebug()
 {
     if (!currentlyDebugging) {
@@ -1678,13 +1916,12 @@ void CutterCore::continueDebug()
     }
 
     if (currentlyEmulating) {
-        if (!asyncCmdEsil("aec", debugTask)) {
-            return;
-        }
-    } else {
-        if (!asyncCmd("dc", debugTask)) {
-            return;
-        }
+        continueEmulation(RVA_INVALID);
+        return;
+    }
+
+    if (!asyncCmd("dc", debugTask)) {
+        return;
     }
 
     emit debugTaskStateChanged();
@@ -1706,13 +1943,12 @@ void CutterCore::continueUntilDebug(QString offset)
     }
 
     if (currentlyEmulating) {
-        if (!asyncCmdEsil("aecu " + offset, debugTask)) {
-            return;
-        }
-    } else {
-        if (!asyncCmd("dcu " + offset, debugTask)) {
-            return;
-        }
+        continueEmulation(math(offset));
+        return;
+    }
+
+    if (!asyncCmd("dcu " + offset, debugTask)) {
+        return;
     }
 
     emit debugTaskStateChanged();
@@ -1786,70 +2022,164 @@ void CutterCore::stepDebug()
         return;
     }
 
-    if (currentlyEmulating) {
-        if (!asyncCmdEsil("aes", debugTask)) {
-            return;
-        }
-    } else {
-        if (!asyncCmd("ds", debugTask)) {
-            return;
-        }
-    }
+    queueStep(currentlyEmulating ? "aes" : "ds");
+}
 
-    emit debugTaskStateChanged();
-    connect(debugTask.data(), &R2Task::finished, this, [this] () {
-        debugTask.clear();
-        syncAndSeekProgramCounter();
-        emit debugTaskStateChanged();
-    });
+void CutterCore::stepOverDebug()
+{
+    if (!currentlyDebugging) {
+        return;
+    }
 
-    debugTask->startTask();
+    queueStep(currentlyEmulating ? "aeso" : "dso");
 }
 
-void CutterCore::stepOverDebug()
+void CutterCore::stepOutDebug()
 {
     if (!currentlyDebugging) {
         return;
     }
 
-    if (currentlyEmulating) {
-        if (!asyncCmdEsil("aeso", debugTask)) {
-            return;
-        }
-    } else {
-        if (!asyncCmd("dso", debugTask)) {
-            return;
+    queueStep("dsf");
+}
+
+void CutterCore::queueStep(const QString &command)
+{
+    if (isDebugTaskInProgress()) {
+        // Held step keys only add to the next batch instead of being dropped
+        if (stepping && (queuedSteps == 0 || queuedStepCommand == command)) {
+            queuedStepCommand = command;
+            queuedSteps++;
         }
+        return;
     }
 
+    if (!runSteps(command, 1)) {
+        return;
+    }
+    stepping = true;
+    stepRefreshTimer.start();
     emit debugTaskStateChanged();
-    connect(debugTask.data(), &R2Task::finished, this, [this] () {
-        debugTask.clear();
-        syncAndSeekProgramCounter();
+}
+
+bool CutterCore::runSteps(const QString &command, int count)
+{
+    auto finished = [this] () {
+        if (queuedSteps > 0 && currentlyDebugging) {
+            QString command = queuedStepCommand;
+            int count = queuedSteps;
+            queuedSteps = 0;
+
+            // Only refresh the views if the last refresh is at least a frame ago
+            int frameMs = 1000 / qMax(1, Config()->getDebugRefreshRate());
+            if (stepRefreshTimer.elapsed() >= frameMs) {
+                seekToProgramCounter();
+                stepRefreshTimer.restart();
+            }
+            if (runSteps(command, count)) {
+                return;
+            }
+        }
+        stepping = false;
+        queuedSteps = 0;
+        seekToProgramCounter();
         emit debugTaskStateChanged();
+    };
+
+    if (command == "aes") {
+        return runEmulation(RVA_INVALID, static_cast<quint64>(count), finished);
+    }
+
+    QStringList commands;
+    for (int i = 0; i < count; i++) {
+        commands << command;
+    }
+    QString batch = commands.join(";");
+    bool started = command.startsWith("ae") ? asyncCmdEsil(batch, debugTask)
+                                            : asyncCmd(batch, debugTask);
+    if (!started) {
+        return false;
+    }
+
+    // Later batches do not announce themselves with debugTaskStateChanged
+    debugState->invalidate();
+    connect(debugTask.data(), &R2Task::finished, this, [this, finished] () {
+        debugTask.clear();
+        finished();
     });
 
     debugTask->startTask();
+    return true;
 }
 
-void CutterCore::stepOutDebug()
+bool CutterCore::runEmulation(RVA until, quint64 maxSteps, std::function<void()> finished)
 {
-    if (!currentlyDebugging) {
-        return;
+    if (isDebugTaskInProgress()) {
+        return false;
     }
 
-    emit debugTaskStateChanged();
-    if (!asyncCmd("dsf", debugTask)) {
-        return;
+    esilRunTask.reset(new EsilRunTask(esilRunner, until, maxSteps));
+    EsilRunTask *task = esilRunTask.data();
+    connect(task, &AsyncTask::finished, this, [this, task, finished] () {
+        if (task != esilRunTask.data()) {
+            return;
+        }
+        EsilRunState state = task->getState();
+        esilRunTask.clear();
+
+        if (currentlyEmulating) {
+            setEmulatedRegisters(state);
+        }
+        if (state.stopReason == EsilRunState::InvalidInstruction) {
+            msgBox.showMessage("Stopped when attempted to run an invalid instruction. You can disable this in Preferences");
+        }
+        finished();
+    });
+    // Long runs show where they are, the task has moved on by the time this is called
+    connect(task, &EsilRunTask::stateUpdated, this, [this, task] () {
+        if (task != esilRunTask.data() || !currentlyEmulating) {
+            return;
+        }
+        setEmulatedRegisters(task->getState());
+        seekToProgramCounter();
+    }, Qt::QueuedConnection);
+
+    // Later runs of queued steps do not announce themselves with debugTaskStateChanged
+    debugState->invalidate();
+    asyncTaskManager->start(esilRunTask);
+    return true;
+}
+
+void CutterCore::setEmulatedRegisters(const EsilRunState &state)
+{
+    // The registers are already known, the views don't have to ask r2 for them again
+    QJsonObject registerValues;
+    for (int i = 0; i < state.registerNames.size(); i++) {
+        registerValues.insert(state.registerNames[i], static_cast<double>(state.registerValues[i]));
     }
+    debugState->setRegisters(state.pc, registerValues);
+}
 
-    connect(debugTask.data(), &R2Task::finished, this, [this] () {
-        debugTask.clear();
-        syncAndSeekProgramCounter();
+void CutterCore::continueEmulation(RVA until)
+{
+    bool started = runEmulation(until, 0, [this] () {
+        seekToProgramCounter();
+        emit stackChanged();
+        emit refreshCodeViews();
         emit debugTaskStateChanged();
     });
+    if (started) {
+        emit debugTaskStateChanged();
+    }
+}
 
-    debugTask->startTask();
+void CutterCore::seekToProgramCounter()
+{
+    RVA programCounter = debugState->getProgramCounter();
+    if (programCounter != RVA_INVALID) {
+        seekAndShow(programCounter);
+    }
+    emit registersChanged();
 }
 
 QStringList CutterCore::getDebugPlugins()
@@ -2024,13 +2354,13 @@ static BreakpointDescription breakpointDescriptionFromR2(int index, r_bp_item_t
 
 int CutterCore::breakpointIndexAt(RVA addr)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     return r_bp_get_index_at(core->dbg->bp, addr);
 }
 
 BreakpointDescription CutterCore::getBreakpointAt(RVA addr)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     int index = breakpointIndexAt(addr);
     auto bp = r_bp_get_index(core->dbg->bp, index);
     if (bp) {
@@ -2041,7 +2371,7 @@ BreakpointDescription CutterCore::getBreakpointAt(RVA addr)
 
 QList<BreakpointDescription> CutterCore::getBreakpoints()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<BreakpointDescription> ret;
     //TODO: use higher level API, don't touch r2 bps_idx directly
     for (int i = 0; i < core->dbg->bp->bps_idx_count; i++) {
@@ -2054,32 +2384,96 @@ QList<BreakpointDescription> CutterCore::getBreakpoints()
 }
 
 
-QList<RVA> CutterCore::getBreakpointsAddresses()
+void CutterCore::invalidateBreakpointAddresses()
 {
-    QList<RVA> bpAddresses;
-    for (const BreakpointDescription &bp : getBreakpoints()) {
-        bpAddresses << bp.addr;
+    CORE_LOCK_READ();
+    breakpointAddressesValid = false;
+}
+
+void CutterCore::updateBreakpointAddresses()
+{
+    CORE_LOCK_READ();
+    RBreakpoint *bp = core->dbg->bp;
+    // Breakpoints changed from the console don't emit breakpointsChanged, so the index is also
+    // rebuilt whenever the breakpoints differ from those it was built from. Checking that takes
+    // a pass over them, but no sort and no allocation.
+    quint64 signature = Q_UINT64_C(0xcbf29ce484222325);
+    int itemCount = 0;
+    for (int i = 0; i < bp->bps_idx_count; i++) {
+        if (auto bpi = bp->bps_idx[i]) {
+            signature = combineSignature(signature, static_cast<quint64>(i));
+            signature = combineSignature(signature, bpi->addr);
+            signature = combineSignature(signature, static_cast<quint64>(bpi->enabled));
+            itemCount++;
+        }
+    }
+    if (breakpointAddressesValid && signature == breakpointAddressesSignature) {
+        return;
     }
+    breakpointAddresses.clear();
+    breakpointAddresses.reserve(itemCount);
+    for (int i = 0; i < bp->bps_idx_count; i++) {
+        if (auto bpi = bp->bps_idx[i]) {
+            breakpointAddresses.append(bpi->addr);
+        }
+    }
+    std::sort(breakpointAddresses.begin(), breakpointAddresses.end());
+    breakpointAddresses.erase(std::unique(breakpointAddresses.begin(), breakpointAddresses.end()),
+                              breakpointAddresses.end());
+    breakpointAddressesSignature = signature;
+    breakpointAddressesValid = true;
+}
+
+QVector<RVA> CutterCore::getBreakpointsAddresses()
+{
+    CORE_LOCK_READ();
+    updateBreakpointAddresses();
+    return breakpointAddresses;
+}
 
-    return bpAddresses;
+QVector<RVA> CutterCore::getBreakpointsInRange(RVA from, RVA to)
+{
+    CORE_LOCK_READ();
+    updateBreakpointAddresses();
+    auto begin = std::lower_bound(breakpointAddresses.constBegin(), breakpointAddresses.constEnd(),
+                                  from);
+    auto end = std::lower_bound(begin, breakpointAddresses.constEnd(), to);
+    QVector<RVA> ret;
+    ret.reserve(static_cast<int>(end - begin));
+    std::copy(begin, end, std::back_inserter(ret));
+    return ret;
 }
 
 QList<RVA> CutterCore::getBreakpointsInFunction(RVA funcAddr)
 {
-    QList<RVA> allBreakpoints = getBreakpointsAddresses();
+    CORE_LOCK_READ();
     QList<RVA> functionBreakpoints;
+    RAnalFunction *fcn = r_anal_get_function_at(core->anal, funcAddr);
+    if (!fcn) {
+        return functionBreakpoints;
+    }
 
-    // Use std manipulations to take only the breakpoints that belong to this function
-    std::copy_if(allBreakpoints.begin(),
-             allBreakpoints.end(),
-             std::back_inserter(functionBreakpoints),
-             [this, funcAddr](RVA BPadd) { return getFunctionStart(BPadd) == funcAddr; });
+    // Only the breakpoints inside the function bounds can belong to it
+    RVA minAddr = r_anal_function_min_addr(fcn);
+    RVA maxAddr = r_anal_function_max_addr(fcn);
+    for (RVA addr : getBreakpointsInRange(minAddr, maxAddr)) {
+        if (getFunctionStart(addr) == funcAddr) {
+            functionBreakpoints << addr;
+        }
+    }
     return functionBreakpoints;
 }
 
-bool CutterCore::isBreakpoint(const QList<RVA> &breakpoints, RVA addr)
+bool CutterCore::isBreakpoint(const QVector<RVA> &breakpoints, RVA addr)
+{
+    return std::binary_search(breakpoints.constBegin(), breakpoints.constEnd(), addr);
+}
+
+bool CutterCore::isBreakpoint(RVA addr)
 {
-    return breakpoints.contains(addr);
+    CORE_LOCK_READ();
+    updateBreakpointAddresses();
+    return isBreakpoint(breakpointAddresses, addr);
 }
 
 QJsonDocument CutterCore::getBacktrace()
@@ -2194,7 +2588,7 @@ void CutterCore::setSettings()
 
 QList<RVA> CutterCore::getSeekHistory()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<RVA> ret;
 
     QJsonArray jsonArray = cmdj("sj").array();
@@ -2206,7 +2600,7 @@ QList<RVA> CutterCore::getSeekHistory()
 
 QStringList CutterCore::getAsmPluginNames()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     RListIter *it;
     QStringList ret;
 
@@ -2220,7 +2614,7 @@ QStringList CutterCore::getAsmPluginNames()
 
 QStringList CutterCore::getAnalPluginNames()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     RListIter *it;
     QStringList ret;
 
@@ -2317,7 +2711,7 @@ QList<RCorePluginDescription> CutterCore::getRCorePluginDescriptions()
 
 QList<RAsmPluginDescription> CutterCore::getRAsmPluginDescriptions()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     RListIter *it;
     QList<RAsmPluginDescription> ret;
 
@@ -2339,9 +2733,37 @@ QList<RAsmPluginDescription> CutterCore::getRAsmPluginDescriptions()
     return ret;
 }
 
-QList<FunctionDescription> CutterCore::getAllFunctions()
+static FunctionDescription functionDescriptionFromR2(RAnalFunction *fcn)
 {
-    CORE_LOCK();
+    FunctionDescription function;
+    function.offset = fcn->addr;
+    function.linearSize = r_anal_function_linear_size(fcn);
+    function.nargs = 0;
+    function.nlocals = 0;
+    function.nbbs = r_list_length (fcn->bbs);
+    function.calltype = fcn->cc ? QString::fromUtf8(fcn->cc) : QString();
+    function.name = fcn->name ? QString::fromUtf8(fcn->name) : QString();
+    function.edges = 0;
+    function.stackframe = fcn->maxstack;
+    function.detailsLoaded = false;
+    return function;
+}
+
+static void loadFunctionDetailsFromR2(RAnal *anal, RAnalFunction *fcn, FunctionDescription &function)
+{
+    function.nargs = r_anal_var_count(anal, fcn, 'b', 1) +
+        r_anal_var_count(anal, fcn, 'r', 1) +
+        r_anal_var_count(anal, fcn, 's', 1);
+    function.nlocals = r_anal_var_count(anal, fcn, 'b', 0) +
+        r_anal_var_count(anal, fcn, 'r', 0) +
+        r_anal_var_count(anal, fcn, 's', 0);
+    function.edges = r_anal_fcn_count_edges(fcn, nullptr);
+    function.detailsLoaded = true;
+}
+
+QList<FunctionDescription> CutterCore::getAllFunctions(bool withDetails)
+{
+    CORE_LOCK_READ();
 
     QList<FunctionDescription> funcList;
     funcList.reserve(r_list_length(core->anal->fcns));
@@ -2349,43 +2771,78 @@ QList<FunctionDescription> CutterCore::getAllFunctions()
     RListIter *iter;
     RAnalFunction *fcn;
     CutterRListForeach (core->anal->fcns, iter, RAnalFunction, fcn) {
-        FunctionDescription function;
-        function.offset = fcn->addr;
-        function.linearSize = r_anal_function_linear_size(fcn);
-        function.nargs = r_anal_var_count(core->anal, fcn, 'b', 1) +
-            r_anal_var_count(core->anal, fcn, 'r', 1) +
-            r_anal_var_count(core->anal, fcn, 's', 1);
-        function.nlocals = r_anal_var_count(core->anal, fcn, 'b', 0) +
-            r_anal_var_count(core->anal, fcn, 'r', 0) +
-            r_anal_var_count(core->anal, fcn, 's', 0);
-        function.nbbs = r_list_length (fcn->bbs);
-        function.calltype = fcn->cc ? QString::fromUtf8(fcn->cc) : QString();
-        function.name = fcn->name ? QString::fromUtf8(fcn->name) : QString();
-        function.edges = r_anal_fcn_count_edges(fcn, nullptr);
-        function.stackframe = fcn->maxstack;
+        FunctionDescription function = functionDescriptionFromR2(fcn);
+        if (withDetails) {
+            loadFunctionDetailsFromR2(core->anal, fcn, function);
+        }
         funcList.append(function);
     }
 
     return funcList;
 }
 
+bool CutterCore::getFunctionDescription(RVA addr, FunctionDescription &function)
+{
+    CORE_LOCK_READ();
+    RAnalFunction *fcn = r_anal_get_function_at(core->anal, addr);
+    if (!fcn) {
+        return false;
+    }
+    function = functionDescriptionFromR2(fcn);
+    return true;
+}
+
+bool CutterCore::loadFunctionDetails(FunctionDescription &function)
+{
+    CORE_LOCK_READ();
+    RAnalFunction *fcn = r_anal_get_function_at(core->anal, function.offset);
+    if (!fcn) {
+        function.detailsLoaded = true;
+        return false;
+    }
+    loadFunctionDetailsFromR2(core->anal, fcn, function);
+    return true;
+}
+
 QList<ImportDescription> CutterCore::getAllImports()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<ImportDescription> ret;
 
-    QJsonArray importsArray = cmdj("iij").array();
+    RList *imports = r_bin_get_imports(core->bin);
+    if (!imports) {
+        return ret;
+    }
+    ret.reserve(r_list_length(imports));
 
-    for (const QJsonValue &value : importsArray) {
-        QJsonObject importObject = value.toObject();
+    // Resolve the plt address of every import through its "imp." symbol with a single
+    // pass over the symbols instead of one lookup per import.
+    QHash<QString, RVA> pltAddresses;
+    RListIter *it;
+    RBinSymbol *bs;
+    CutterRListForeach(r_bin_get_symbols(core->bin), it, RBinSymbol, bs) {
+        if (bs->name && !strncmp(bs->name, "imp.", 4)) {
+            QString name = QString::fromUtf8(bs->name + 4);
+            if (!pltAddresses.contains(name)) {
+                pltAddresses.insert(name, binVirtualAddress(core, bs->paddr, bs->vaddr));
+            }
+        }
+    }
 
+    RBinImport *bi;
+    CutterRListForeach(imports, it, RBinImport, bi) {
         ImportDescription import;
 
-        import.plt = importObject[RJsonKey::plt].toVariant().toULongLong();
-        import.ordinal = importObject[RJsonKey::ordinal].toInt();
-        import.bind = importObject[RJsonKey::bind].toString();
-        import.type = importObject[RJsonKey::type].toString();
-        import.name = importObject[RJsonKey::name].toString();
+        QString name = QString::fromUtf8(bi->name);
+        import.plt = pltAddresses.value(name, 0);
+        import.ordinal = bi->ordinal;
+        import.bind = QString::fromUtf8(bi->bind);
+        import.type = QString::fromUtf8(bi->type);
+        if (bi->classname && bi->classname[0]) {
+            import.name = QString::fromUtf8(bi->classname) + "." + name;
+        } else {
+            import.name = name;
+        }
 
         ret << import;
     }
@@ -2395,22 +2852,29 @@ QList<ImportDescription> CutterCore::getAllImports()
 
 QList<ExportDescription> CutterCore::getAllExports()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<ExportDescription> ret;
 
-    QJsonArray exportsArray = cmdj("iEj").array();
-
-    for (const QJsonValue &value : exportsArray) {
-        QJsonObject exportObject = value.toObject();
+    RListIter *it;
+    RBinSymbol *bs;
+    CutterRListForeach(r_bin_get_symbols(core->bin), it, RBinSymbol, bs) {
+        // Same filter as "iE": global symbols that are not import stubs
+        if (!bs->name || !strncmp(bs->name, "imp.", 4)
+                || !bs->bind || strcmp(bs->bind, R_BIN_BIND_GLOBAL_STR)) {
+            continue;
+        }
 
         ExportDescription exp;
 
-        exp.vaddr = exportObject[RJsonKey::vaddr].toVariant().toULongLong();
-        exp.paddr = exportObject[RJsonKey::paddr].toVariant().toULongLong();
-        exp.size = exportObject[RJsonKey::size].toVariant().toULongLong();
-        exp.type = exportObject[RJsonKey::type].toString();
-        exp.name = exportObject[RJsonKey::name].toString();
-        exp.flag_name = exportObject[RJsonKey::flagname].toString();
+        exp.vaddr = binVirtualAddress(core, bs->paddr, bs->vaddr);
+        exp.paddr = bs->paddr;
+        exp.size = bs->size;
+        exp.type = QString::fromUtf8(bs->type);
+        exp.name = QString::fromUtf8(bs->name);
+
+        QByteArray flagName = QByteArray("sym.") + bs->name;
+        r_name_filter(flagName.data(), flagName.size());
+        exp.flag_name = QString::fromUtf8(flagName);
 
         ret << exp;
     }
@@ -2420,7 +2884,7 @@ QList<ExportDescription> CutterCore::getAllExports()
 
 QList<SymbolDescription> CutterCore::getAllSymbols()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     RListIter *it;
 
     QList<SymbolDescription> ret;
@@ -2531,7 +2995,7 @@ QList<CommentDescription> CutterCore::getAllComments(const QString &filterType)
 
 QList<RelocDescription> CutterCore::getAllRelocs()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<RelocDescription> ret;
 
     if (core && core->bin && core->bin->cur && core->bin->cur->o) {
@@ -2559,25 +3023,34 @@ QList<RelocDescription> CutterCore::getAllRelocs()
 
 QList<StringDescription> CutterCore::getAllStrings()
 {
-    return parseStringsJson(cmdjTask("izzj"));
-}
-
-QList<StringDescription> CutterCore::parseStringsJson(const QJsonDocument &doc)
-{
+    CORE_LOCK_READ();
     QList<StringDescription> ret;
 
-    QJsonArray stringsArray = doc.array();
-    for (const QJsonValue &value : stringsArray) {
-        QJsonObject stringObject = value.toObject();
+    RBinFile *bf = r_bin_cur(core->bin);
+    if (!bf) {
+        return ret;
+    }
+    RBinObject *obj = r_bin_cur_object(core->bin);
+
+    // Same as "iz", the strings of the data sections, owned by the bin object
+    RList *strings = r_bin_get_strings(core->bin);
+    if (!strings) {
+        return ret;
+    }
+    ret.reserve(r_list_length(strings));
 
+    RListIter *it;
+    RBinString *bs;
+    CutterRListForeach(strings, it, RBinString, bs) {
         StringDescription string;
 
-        string.string = stringObject[RJsonKey::string].toString();
-        string.vaddr = stringObject[RJsonKey::vaddr].toVariant().toULongLong();
-        string.type = stringObject[RJsonKey::type].toString();
-        string.size = stringObject[RJsonKey::size].toVariant().toUInt();
-        string.length = stringObject[RJsonKey::length].toVariant().toUInt();
-        string.section = stringObject[RJsonKey::section].toString();
+        string.string = QString::fromUtf8(bs->string);
+        string.vaddr = binVirtualAddress(core, bs->paddr, bs->vaddr);
+        string.type = QString::fromUtf8(r_bin_string_type(bs->type));
+        string.size = bs->size;
+        string.length = bs->length;
+        RBinSection *section = obj ? r_bin_get_section_at(obj, bs->paddr, false) : nullptr;
+        string.section = section ? QString::fromUtf8(section->name) : QString();
 
         ret << string;
     }
@@ -2605,53 +3078,52 @@ QList<FlagspaceDescription> CutterCore::getAllFlagspaces()
 
 QList<FlagDescription> CutterCore::getAllFlags(QString flagspace)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<FlagDescription> ret;
 
-    if (!flagspace.isEmpty())
-        cmd("fs " + flagspace);
-    else
-        cmd("fs *");
-
-    QJsonArray flagsArray = cmdj("fj").array();
-    for (const QJsonValue &value : flagsArray) {
-        QJsonObject flagObject = value.toObject();
+    RSpace *space = nullptr;
+    if (!flagspace.isEmpty()) {
+        space = r_flag_space_get(core->flags, flagspace.toUtf8().constData());
+        if (!space) {
+            return ret;
+        }
+    }
 
+    auto addFlag = [](RFlagItem *fi, void *user) -> bool {
         FlagDescription flag;
-
-        flag.offset = flagObject[RJsonKey::offset].toVariant().toULongLong();
-        flag.size = flagObject[RJsonKey::size].toVariant().toULongLong();
-        flag.name = flagObject[RJsonKey::name].toString();
-
-        ret << flag;
+        flag.offset = fi->offset;
+        flag.size = fi->size;
+        flag.name = QString::fromUtf8(fi->name);
+        reinterpret_cast<QList<FlagDescription> *>(user)->append(flag);
+        return true;
+    };
+    if (space) {
+        r_flag_foreach_space(core->flags, space, addFlag, &ret);
+    } else {
+        r_flag_foreach(core->flags, addFlag, &ret);
     }
     return ret;
 }
 
 QList<SectionDescription> CutterCore::getAllSections()
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<SectionDescription> sections;
 
-    QJsonDocument sectionsDoc = cmdj("iSj entropy");
-    QJsonObject sectionsObj = sectionsDoc.object();
-    QJsonArray sectionsArray = sectionsObj[RJsonKey::sections].toArray();
-
-    for (const QJsonValue &value : sectionsArray) {
-        QJsonObject sectionObject = value.toObject();
-
-        QString name = sectionObject[RJsonKey::name].toString();
-        if (name.isEmpty())
+    RListIter *it;
+    RBinSection *bs;
+    CutterRListForeach(r_bin_get_sections(core->bin), it, RBinSection, bs) {
+        if (bs->is_segment || !bs->name || !bs->name[0]) {
             continue;
+        }
 
         SectionDescription section;
-        section.name = name;
-        section.vaddr = sectionObject[RJsonKey::vaddr].toVariant().toULongLong();
-        section.vsize = sectionObject[RJsonKey::vsize].toVariant().toULongLong();
-        section.paddr = sectionObject[RJsonKey::paddr].toVariant().toULongLong();
-        section.size = sectionObject[RJsonKey::size].toVariant().toULongLong();
-        section.perm = sectionObject[RJsonKey::perm].toString();
-        section.entropy =  sectionObject[RJsonKey::entropy].toString();
+        section.name = QString::fromUtf8(bs->name);
+        section.vaddr = binVirtualAddress(core, bs->paddr, bs->vaddr);
+        section.vsize = bs->vsize;
+        section.paddr = bs->paddr;
+        section.size = bs->size;
+        section.perm = QString::fromUtf8(r_str_rwx_i(bs->perm));
 
         sections << section;
     }
@@ -2826,7 +3298,7 @@ QList<BinClassDescription> CutterCore::getAllClassesFromFlags()
 
 QList<QString> CutterCore::getAllAnalClasses(bool sorted)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<QString> ret;
 
     SdbListPtr l = makeSdbListPtr(r_anal_class_get_all(core->anal, sorted));
@@ -2847,7 +3319,7 @@ QList<QString> CutterCore::getAllAnalClasses(bool sorted)
 
 QList<AnalMethodDescription> CutterCore::getAnalClassMethods(const QString &cls)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<AnalMethodDescription> ret;
 
     RVector *meths = r_anal_class_method_get_all(core->anal, cls.toUtf8().constData());
@@ -2871,7 +3343,7 @@ QList<AnalMethodDescription> CutterCore::getAnalClassMethods(const QString &cls)
 
 QList<AnalBaseClassDescription> CutterCore::getAnalClassBaseClasses(const QString &cls)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<AnalBaseClassDescription> ret;
 
     RVector *bases = r_anal_class_base_get_all(core->anal, cls.toUtf8().constData());
@@ -2895,7 +3367,7 @@ QList<AnalBaseClassDescription> CutterCore::getAnalClassBaseClasses(const QStrin
 
 QList<AnalVTableDescription> CutterCore::getAnalClassVTables(const QString &cls)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     QList<AnalVTableDescription> acVtables;
 
     RVector *vtables = r_anal_class_vtable_get_all(core->anal, cls.toUtf8().constData());
@@ -2937,7 +3409,7 @@ void CutterCore::deleteClass(const QString &cls)
 
 bool CutterCore::getAnalMethod(const QString &cls, const QString &meth, AnalMethodDescription *desc)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
     RAnalMethod analMeth;
     if (r_anal_class_method_get(core->anal, cls.toUtf8().constData(), meth.toUtf8().constData(), &analMeth) != R_ANAL_CLASS_ERR_SUCCESS) {
         return false;
@@ -3271,6 +3743,40 @@ BlockStatistics CutterCore::getBlockStatistics(unsigned int blocksCount)
     return blockStats;
 }
 
+void CutterCore::updateBlockFunctionStatistics(BlockStatistics &stats)
+{
+    CORE_LOCK_READ();
+    for (BlockDescription &block : stats.blocks) {
+        block.functions = 0;
+        block.inFunctions = 0;
+    }
+    if (stats.blocks.isEmpty()) {
+        return;
+    }
+
+    // Count like "p-j": the function at its entry and the linear range in every block it touches
+    RListIter *iter;
+    RAnalFunction *fcn;
+    CutterRListForeach (core->anal->fcns, iter, RAnalFunction, fcn) {
+        if (fcn->addr < stats.from || fcn->addr > stats.to) {
+            continue;
+        }
+        auto it = std::upper_bound(stats.blocks.begin(), stats.blocks.end(), fcn->addr,
+        [](RVA addr, const BlockDescription & block) {
+            return addr < block.addr;
+        });
+        if (it == stats.blocks.begin()) {
+            continue;
+        }
+        --it;
+        it->functions++;
+        RVA last = fcn->addr + std::max<ut64>(r_anal_function_linear_size(fcn), 1) - 1;
+        for (; it != stats.blocks.end() && it->addr <= last; ++it) {
+            it->inFunctions++;
+        }
+    }
+}
+
 QList<XrefDescription> CutterCore::getXRefs(RVA addr, bool to, bool whole_function,
                                             const QString &filterType)
 {
@@ -3658,7 +4164,7 @@ QString CutterCore::getHexdumpPreview(RVA address, int size)
 
 QByteArray CutterCore::ioRead(RVA addr, int len)
 {
-    CORE_LOCK();
+    CORE_LOCK_READ();
 
     QByteArray array;
 
@@ -3675,3 +4181,25 @@ QByteArray CutterCore::ioRead(RVA addr, int len)
     return  array;
 }
 
+QByteArray CutterCore::binFileRead(ut64 offset, int len)
+{
+    CORE_LOCK_READ();
+
+    QByteArray array;
+    RBinFile *bf = r_bin_cur(core->bin);
+    if (!bf || !bf->buf || len <= 0) {
+        return array;
+    }
+
+    array.resize(len);
+    st64 read = r_buf_read_at(bf->buf, offset, reinterpret_cast<ut8 *>(array.data()), len);
+    array.resize(read > 0 ? static_cast<int>(read) : 0);
+    return array;
+}
+
+ut64 CutterCore::binFileSize()
+{
+    CORE_LOCK_READ();
+    RBinFile *bf = r_bin_cur(core->bin);
+    return bf && bf->buf ? r_buf_size(bf->buf) : 0;
+}
@@ -13,8 +13,23 @@
 #include <QJsonDocument>
 #include <QErrorMessage>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+
+#include <functional>
 
 class AsyncTaskManager;
+class IOPageCache;
+class SectionStatistics;
+class PreviewCache;
+class DebugStateSnapshot;
+class Telescope;
+class TraceManager;
+class EsilRunner;
+class EsilRunTask;
+struct EsilRunState;
 class BasicInstructionHighlighter;
 class CutterCore;
 class Decompiler;
@@ -30,6 +45,32 @@ class R2TaskDialog;
 
 class RCoreLocked;
 
+/**
+ * @brief Kind of access requested when locking the core.
+ *
+ * The core is still accessed by one thread at a time, radare2 keeps per-core console
+ * and io state that is not safe to share. Read requests only query the core and are
+ * granted before any waiting Write request, so short widget refreshes do not queue
+ * up behind the individual commands of a long analysis. Read requests made while a
+ * Write request is waiting are only granted after it, so reads can't starve writes.
+ */
+enum class CoreAccess {
+    Read,
+    Write
+};
+
+/**
+ * @brief Accumulated lock wait and hold times of one CORE_LOCK() call site.
+ */
+struct CoreLockStatistics {
+    QString caller;
+    quint64 count = 0;
+    qint64 totalWaitNs = 0;
+    qint64 maxWaitNs = 0;
+    qint64 totalHoldNs = 0;
+    qint64 maxHoldNs = 0;
+};
+
 class CutterCore: public QObject
 {
     Q_OBJECT
@@ -46,6 +87,11 @@ public:
     void loadCutterRC();
 
     AsyncTaskManager *getAsyncTaskManager() { return asyncTaskManager; }
+    IOPageCache *getIOPageCache() { return ioPageCache; }
+    SectionStatistics *getSectionStatistics() { return sectionStatistics; }
+    PreviewCache *getPreviewCache() { return previewCache; }
+    DebugStateSnapshot *getDebugState() { return debugState; }
+    TraceManager *getTraceManager() { return traceManager; }
 
     RVA getOffset() const                   { return core_->offset; }
 
@@ -127,6 +173,10 @@ public:
     RVA getFunctionStart(RVA addr);
     RVA getFunctionEnd(RVA addr);
     RVA getLastFunctionInstruction(RVA addr);
+    /**
+     * @brief Get the start addresses of the functions called by, or calling, the function at addr
+     */
+    QList<RVA> getCallNeighbourFunctions(RVA addr);
     QString cmdFunctionAt(QString addr);
     QString cmdFunctionAt(RVA addr);
     QString createFunctionAt(RVA addr);
@@ -303,7 +353,7 @@ public:
      * @param size number of bytes to scan
      * @param depth telescoping depth 
      */
-    QList<QJsonObject> getStack(int size = 0x100, int depth = 6);
+    QList<AddrRefChain> getStack(int size = 0x100, int depth = 6);
     /**
      * @brief Recursively dereferences pointers starting at the specified address
      *        up to a given depth
@@ -336,6 +386,11 @@ public:
     void stopDebug();
     void suspendDebug();
     void syncAndSeekProgramCounter();
+    /**
+     * @brief Must be called after memory was written other than through the ESIL VM,
+     * so the instructions decoded for emulation are not stale
+     */
+    void invalidateEmulatedCode();
     void continueDebug();
     void continueUntilCall();
     void continueUntilSyscall();
@@ -362,9 +417,20 @@ public:
     int breakpointIndexAt(RVA addr);
     BreakpointDescription getBreakpointAt(RVA addr);
 
-    bool isBreakpoint(const QList<RVA> &breakpoints, RVA addr);
-    QList<RVA> getBreakpointsAddresses();
-    
+    /**
+     * @param breakpoints - sorted addresses as returned by getBreakpointsAddresses()
+     */
+    bool isBreakpoint(const QVector<RVA> &breakpoints, RVA addr);
+    bool isBreakpoint(RVA addr);
+    /**
+     * @brief Get the addresses of all breakpoints, sorted and without duplicates
+     */
+    QVector<RVA> getBreakpointsAddresses();
+    /**
+     * @brief Get the sorted addresses of all breakpoints in [from, to)
+     */
+    QVector<RVA> getBreakpointsInRange(RVA from, RVA to);
+
     /**
      * @brief Get all breakpoinst that are belong to a functions at this address
      */
@@ -413,6 +479,18 @@ public:
 
     QByteArray ioRead(RVA addr, int len);
 
+    /**
+     * @brief Read raw bytes of the currently loaded bin file, independent of io maps
+     * @param offset physical offset in the file
+     * @param len number of bytes to read
+     * @return the bytes read, may be shorter than len at the end of the file
+     */
+    QByteArray binFileRead(ut64 offset, int len);
+    /**
+     * @return size of the currently loaded bin file, 0 if there is none
+     */
+    ut64 binFileSize();
+
     QList<RVA> getSeekHistory();
 
     /* Plugins */
@@ -431,7 +509,20 @@ public:
     QList<RIOPluginDescription> getRIOPluginDescriptions();
     QList<RCorePluginDescription> getRCorePluginDescriptions();
     QList<RAsmPluginDescription> getRAsmPluginDescriptions();
-    QList<FunctionDescription> getAllFunctions();
+    /**
+     * @param withDetails also count arguments, locals and edges, which is slow for many functions
+     */
+    QList<FunctionDescription> getAllFunctions(bool withDetails = true);
+    /**
+     * @brief Describe the function starting at addr, without arguments, locals and edges
+     * @return false if there is no function at addr
+     */
+    bool getFunctionDescription(RVA addr, FunctionDescription &function);
+    /**
+     * @brief Count arguments, locals and edges of a function described without them
+     * @return false if there is no function at function.offset anymore
+     */
+    bool loadFunctionDetails(FunctionDescription &function);
     QList<ImportDescription> getAllImports();
     QList<ExportDescription> getAllExports();
     QList<SymbolDescription> getAllSymbols();
@@ -439,9 +530,15 @@ public:
     QList<ZignatureDescription> getAllZignatures();
     QList<CommentDescription> getAllComments(const QString &filterType);
     QList<RelocDescription> getAllRelocs();
+    /**
+     * @brief Strings of the data sections, as in "iz". StringsWidget scans the whole file itself.
+     */
     QList<StringDescription> getAllStrings();
     QList<FlagspaceDescription> getAllFlagspaces();
     QList<FlagDescription> getAllFlags(QString flagspace = QString());
+    /**
+     * @brief Sections without entropy, SectionStatistics computes it in the background
+     */
     QList<SectionDescription> getAllSections();
     QList<SegmentDescription> getAllSegments();
     QList<EntrypointDescription> getAllEntrypoint();
@@ -511,6 +608,11 @@ public:
     QList<MemoryMapDescription> getMemoryMap();
     QList<SearchDescription> getAllSearch(QString search_for, QString space);
     BlockStatistics getBlockStatistics(unsigned int blocksCount);
+    /**
+     * @brief Recount functions and inFunctions of stats returned by getBlockStatistics(),
+     * without querying the other statistics again
+     */
+    void updateBlockFunctionStatistics(BlockStatistics &stats);
     QList<BreakpointDescription> getBreakpoints();
     QList<ProcessDescription> getAllProcesses();
     QList<RegisterRefDescription> getRegisterRefs();
@@ -520,8 +622,6 @@ public:
     QList<XrefDescription> getXRefs(RVA addr, bool to, bool whole_function,
                                     const QString &filterType = QString());
 
-    QList<StringDescription> parseStringsJson(const QJsonDocument &doc);
-
     void handleREvent(int type, void *data);
 
     /* Signals related */
@@ -530,6 +630,11 @@ public:
     void triggerRefreshAll();
     void triggerAsmOptionsChanged();
     void triggerGraphOptionsChanged();
+    /**
+     * @brief Drop the DebugStateSnapshot and refresh the debug views after a command that may
+     * have stepped or written registers or memory, such as one from the console
+     */
+    void triggerDebugStateChanged();
 
     void message(const QString &msg, bool debug = false);
 
@@ -537,6 +642,19 @@ public:
 
     RCoreLocked core();
 
+    /**
+     * @brief Lock wait and hold times per caller since start or the last reset.
+     */
+    QList<CoreLockStatistics> getCoreLockStatistics();
+    void resetCoreLockStatistics();
+
+    /**
+     * @brief Counter incremented whenever analysis results, comments, flags or disassembly
+     * options change, or the debugger wrote executable memory, so views can tell whether
+     * output they cached is still valid.
+     */
+    quint64 getAnalysisRevision() const     { return analysisRevision; }
+
     static QString ansiEscapeToHtml(const QString &text);
     BasicBlockHighlighter *getBBHighlighter();
     BasicInstructionHighlighter *getBIHighlighter();
@@ -546,6 +664,14 @@ signals:
 
     void functionRenamed(const QString &prev_name, const QString &new_name);
     void varsChanged();
+    /**
+     * @brief emitted before functionsChanged when a function was created by Cutter
+     */
+    void functionAdded(RVA offset);
+    /**
+     * @brief emitted before functionsChanged when a function was deleted by Cutter
+     */
+    void functionRemoved(RVA offset);
     void functionsChanged();
     void flagsChanged();
     void commentsChanged();
@@ -609,14 +735,37 @@ private:
 
     /**
      * Internal reference to the RCore.
-     * NEVER use this directly! Always use the CORE_LOCK(); macro and access it like core->...
+     * NEVER use this directly! Always use the CORE_LOCK(); macro (or CORE_LOCK_READ(); for
+     * queries that do not modify anything) and access it like core->...
      */
     RCore *core_ = nullptr;
-    QMutex coreMutex;
+    QMutex coreLockStateMutex;
+    QWaitCondition coreLockReleased;
+    Qt::HANDLE coreLockOwner = nullptr;
     int coreLockDepth = 0;
+    int coreLockReadWaiters = 0;
+    int coreLockWriteWaiters = 0;
+    quint64 coreLockWritersServed = 0;
+    /**
+     * Readers that arrived while writers were waiting, counted by the number of served
+     * writers they wait for before they get priority over writers again.
+     */
+    QMap<quint64, int> coreLockDeferredReaders;
+    const char *coreLockCaller = nullptr;
+    QElapsedTimer coreLockHoldTimer;
+    QHash<const char *, CoreLockStatistics> coreLockStats;
     void *coreBed = nullptr;
 
+    void lockCore(CoreAccess access, const char *caller);
+    void unlockCore();
+
     AsyncTaskManager *asyncTaskManager;
+    IOPageCache *ioPageCache = nullptr;
+    SectionStatistics *sectionStatistics = nullptr;
+    PreviewCache *previewCache = nullptr;
+    DebugStateSnapshot *debugState = nullptr;
+    Telescope *telescope = nullptr;
+    TraceManager *traceManager = nullptr;
     RVA offsetPriorDebugging = RVA_INVALID;
     QErrorMessage msgBox;
 
@@ -628,6 +777,60 @@ private:
 
     QSharedPointer<R2Task> debugTask;
     R2TaskDialog *debugTaskDialog;
+
+    /**
+     * Runs continue, continue until and single steps while emulating, directly on the ESIL VM
+     * instead of through "aec" and "aes". Its decoded instructions are kept across runs.
+     * Attached for the whole emulation session, so it sees all writes of the ESIL VM.
+     */
+    EsilRunner *esilRunner = nullptr;
+    QSharedPointer<EsilRunTask> esilRunTask;
+    /**
+     * @param finished called once stopped, after the registers were passed to the DebugStateSnapshot
+     */
+    bool runEmulation(RVA until, quint64 maxSteps, std::function<void()> finished);
+    void continueEmulation(RVA until);
+    /**
+     * @brief Pass the registers read by an EsilRunTask to the DebugStateSnapshot
+     */
+    void setEmulatedRegisters(const EsilRunState &state);
+    /**
+     * @brief Like syncAndSeekProgramCounter(), but reuses the program counter of the DebugStateSnapshot
+     */
+    void seekToProgramCounter();
+
+    /**
+     * Steps requested while debugTask was still stepping, run together by the next task.
+     * Views are refreshed at most Configuration::getDebugRefreshRate() times a second
+     * until no more steps are queued.
+     */
+    bool stepping = false;
+    int queuedSteps = 0;
+    QString queuedStepCommand;
+    QElapsedTimer stepRefreshTimer;
+    void queueStep(const QString &command);
+    bool runSteps(const QString &command, int count);
+
+    /**
+     * Sorted addresses of all breakpoints, rebuilt on the next query after
+     * breakpointsChanged or once the breakpoints no longer match breakpointAddressesSignature.
+     * Only accessed with the core locked.
+     */
+    QVector<RVA> breakpointAddresses;
+    quint64 breakpointAddressesSignature = 0;
+    bool breakpointAddressesValid = false;
+    void updateBreakpointAddresses();
+    void invalidateBreakpointAddresses();
+
+    quint64 analysisRevision = 0;
+    void bumpAnalysisRevision()             { analysisRevision++; }
+
+    /**
+     * Bumps the analysis revision if the last steps or debug task wrote executable memory,
+     * only seen by the ESIL write hook while emulating, or compared to codeSignature otherwise
+     */
+    quint64 codeSignature = 0;
+    void checkCodeWritten();
 };
 
 class RCoreLocked
@@ -635,7 +838,8 @@ class RCoreLocked
     CutterCore * const core;
 
 public:
-    explicit RCoreLocked(CutterCore *core);
+    explicit RCoreLocked(CutterCore *core, CoreAccess access = CoreAccess::Write,
+                         const char *caller = nullptr);
     RCoreLocked(const RCoreLocked &) = delete;
     RCoreLocked &operator=(const RCoreLocked &) = delete;
     RCoreLocked(RCoreLocked &&);
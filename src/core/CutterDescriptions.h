@@ -9,6 +9,7 @@
 #include <QList>
 #include <QStringList>
 #include <QMetaType>
+#include <QVector>
 #include "core/CutterCommon.h"
 
 struct FunctionDescription {
@@ -21,6 +22,10 @@ struct FunctionDescription {
     QString name;
     RVA edges;
     RVA stackframe;
+    /**
+     * false if nargs, nlocals and edges have not been counted yet
+     */
+    bool detailsLoaded;
 
     bool contains(RVA addr) const
     {
@@ -312,6 +317,43 @@ struct RegisterRefDescription {
     QString ref;
 };
 
+/**
+ * @brief One address of a telescoped pointer chain
+ */
+struct AddrRefDescription {
+    RVA addr = RVA_INVALID;
+    /**
+     * Pointer read at addr, only if addr is readable and not executable
+     */
+    RVA value = 0;
+    bool hasValue = false;
+    /**
+     * heap, stack, program, library, ascii or sequence
+     */
+    QString type;
+    QString perms;
+    QString mapname;
+    QString section;
+    /**
+     * Register whose value is addr
+     */
+    QString reg;
+    QString fcn;
+    /**
+     * Instruction at addr, if it is executable
+     */
+    QString asmText;
+    /**
+     * Characters at addr, if value looks like ascii
+     */
+    QString string;
+};
+
+/**
+ * @brief An address followed by the addresses it points to, each one read at the previous one
+ */
+typedef QVector<AddrRefDescription> AddrRefChain;
+
 struct VariableDescription {
     enum class RefType { SP, BP, Reg };
     RefType refType;
@@ -356,6 +398,7 @@ Q_DECLARE_METATYPE(BreakpointDescription)
 Q_DECLARE_METATYPE(BreakpointDescription::PositionType)
 Q_DECLARE_METATYPE(ProcessDescription)
 Q_DECLARE_METATYPE(RegisterRefDescription)
+Q_DECLARE_METATYPE(AddrRefDescription)
 Q_DECLARE_METATYPE(VariableDescription)
 
 #endif // DESCRIPTIONS_H
@@ -65,6 +65,7 @@
 #include "widgets/ProcessesWidget.h"
 #include "widgets/RegistersWidget.h"
 #include "widgets/BacktraceWidget.h"
+#include "widgets/TraceWidget.h"
 #include "widgets/HexdumpWidget.h"
 #include "widgets/DecompilerWidget.h"
 #include "widgets/HexWidget.h"
@@ -278,7 +279,7 @@ void MainWindow::initToolBar()
     addToolBarBreak(Qt::TopToolBarArea);
     addToolBar(visualNavbar);
     QObject::connect(configuration, &Configuration::colorsUpdated, [this]() {
-        this->visualNavbar->updateGraphicsScene();
+        this->visualNavbar->updateImage();
     });
     QObject::connect(configuration, &Configuration::interfaceThemeChanged, this, &MainWindow::chooseThemeIcons);
 }
@@ -323,6 +324,7 @@ void MainWindow::initDocks()
     threadsDock = new ThreadsWidget(this, ui->actionThreads);
     processesDock = new ProcessesWidget(this, ui->actionProcesses);
     backtraceDock = new BacktraceWidget(this, ui->actionBacktrace);
+    traceDock = new TraceWidget(this, ui->actionTrace);
     registersDock = new RegistersWidget(this, ui->actionRegisters);
     memoryMapDock = new MemoryMapWidget(this, ui->actionMemoryMap);
     breakpointDock = new BreakpointWidget(this, ui->actionBreakpoint);
@@ -608,11 +610,6 @@ bool MainWindow::saveProjectAs(bool quit)
     return SaveProjectDialog::Rejected != dialog.exec();
 }
 
-void MainWindow::refreshOmniBar(const QStringList &flags)
-{
-    omnibar->refresh(flags);
-}
-
 void MainWindow::setFilename(const QString &fn)
 {
     // Add file name to window title
@@ -847,6 +844,7 @@ void MainWindow::restoreDocks()
     tabifyDockWidget(stackDock, backtraceDock);
     tabifyDockWidget(backtraceDock, threadsDock);
     tabifyDockWidget(threadsDock, processesDock);
+    tabifyDockWidget(processesDock, traceDock);
 
     updateDockActionsChecked();
 }
@@ -875,7 +873,8 @@ bool MainWindow::isDebugWidget(QDockWidget *dock) const
            dock == memoryMapDock ||
            dock == breakpointDock ||
            dock == processesDock ||
-           dock == registerRefsDock;
+           dock == registerRefsDock ||
+           dock == traceDock;
 }
 
 MemoryWidgetType MainWindow::getMemoryWidgetTypeToRestore()
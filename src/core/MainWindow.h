@@ -90,7 +90,6 @@ public:
     void readDebugSettings();
     void saveDebugSettings();
     void setFilename(const QString &fn);
-    void refreshOmniBar(const QStringList &flags);
 
     void addWidget(QDockWidget *widget);
     void addMemoryDockWidget(MemoryDockWidget *widget);
@@ -253,6 +252,7 @@ private:
     QDockWidget        *processesDock = nullptr;
     QDockWidget        *registersDock = nullptr;
     QDockWidget        *backtraceDock = nullptr;
+    QDockWidget        *traceDock = nullptr;
     QDockWidget        *memoryMapDock = nullptr;
     NewFileDialog      *newFileDialog = nullptr;
     QDockWidget        *breakpointDock = nullptr;
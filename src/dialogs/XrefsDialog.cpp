@@ -3,6 +3,7 @@
 
 #include "common/TempConfig.h"
 #include "common/Helpers.h"
+#include "common/PreviewCache.h"
 
 #include "core/MainWindow.h"
 
@@ -38,6 +39,13 @@ XrefsDialog::XrefsDialog(MainWindow *main, QWidget *parent) :
     connect(ui->previewTextEdit, SIGNAL(cursorPositionChanged()), this, SLOT(highlightCurrentLine()));
     connect(Config(), SIGNAL(fontsUpdated()), this, SLOT(setupPreviewFont()));
     connect(Config(), SIGNAL(colorsUpdated()), this, SLOT(setupPreviewColors()));
+    connect(Core()->getPreviewCache(), &PreviewCache::previewReady, this,
+    [this](int type, RVA address) {
+        if (type == PreviewCache::InstructionPreview) {
+            toModel.updatePreview(address);
+            fromModel.updatePreview(address);
+        }
+    });
 
     connect(ui->toTreeWidget->selectionModel(), &QItemSelectionModel::selectionChanged,
             this, &XrefsDialog::onToTreeWidgetItemSelectionChanged);
@@ -214,7 +222,12 @@ QVariant XrefModel::data(const QModelIndex &index, int role) const
             return to ? xref.from_str : xref.to_str;
         case CODE:
             if (to || xref.type != "DATA") {
-                return Core()->disassembleSingleInstruction(xref.from);
+                AddressPreview preview;
+                if (Core()->getPreviewCache()->getPreview(PreviewCache::InstructionPreview, xref.from,
+                                                          &preview)) {
+                    return preview.disassembly.value(0);
+                }
+                return QString();
             } else {
                 return QString();
             }
@@ -251,6 +264,16 @@ QVariant XrefModel::headerData(int section, Qt::Orientation orientation, int rol
     }
 }
 
+void XrefModel::updatePreview(RVA address)
+{
+    for (int row = 0; row < xrefs.count(); row++) {
+        if (xrefs[row].from == address) {
+            QModelIndex changed = index(row, CODE);
+            emit dataChanged(changed, changed);
+        }
+    }
+}
+
 RVA XrefModel::address(const QModelIndex &index) const
 {
     const auto &xref = xrefs.at(index.row());
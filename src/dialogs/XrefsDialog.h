@@ -29,6 +29,12 @@ public:
 
     RVA address(const QModelIndex &index) const override;
 
+    /**
+     * @brief Update the code column of the xrefs from address, once its instruction was
+     * disassembled in the background
+     */
+    void updatePreview(RVA address);
+
     static QString xrefTypeString(const QString &type);
 };
 
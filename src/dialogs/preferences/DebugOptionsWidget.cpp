@@ -24,6 +24,7 @@ DebugOptionsWidget::~DebugOptionsWidget() {}
 void DebugOptionsWidget::updateDebugPlugin()
 {
     ui->esilBreakOnInvalid->setChecked(Config()->getConfigBool("esil.breakoninvalid"));
+    ui->debugRefreshRate->setValue(Config()->getDebugRefreshRate());
     disconnect(ui->pluginComboBox, SIGNAL(currentIndexChanged(const QString &)), this,
                SLOT(on_pluginComboBox_currentIndexChanged(const QString &)));
 
@@ -70,3 +71,8 @@ void DebugOptionsWidget::on_esilBreakOnInvalid_toggled(bool checked)
 {
     Config()->setConfig("esil.breakoninvalid", checked);
 }
+
+void DebugOptionsWidget::on_debugRefreshRate_valueChanged(int rate)
+{
+    Config()->setDebugRefreshRate(rate);
+}
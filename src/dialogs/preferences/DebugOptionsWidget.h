@@ -28,4 +28,5 @@ private slots:
     void updateStackSize();
     void on_pluginComboBox_currentIndexChanged(const QString &index);
     void on_esilBreakOnInvalid_toggled(bool checked);
+    void on_debugRefreshRate_valueChanged(int rate);
 };
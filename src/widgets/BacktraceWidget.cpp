@@ -1,6 +1,7 @@
 #include "BacktraceWidget.h"
 #include "ui_BacktraceWidget.h"
 #include "common/JsonModel.h"
+#include "common/DebugStateSnapshot.h"
 #include "QHeaderView"
 
 #include "core/MainWindow.h"
@@ -47,7 +48,7 @@ void BacktraceWidget::updateContents()
 
 void BacktraceWidget::setBacktraceGrid()
 {
-    QJsonArray backtraceValues = Core()->getBacktrace().array();
+    const QJsonArray &backtraceValues = Core()->getDebugState()->getBacktrace();
     int i = 0;
     for (const QJsonValue &value : backtraceValues) {
         QJsonObject backtraceItem = value.toObject();
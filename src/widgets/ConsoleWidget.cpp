@@ -218,6 +218,8 @@ void ConsoleWidget::executeCommand(const QString &command)
         if (oldOffset != Core()->getOffset()) {
             Core()->updateSeek();
         }
+        // Commands such as "dr", "ds" or "wx" bypass the snapshot the debug views share
+        Core()->triggerDebugStateChanged();
     });
 
     Core()->getAsyncTaskManager()->start(commandTask);
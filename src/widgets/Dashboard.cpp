@@ -3,7 +3,7 @@
 #include "common/Helpers.h"
 #include "common/JsonModel.h"
 #include "common/JsonTreeItem.h"
-#include "common/TempConfig.h"
+#include "common/SectionStatistics.h"
 #include "dialogs/VersionInfoDialog.h"
 
 #include "core/MainWindow.h"
@@ -28,10 +28,25 @@ Dashboard::Dashboard(MainWindow *main, QAction *action) :
     ui->setupUi(this);
 
     connect(Core(), SIGNAL(refreshAll()), this, SLOT(updateContents()));
+    connect(Core()->getSectionStatistics(), &SectionStatistics::statisticsReady,
+            this, &Dashboard::updateEntropy);
 }
 
 Dashboard::~Dashboard() {}
 
+void Dashboard::updateEntropy()
+{
+    ut64 fileSize = Core()->binFileSize();
+    if (!fileSize) {
+        ui->lblEntropy->clear();
+        return;
+    }
+    FileRangeStatistics statistics;
+    if (Core()->getSectionStatistics()->getStatistics(0, fileSize, &statistics)) {
+        ui->lblEntropy->setText(QString::number(statistics.entropy, 'f', 8));
+    }
+}
+
 void Dashboard::updateContents()
 {
     QJsonDocument docu = Core()->getFileInfo();
@@ -123,14 +138,9 @@ void Dashboard::updateContents()
     QSpacerItem *spacer = new QSpacerItem(1, 1, QSizePolicy::Fixed, QSizePolicy::Expanding);
     ui->verticalLayout_2->addSpacerItem(spacer);
 
-    // Add entropy value
-    {
-        // Scope for TempConfig
-        TempConfig tempConfig;
-        tempConfig.set("io.va", false);
-        QString entropy = Core()->cmd("ph entropy $s @ 0").trimmed();
-        ui->lblEntropy->setText(entropy);
-    }
+    // Add entropy value, computed in the background for big files
+    ui->lblEntropy->setText(tr("Computing..."));
+    updateEntropy();
 
 
     // Get stats for the graphs
@@ -25,6 +25,7 @@ public:
 
 private slots:
     void updateContents();
+    void updateEntropy();
     void on_certificateButton_clicked();
     void on_versioninfoButton_clicked();
 
@@ -5,6 +5,7 @@
 #include "common/Configuration.h"
 #include "common/Helpers.h"
 #include "common/TempConfig.h"
+#include "common/DebugStateSnapshot.h"
 #include "common/SelectionHighlight.h"
 #include "common/Decompiler.h"
 #include "common/CutterSeekable.h"
@@ -15,6 +16,11 @@
 #include <QObject>
 #include <QTextBlockUserData>
 
+/**
+ * Callers and callees of the current function decompiled in the background
+ */
+static const int MAX_PREFETCH_FUNCTIONS = 16;
+
 DecompilerWidget::DecompilerWidget(MainWindow *main, QAction *action) :
     MemoryDockWidget(MemoryWidgetType::Decompiler, main, action),
     mCtxMenu(new DisassemblyContextMenu(this, main)),
@@ -35,9 +41,13 @@ DecompilerWidget::DecompilerWidget(MainWindow *main, QAction *action) :
     connect(Core(), SIGNAL(registersChanged()), this, SLOT(highlightPC()));
 
     decompiledFunctionAddr = RVA_INVALID;
-    decompilerWasBusy = false;
 
     connect(ui->refreshButton, &QAbstractButton::clicked, this, [this]() {
+        Decompiler *dec = getCurrentDecompiler();
+        if (dec && waitingForCode && dec->isCancelable()) {
+            dec->cancel();
+            return;
+        }
         doRefresh();
     });
 
@@ -61,7 +71,11 @@ DecompilerWidget::DecompilerWidget(MainWindow *main, QAction *action) :
         if (dec->getId() == selectedDecompilerId) {
             ui->decompilerComboBox->setCurrentIndex(ui->decompilerComboBox->count() - 1);
         }
-        connect(dec, &Decompiler::finished, this, &DecompilerWidget::decompilationFinished);
+        connect(dec, &Decompiler::functionDecompiled, this, [this, dec](RVA fcnAddr, AnnotatedCode code) {
+            if (dec == getCurrentDecompiler()) {
+                decompilationFinished(fcnAddr, code);
+            }
+        });
     }
 
     decompilerSelectionEnabled = decompilers.size() > 1;
@@ -126,8 +140,9 @@ void DecompilerWidget::doAutoRefresh()
 void DecompilerWidget::updateRefreshButton()
 {
     Decompiler *dec = getCurrentDecompiler();
-    ui->refreshButton->setEnabled(!autoRefreshEnabled && dec && !dec->isRunning());
-    if (dec && dec->isRunning() && dec->isCancelable()) {
+    bool cancelable = dec && waitingForCode && dec->isCancelable();
+    ui->refreshButton->setEnabled(cancelable || (!autoRefreshEnabled && dec && !waitingForCode));
+    if (cancelable) {
         ui->refreshButton->setText(tr("Cancel"));
     } else {
         ui->refreshButton->setText(tr("Refresh"));
@@ -149,11 +164,6 @@ void DecompilerWidget::doRefresh(RVA addr)
         return;
     }
 
-    if (dec->isRunning()) {
-        decompilerWasBusy = true;
-        return;
-    }
-
     if (addr == RVA_INVALID) {
         ui->textEdit->setPlainText(tr("Click Refresh to generate Decompiler from current offset."));
         return;
@@ -162,13 +172,24 @@ void DecompilerWidget::doRefresh(RVA addr)
     // Clear all selections since we just refreshed
     ui->textEdit->setExtraSelections({});
     decompiledFunctionAddr = Core()->getFunctionStart(addr);
-    dec->decompileAt(addr);
-    if (dec->isRunning()) {
+    if (decompiledFunctionAddr == RVA_INVALID) {
+        waitingForCode = false;
+        decompilationFinished(RVA_INVALID, AnnotatedCode());
+        return;
+    }
+
+    // Cached code arrives right away
+    waitingForCode = true;
+    dec->requestFunction(decompiledFunctionAddr);
+    if (waitingForCode) {
         ui->progressLabel->setVisible(true);
         ui->decompilerComboBox->setEnabled(false);
         updateRefreshButton();
-        return;
     }
+
+    // Following calls from here should show code instantly
+    QList<RVA> neighbours = Core()->getCallNeighbourFunctions(decompiledFunctionAddr);
+    dec->prefetchFunctions(neighbours.mid(0, MAX_PREFETCH_FUNCTIONS));
 }
 
 void DecompilerWidget::refreshDecompiler()
@@ -188,8 +209,13 @@ QTextCursor DecompilerWidget::getCursorForAddress(RVA addr)
     return cursor;
 }
 
-void DecompilerWidget::decompilationFinished(AnnotatedCode code)
+void DecompilerWidget::decompilationFinished(RVA fcnAddr, AnnotatedCode code)
 {
+    if (fcnAddr != decompiledFunctionAddr) {
+        // Another widget's request or a prefetched function
+        return;
+    }
+    waitingForCode = false;
     ui->progressLabel->setVisible(false);
     ui->decompilerComboBox->setEnabled(decompilerSelectionEnabled);
     updateRefreshButton();
@@ -206,11 +232,6 @@ void DecompilerWidget::decompilationFinished(AnnotatedCode code)
         highlightPC();
         highlightBreakpoints();
     }
-
-    if (decompilerWasBusy) {
-        decompilerWasBusy = false;
-        doAutoRefresh();
-    }
 }
 
 void DecompilerWidget::decompilerSelected()
@@ -350,7 +371,7 @@ bool DecompilerWidget::eventFilter(QObject *obj, QEvent *event)
 
 void DecompilerWidget::highlightPC()
 {
-    RVA PCAddress = Core()->getProgramCounterValue();
+    RVA PCAddress = Core()->getDebugState()->getProgramCounter();
     if (PCAddress == RVA_INVALID || (Core()->getFunctionStart(PCAddress) != decompiledFunctionAddr)) {
         return;
     }
@@ -38,7 +38,7 @@ private slots:
     void decompilerSelected();
     void cursorPositionChanged();
     void seekChanged();
-    void decompilationFinished(AnnotatedCode code);
+    void decompilationFinished(RVA fcnAddr, AnnotatedCode code);
 
 private:
     std::unique_ptr<Ui::DecompilerWidget> ui;
@@ -50,10 +50,9 @@ private:
     bool autoRefreshEnabled;
 
     /**
-     * True if doRefresh() was called, but the decompiler was still running
-     * This means, after the decompiler has finished, it should be refreshed immediately.
+     * True if the code for decompiledFunctionAddr was requested, but has not arrived yet
      */
-    bool decompilerWasBusy;
+    bool waitingForCode = false;
 
     RVA decompiledFunctionAddr;
     AnnotatedCode code;
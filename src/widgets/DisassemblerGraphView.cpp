@@ -7,6 +7,8 @@
 #include "common/Configuration.h"
 #include "common/CachedFontMetrics.h"
 #include "common/TempConfig.h"
+#include "common/DebugStateSnapshot.h"
+#include "common/TraceManager.h"
 #include "common/SyntaxHighlighter.h"
 #include "common/BasicBlockHighlighter.h"
 #include "common/BasicInstructionHighlighter.h"
@@ -50,6 +52,7 @@ DisassemblerGraphView::DisassemblerGraphView(QWidget *parent, CutterSeekable *se
       actionUnhighlightInstruction(this)
 {
     highlight_token = nullptr;
+    graphCache.setMaxCost(MAX_GRAPH_CACHE_INSTRUCTIONS);
     auto *layout = new QVBoxLayout(this);
     // Signals that require a refresh all
     connect(Core(), SIGNAL(refreshAll()), this, SLOT(refreshView()));
@@ -60,9 +63,16 @@ DisassemblerGraphView::DisassemblerGraphView(QWidget *parent, CutterSeekable *se
     connect(Core(), SIGNAL(varsChanged()), this, SLOT(refreshView()));
     connect(Core(), SIGNAL(instructionChanged(RVA)), this, SLOT(refreshView()));
     connect(Core(), SIGNAL(functionsChanged()), this, SLOT(refreshView()));
-    connect(Core(), SIGNAL(graphOptionsChanged()), this, SLOT(refreshView()));
+    connect(Core(), &CutterCore::graphOptionsChanged, this, [this]() {
+        graphCache.clear();
+        refreshView();
+    });
     connect(Core(), SIGNAL(asmOptionsChanged()), this, SLOT(refreshView()));
     connect(Core(), SIGNAL(refreshCodeViews()), this, SLOT(refreshView()));
+    connect(Core()->getTraceManager(), &TraceManager::hitCountsChanged, this, [this]() {
+        setCacheDirty();
+        viewport()->update();
+    });
 
     connect(Config(), SIGNAL(colorsUpdated()), this, SLOT(colorsUpdatedSlot()));
     connect(Config(), SIGNAL(fontsUpdated()), this, SLOT(fontsUpdatedSlot()));
@@ -117,6 +127,7 @@ DisassemblerGraphView::DisassemblerGraphView(QWidget *parent, CutterSeekable *se
         GraphView::Layout layout = item.second;
         connect(action, &QAction::triggered, this, [this, layout]() {
             setGraphLayout(layout);
+            graphCache.clear();
             refreshView();
             onSeekChanged(this->seekable->getOffset()); // try to keep the view on current block
         });
@@ -219,6 +230,24 @@ void DisassemblerGraphView::refreshView()
 
 void DisassemblerGraphView::loadCurrentGraph()
 {
+    if (graphCacheRevision != Core()->getAnalysisRevision()) {
+        graphCache.clear();
+        graphCacheRevision = Core()->getAnalysisRevision();
+    }
+
+    if (highlight_token) {
+        delete highlight_token;
+        highlight_token = nullptr;
+    }
+
+    RAnalFunction *fcn = Core()->functionIn(seekable->getOffset());
+    if (fcn) {
+        currentFcnAddr = fcn->addr;
+        if (restoreCachedGraph(fcn->addr)) {
+            return;
+        }
+    }
+
     TempConfig tempConfig;
     tempConfig.set("scr.color", COLOR_MODE_16M)
     .set("asm.bb.line", false)
@@ -226,37 +255,17 @@ void DisassemblerGraphView::loadCurrentGraph()
     .set("asm.lines.fcn", false);
 
     QJsonArray functions;
-    RAnalFunction *fcn = Core()->functionIn(seekable->getOffset());
     if (fcn) {
-        currentFcnAddr = fcn->addr;
         QJsonDocument functionsDoc = Core()->cmdj("agJ " + RAddressString(fcn->addr));
         functions = functionsDoc.array();
     }
 
     disassembly_blocks.clear();
     blocks.clear();
-
-    if (highlight_token) {
-        delete highlight_token;
-        highlight_token = nullptr;
-    }
+    setCacheDirty();
 
     emptyGraph = functions.isEmpty();
-    if (emptyGraph) {
-        // If there's no function to print, just add a message
-        if (!emptyText) {
-            emptyText = new QLabel(this);
-            emptyText->setText(tr("No function detected. Cannot display graph."));
-            emptyText->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
-            layout()->addWidget(emptyText);
-            layout()->setAlignment(emptyText, Qt::AlignHCenter);
-        }
-        emptyText->setVisible(true);
-    } else if (emptyText) {
-        emptyText->setVisible(false);
-    }
-    // Refresh global "empty graph" variable so other widget know there is nothing to show here
-    Core()->setGraphEmpty(emptyGraph);
+    updateEmptyGraphState();
 
     QJsonValue funcRef = functions.first();
     QJsonObject func = funcRef.toObject();
@@ -353,9 +362,67 @@ void DisassemblerGraphView::loadCurrentGraph()
 
     if (!func["blocks"].toArray().isEmpty()) {
         computeGraph(entry);
+        if (fcn && !isLayoutPending()) {
+            storeCachedGraph(fcn->addr);
+        }
     }
 }
 
+void DisassemblerGraphView::updateEmptyGraphState()
+{
+    if (emptyGraph) {
+        // If there's no function to print, just add a message
+        if (!emptyText) {
+            emptyText = new QLabel(this);
+            emptyText->setText(tr("No function detected. Cannot display graph."));
+            emptyText->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
+            layout()->addWidget(emptyText);
+            layout()->setAlignment(emptyText, Qt::AlignHCenter);
+        }
+        emptyText->setVisible(true);
+    } else if (emptyText) {
+        emptyText->setVisible(false);
+    }
+    // Refresh global "empty graph" variable so other widget know there is nothing to show here
+    Core()->setGraphEmpty(emptyGraph);
+}
+
+bool DisassemblerGraphView::restoreCachedGraph(RVA fcnAddr)
+{
+    CachedGraph *cached = graphCache.object(fcnAddr);
+    if (!cached) {
+        return false;
+    }
+    disassembly_blocks = cached->disassemblyBlocks;
+    setEntry(cached->entry);
+    setComputedGraph(cached->blocks, cached->width, cached->height);
+
+    emptyGraph = false;
+    updateEmptyGraphState();
+    windowTitle = cached->windowTitle;
+    emit nameChanged(windowTitle);
+    return true;
+}
+
+void DisassemblerGraphView::storeCachedGraph(RVA fcnAddr)
+{
+    if (emptyGraph || blocks.empty()) {
+        return;
+    }
+    int instructions = 0;
+    for (const auto &blockIt : disassembly_blocks) {
+        instructions += static_cast<int>(blockIt.second.instrs.size());
+    }
+    auto cached = new CachedGraph;
+    cached->disassemblyBlocks = disassembly_blocks;
+    cached->blocks = blocks;
+    cached->width = width;
+    cached->height = height;
+    cached->entry = getEntry();
+    cached->windowTitle = windowTitle;
+    graphCache.insert(fcnAddr, cached, std::max(1, instructions));
+}
+
 DisassemblerGraphView::EdgeConfigurationMapping DisassemblerGraphView::getEdgeConfigurations()
 {
     EdgeConfigurationMapping result;
@@ -445,7 +512,7 @@ void DisassemblerGraphView::drawBlock(QPainter &p, GraphView::GraphBlock &block,
 
     // Figure out if the current block is selected
     RVA addr = seekable->getOffset();
-    RVA PCAddr = Core()->getProgramCounterValue();
+    RVA PCAddr = Core()->getDebugState()->getProgramCounter();
     for (const Instr &instr : db.instrs) {
         if (instr.contains(addr) && interactive) {
             block_selected = true;
@@ -537,6 +604,7 @@ void DisassemblerGraphView::drawBlock(QPainter &p, GraphView::GraphBlock &block,
     }
 
     auto bih = Core()->getBIHighlighter();
+    TraceManager *traceManager = Core()->getTraceManager();
     for (const Instr &instr : db.instrs) {
         const QRect instrRect = QRect(static_cast<int>(block.x + charWidth), y,
                                       static_cast<int>(block.width - (10 + padding)),
@@ -549,6 +617,8 @@ void DisassemblerGraphView::drawBlock(QPainter &p, GraphView::GraphBlock &block,
             instrColor = PCSelectionColor;
         } else if (auto background = bih->getBasicInstruction(instr.addr)) {
             instrColor = background->color;
+        } else {
+            instrColor = traceManager->getHitCountColor(instr.addr);
         }
 
         if (instrColor.isValid()) {
@@ -718,12 +788,14 @@ void DisassemblerGraphView::colorsUpdatedSlot()
 
     mCommentColor = ConfigColor("comment");
     initFont();
+    graphCache.clear();
     refreshView();
 }
 
 void DisassemblerGraphView::fontsUpdatedSlot()
 {
     initFont();
+    graphCache.clear();
     refreshView();
 }
 
@@ -972,6 +1044,21 @@ void DisassemblerGraphView::blockClicked(GraphView::GraphBlock &block, QMouseEve
     viewport()->update();
 }
 
+void DisassemblerGraphView::graphLayoutComputed()
+{
+    // Blocks moved, bring the current instruction back into view
+    RVA addr = seekable->getOffset();
+    if (DisassemblyBlock *db = blockForAddress(addr)) {
+        transition_dont_seek = true;
+        showBlock(&blocks[db->entry]);
+        showInstruction(blocks[db->entry], addr);
+    }
+    if (graphCacheRevision == Core()->getAnalysisRevision()) {
+        storeCachedGraph(currentFcnAddr);
+    }
+    emit viewRefreshed();
+}
+
 void DisassemblerGraphView::blockContextMenuRequested(GraphView::GraphBlock &block,
                                                       QContextMenuEvent *event, QPoint pos)
 {
@@ -1250,8 +1337,28 @@ void DisassemblerGraphView::resizeEvent(QResizeEvent *event)
 
 void DisassemblerGraphView::paintEvent(QPaintEvent *event)
 {
-    // DisassemblerGraphView is always dirty
-    setCacheDirty();
+    // Only repaint the blocks affected by a change of the selection, everything else
+    // in the graph was dirtied by computeGraph() already
+    RVA offset = seekable->getOffset();
+    RVA pcAddr = Core()->getDebugState()->getProgramCounter();
+    QString highlightToken = highlight_token ? highlight_token->content : QString();
+    if (pcAddr != paintedPCAddr || highlightToken != paintedHighlightToken) {
+        setCacheDirty();
+    } else if (offset != paintedOffset || currentBlockAddress != paintedBlockAddress) {
+        for (RVA addr : { offset, paintedOffset }) {
+            if (DisassemblyBlock *db = blockForAddress(addr)) {
+                setBlockDirty(db->entry);
+            }
+        }
+        // Edges of the current block are drawn wider
+        setBlockDirty(currentBlockAddress);
+        setBlockDirty(paintedBlockAddress);
+    }
+    paintedOffset = offset;
+    paintedBlockAddress = currentBlockAddress;
+    paintedPCAddr = pcAddr;
+    paintedHighlightToken = highlightToken;
+
     GraphView::paintEvent(event);
 }
 
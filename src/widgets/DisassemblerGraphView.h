@@ -7,6 +7,7 @@
 #include <QPainter>
 #include <QShortcut>
 #include <QLabel>
+#include <QCache>
 
 #include "widgets/GraphView.h"
 #include "menus/DisassemblyContextMenu.h"
@@ -154,6 +155,7 @@ protected:
     void blockContextMenuRequested(GraphView::GraphBlock &block, QContextMenuEvent *event,
                                    QPoint pos) override;
     void contextMenuEvent(QContextMenuEvent *event) override;
+    void graphLayoutComputed() override;
 
 private slots:
     void on_actionExportGraph_triggered();
@@ -173,6 +175,14 @@ private:
     bool emptyGraph;
     ut64 currentBlockAddress = RVA_INVALID;
 
+    /**
+     * @brief Selection state the rendered graph was painted with
+     */
+    RVA paintedOffset = RVA_INVALID;
+    ut64 paintedBlockAddress = RVA_INVALID;
+    RVA paintedPCAddr = RVA_INVALID;
+    QString paintedHighlightToken;
+
     DisassemblyContextMenu *blockMenu;
     QMenu *contextMenu;
 
@@ -201,7 +211,7 @@ private:
     void seekInstruction(bool previous_instr);
     CutterSeekable *seekable = nullptr;
     QList<QShortcut *> shortcuts;
-    QList<RVA> breakpoints;
+    QVector<RVA> breakpoints;
 
     QColor disassemblyBackgroundColor;
     QColor disassemblySelectedBackgroundColor;
@@ -231,6 +241,30 @@ private:
 
     QLabel *emptyText = nullptr;
 
+    /**
+     * @brief Parsed blocks and layout of a function, as they were when last shown
+     */
+    struct CachedGraph {
+        std::unordered_map<ut64, DisassemblyBlock> disassemblyBlocks;
+        GraphLayout::Graph blocks;
+        int width;
+        int height;
+        ut64 entry;
+        QString windowTitle;
+    };
+
+    /**
+     * @brief Recently shown functions, costed by instruction count.
+     * Only valid for graphCacheRevision of the analysis.
+     */
+    QCache<RVA, CachedGraph> graphCache;
+    quint64 graphCacheRevision = 0;
+    static const int MAX_GRAPH_CACHE_INSTRUCTIONS = 200000;
+
+    bool restoreCachedGraph(RVA fcnAddr);
+    void storeCachedGraph(RVA fcnAddr);
+    void updateEmptyGraphState();
+
     static const int KEY_ZOOM_IN;
     static const int KEY_ZOOM_OUT;
     static const int KEY_ZOOM_RESET;
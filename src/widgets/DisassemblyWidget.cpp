@@ -3,7 +3,9 @@
 #include "common/Configuration.h"
 #include "common/Helpers.h"
 #include "common/TempConfig.h"
+#include "common/DebugStateSnapshot.h"
 #include "common/SelectionHighlight.h"
+#include "common/TraceManager.h"
 #include "core/MainWindow.h"
 
 #include <QApplication>
@@ -38,6 +40,80 @@ static DisassemblyTextBlockUserData *getUserData(const QTextBlock &block)
     return static_cast<DisassemblyTextBlockUserData *>(userData);
 }
 
+/**
+ * Number of lines fetched from r2 in addition to the visible ones, so the following
+ * scroll steps can be served from DisassemblyLineCache.
+ */
+static const int DISASSEMBLY_PREFETCH_LINES = 256;
+
+void DisassemblyLineCache::clear()
+{
+    entries.clear();
+    firstLineIndex.clear();
+}
+
+void DisassemblyLineCache::setLines(const QList<DisassemblyLine> &lines)
+{
+    clear();
+    entries.reserve(lines.size());
+    for (const DisassemblyLine &line : lines) {
+        if (!entries.isEmpty() && line.offset < entries.last().line.offset) {
+            // wrapped around the end of the address space
+            break;
+        }
+        if (!firstLineIndex.contains(line.offset)) {
+            firstLineIndex.insert(line.offset, entries.size());
+        }
+        Entry entry;
+        entry.line = line;
+        entries.append(entry);
+    }
+}
+
+const QTextDocumentFragment &DisassemblyLineCache::fragmentAt(int index)
+{
+    Entry &entry = entries[index];
+    if (!entry.parsed) {
+        entry.fragment = QTextDocumentFragment::fromHtml(entry.line.text);
+        entry.parsed = true;
+    }
+    return entry.fragment;
+}
+
+RVA DisassemblyLineCache::nextOpAddr(RVA offset, int count) const
+{
+    int index = indexOf(offset);
+    if (index < 0) {
+        return RVA_INVALID;
+    }
+    RVA current = offset;
+    for (int i = index + 1; i < entries.size() && count > 0; i++) {
+        RVA lineOffset = entries.at(i).line.offset;
+        if (lineOffset != current) {
+            current = lineOffset;
+            count--;
+        }
+    }
+    return count == 0 ? current : RVA_INVALID;
+}
+
+RVA DisassemblyLineCache::prevOpAddr(RVA offset, int count) const
+{
+    int index = indexOf(offset);
+    if (index < 0) {
+        return RVA_INVALID;
+    }
+    RVA current = offset;
+    for (int i = index - 1; i >= 0 && count > 0; i--) {
+        RVA lineOffset = entries.at(i).line.offset;
+        if (lineOffset != current) {
+            current = lineOffset;
+            count--;
+        }
+    }
+    return count == 0 ? current : RVA_INVALID;
+}
+
 DisassemblyWidget::DisassemblyWidget(MainWindow *main, QAction *action)
     :   MemoryDockWidget(MemoryWidgetType::Disassembly, main, action)
     ,   mCtxMenu(new DisassemblyContextMenu(this, main))
@@ -144,24 +220,35 @@ DisassemblyWidget::DisassemblyWidget(MainWindow *main, QAction *action)
         }
     });
 
-    connect(Core(), SIGNAL(commentsChanged()), this, SLOT(refreshDisasm()));
-    connect(Core(), SIGNAL(flagsChanged()), this, SLOT(refreshDisasm()));
-    connect(Core(), SIGNAL(functionsChanged()), this, SLOT(refreshDisasm()));
+    connect(Core(), SIGNAL(commentsChanged()), this, SLOT(invalidateDisasm()));
+    connect(Core(), SIGNAL(flagsChanged()), this, SLOT(invalidateDisasm()));
+    connect(Core(), SIGNAL(functionsChanged()), this, SLOT(invalidateDisasm()));
     connect(Core(), SIGNAL(functionRenamed(const QString &, const QString &)), this,
-            SLOT(refreshDisasm()));
-    connect(Core(), SIGNAL(varsChanged()), this, SLOT(refreshDisasm()));
-    connect(Core(), SIGNAL(asmOptionsChanged()), this, SLOT(refreshDisasm()));
+            SLOT(invalidateDisasm()));
+    connect(Core(), SIGNAL(varsChanged()), this, SLOT(invalidateDisasm()));
+    connect(Core(), SIGNAL(asmOptionsChanged()), this, SLOT(invalidateDisasm()));
     connect(Core(), &CutterCore::instructionChanged, this, [this](RVA offset) {
+        lineCache.clear();
         if (offset >= topOffset && offset <= bottomOffset) {
             refreshDisasm();
         }
     });
-    connect(Core(), SIGNAL(refreshCodeViews()), this, SLOT(refreshDisasm()));
+    connect(Core(), SIGNAL(refreshCodeViews()), this, SLOT(invalidateDisasm()));
+    // Memory and addresses may change while debugging, the next refresh has to query r2 again
+    connect(Core(), &CutterCore::registersChanged, this, [this]() {
+        lineCache.clear();
+    });
+    connect(Core(), &CutterCore::codeRebased, this, [this]() {
+        lineCache.clear();
+    });
+    connect(Core()->getTraceManager(), &TraceManager::hitCountsChanged,
+            this, &DisassemblyWidget::highlightCurrentLine);
 
     connect(Config(), SIGNAL(fontsUpdated()), this, SLOT(fontsUpdatedSlot()));
     connect(Config(), SIGNAL(colorsUpdated()), this, SLOT(colorsUpdatedSlot()));
 
     connect(Core(), &CutterCore::refreshAll, this, [this]() {
+        lineCache.clear();
         refreshDisasm(seekable->getOffset());
     });
     refreshDisasm(seekable->getOffset());
@@ -274,12 +361,11 @@ void DisassemblyWidget::refreshDisasm(RVA offset)
     int horizontalScrollValue = mDisasTextEdit->horizontalScrollBar()->value();
     mDisasTextEdit->setLockScroll(true); // avoid flicker
 
-    // Retrieve disassembly lines
-    {
-        TempConfig tempConfig;
-        tempConfig.set("scr.color", COLOR_MODE_16M)
-		.set("asm.lines", false);
-        lines = Core()->disassembleLines(topOffset, maxLines);
+    // Retrieve disassembly lines, from the cache if possible
+    int firstLine = fetchLines(topOffset, maxLines);
+    lines.clear();
+    for (int i = firstLine; i >= 0 && i < lineCache.size() && lines.size() < maxLines; i++) {
+        lines << lineCache.at(i).line;
     }
 
     connectCursorPositionChanged(true);
@@ -287,11 +373,12 @@ void DisassemblyWidget::refreshDisasm(RVA offset)
     mDisasTextEdit->document()->clear();
     QTextCursor cursor(mDisasTextEdit->document());
     QTextBlockFormat regular = cursor.blockFormat();
-    for (const DisassemblyLine &line : lines) {
+    for (int i = 0; i < lines.size(); i++) {
+        const DisassemblyLine &line = lines.at(i);
         if (line.offset < topOffset) { // overflow
             break;
         }
-        cursor.insertHtml(line.text);
+        cursor.insertFragment(lineCache.fragmentAt(firstLine + i));
         if (Core()->isBreakpoint(breakpoints, line.offset)) {
             QTextBlockFormat f;
             f.setBackground(ConfigColor("gui.breakpoint_background"));
@@ -331,6 +418,41 @@ void DisassemblyWidget::refreshDisasm(RVA offset)
     leftPanel->update();
 }
 
+void DisassemblyWidget::invalidateDisasm()
+{
+    lineCache.clear();
+    refreshDisasm();
+}
+
+int DisassemblyWidget::fetchLines(RVA offset, int count)
+{
+    int index = lineCache.indexOf(offset);
+    if (index >= 0 && index + count <= lineCache.size()) {
+        return index;
+    }
+
+    // When scrolling up, also fetch the instructions before offset
+    RVA start = offset;
+    if (!lineCache.isEmpty() && offset < lineCache.at(0).line.offset) {
+        RVA prevOffset = Core()->prevOpAddr(offset, DISASSEMBLY_PREFETCH_LINES / 2);
+        if (prevOffset < offset) {
+            start = prevOffset;
+        }
+    }
+
+    TempConfig tempConfig;
+    tempConfig.set("scr.color", COLOR_MODE_16M)
+    .set("asm.lines", false);
+    lineCache.setLines(Core()->disassembleLines(start, count + DISASSEMBLY_PREFETCH_LINES));
+    index = lineCache.indexOf(offset);
+    if (index < 0 && start != offset) {
+        // disassembling from start did not hit offset
+        lineCache.setLines(Core()->disassembleLines(offset, count + DISASSEMBLY_PREFETCH_LINES));
+        index = lineCache.indexOf(offset);
+    }
+    return index;
+}
+
 
 void DisassemblyWidget::scrollInstructions(int count)
 {
@@ -340,12 +462,18 @@ void DisassemblyWidget::scrollInstructions(int count)
 
     RVA offset;
     if (count > 0) {
-        offset = Core()->nextOpAddr(topOffset, count);
+        offset = lineCache.nextOpAddr(topOffset, count);
+        if (offset == RVA_INVALID) {
+            offset = Core()->nextOpAddr(topOffset, count);
+        }
         if (offset < topOffset) {
             offset = RVA_MAX;
         }
     } else {
-        offset = Core()->prevOpAddr(topOffset, -count);
+        offset = lineCache.prevOpAddr(topOffset, -count);
+        if (offset == RVA_INVALID) {
+            offset = Core()->prevOpAddr(topOffset, -count);
+        }
         if (offset > topOffset) {
             offset = 0;
         }
@@ -406,8 +534,23 @@ void DisassemblyWidget::highlightCurrentLine()
     // Highlight all the words in the document same as the current one
     extraSelections.append(createSameWordsSelections(mDisasTextEdit, curHighlightedWord));
 
+    // Highlight the lines executed by the open trace, by how often they were executed
+    TraceManager *traceManager = Core()->getTraceManager();
+    if (traceManager->getMaxHitCount() > 0) {
+        for (QTextBlock block = mDisasTextEdit->document()->begin(); block.isValid();
+                block = block.next()) {
+            QColor hitCountColor = traceManager->getHitCountColor(readDisassemblyOffset(QTextCursor(block)));
+            if (hitCountColor.isValid()) {
+                highlightSelection.cursor = QTextCursor(block);
+                highlightSelection.format.setBackground(hitCountColor);
+                highlightSelection.format.setProperty(QTextFormat::FullWidthSelection, true);
+                extraSelections.append(highlightSelection);
+            }
+        }
+    }
+
     // highlight PC line
-    RVA PCAddr = Core()->getProgramCounterValue();
+    RVA PCAddr = Core()->getDebugState()->getProgramCounter();
     highlightSelection.cursor = cursor;
     highlightSelection.cursor.movePosition(QTextCursor::Start);
     if (PCAddr != RVA_INVALID) {
@@ -680,7 +823,7 @@ void DisassemblyWidget::fontsUpdatedSlot()
 void DisassemblyWidget::colorsUpdatedSlot()
 {
     setupColors();
-    refreshDisasm();
+    invalidateDisasm();
 }
 
 void DisassemblyWidget::setupFonts()
@@ -11,6 +11,9 @@
 #include <QPlainTextEdit>
 #include <QShortcut>
 #include <QAction>
+#include <QTextDocumentFragment>
+#include <QVector>
+#include <QHash>
 
 
 class DisassemblyTextEdit;
@@ -18,6 +21,54 @@ class DisassemblyScrollArea;
 class DisassemblyContextMenu;
 class DisassemblyLeftPanel;
 
+/**
+ * @brief Consecutive disassembly lines around the current view, together with their
+ * parsed rich text, so scrolling and seeking inside already disassembled code neither
+ * queries r2 nor parses html again.
+ */
+class DisassemblyLineCache
+{
+public:
+    struct Entry {
+        DisassemblyLine line;
+        QTextDocumentFragment fragment;
+        bool parsed = false;
+    };
+
+    void clear();
+    void setLines(const QList<DisassemblyLine> &lines);
+
+    int size() const                        { return entries.size(); }
+    bool isEmpty() const                    { return entries.isEmpty(); }
+    const Entry &at(int index) const        { return entries.at(index); }
+
+    /**
+     * @brief Rich text of the line at index, parsed on first use
+     */
+    const QTextDocumentFragment &fragmentAt(int index);
+
+    /**
+     * @return index of the first line at offset, -1 if offset is not cached
+     */
+    int indexOf(RVA offset) const           { return firstLineIndex.value(offset, -1); }
+
+    /**
+     * @brief Equivalent of CutterCore::nextOpAddr() inside the cached lines
+     * @return RVA_INVALID if not enough lines are cached
+     */
+    RVA nextOpAddr(RVA offset, int count) const;
+
+    /**
+     * @brief Equivalent of CutterCore::prevOpAddr() inside the cached lines
+     * @return RVA_INVALID if not enough lines are cached
+     */
+    RVA prevOpAddr(RVA offset, int count) const;
+
+private:
+    QVector<Entry> entries;
+    QHash<RVA, int> firstLineIndex;
+};
+
 class DisassemblyWidget : public MemoryDockWidget
 {
     Q_OBJECT
@@ -41,6 +92,10 @@ public slots:
 protected slots:
     void on_seekChanged(RVA offset);
     void refreshDisasm(RVA offset = RVA_INVALID);
+    /**
+     * @brief Drop all cached lines and refresh, for changes that affect the disassembly text
+     */
+    void invalidateDisasm();
 
     bool updateMaxLines();
 
@@ -68,6 +123,14 @@ private:
     bool seekFromCursor;
 
     RefreshDeferrer *disasmRefresh;
+    DisassemblyLineCache lineCache;
+
+    /**
+     * @brief Make sure lineCache holds count lines starting at offset, fetching a bigger
+     * page from r2 if it does not
+     * @return index of the first line at offset in lineCache, -1 if there is none
+     */
+    int fetchLines(RVA offset, int count);
 
     RVA readCurrentDisassemblyOffset();
     RVA readDisassemblyOffset(QTextCursor tc);
@@ -75,7 +138,7 @@ private:
     void keyPressEvent(QKeyEvent *event) override;
     QString getWindowTitle() const override;
 
-    QList<RVA> breakpoints;
+    QVector<RVA> breakpoints;
 
     void setupFonts();
     void setupColors();
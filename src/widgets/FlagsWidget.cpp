@@ -92,40 +92,44 @@ const FlagDescription *FlagsModel::description(QModelIndex index) const
 }
 
 FlagsSortFilterProxyModel::FlagsSortFilterProxyModel(FlagsModel *source_model, QObject *parent)
-    : AddressableFilterProxyModel(source_model, parent)
+    : AddressableFilterProxyModel(source_model, parent),
+      flags(source_model->flags)
 {
+    enableRowIndex();
 }
 
-bool FlagsSortFilterProxyModel::filterAcceptsRow(int row, const QModelIndex &parent) const
+bool FlagsSortFilterProxyModel::filterAcceptsRow(int row, const QModelIndex &) const
 {
-    QModelIndex index = sourceModel()->index(row, 0, parent);
-    FlagDescription flag = index.data(FlagsModel::FlagDescriptionRole).value<FlagDescription>();
-    return flag.name.contains(filterRegExp());
+    return rowMatchesFilter(row);
 }
 
-bool FlagsSortFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+QString FlagsSortFilterProxyModel::rowFilterText(int row) const
 {
-    auto source = static_cast<FlagsModel *>(sourceModel());
-    auto left_flag = source->description(left);
-    auto right_flag = source->description(right);
+    return flags->at(row).name;
+}
+
+bool FlagsSortFilterProxyModel::lessThanRows(int column, int leftRow, int rightRow) const
+{
+    const FlagDescription &left_flag = flags->at(leftRow);
+    const FlagDescription &right_flag = flags->at(rightRow);
 
-    switch (left.column()) {
+    switch (column) {
     case FlagsModel::SIZE:
-        if (left_flag->size != right_flag->size)
-            return left_flag->size < right_flag->size;
+        if (left_flag.size != right_flag.size)
+            return left_flag.size < right_flag.size;
     // fallthrough
     case FlagsModel::OFFSET:
-        if (left_flag->offset != right_flag->offset)
-            return left_flag->offset < right_flag->offset;
+        if (left_flag.offset != right_flag.offset)
+            return left_flag.offset < right_flag.offset;
     // fallthrough
     case FlagsModel::NAME:
-        return left_flag->name < right_flag->name;
+        return left_flag.name < right_flag.name;
     default:
         break;
     }
 
     // fallback
-    return left_flag->offset < right_flag->offset;
+    return left_flag.offset < right_flag.offset;
 }
 
 
@@ -254,12 +258,6 @@ void FlagsWidget::refreshFlags()
     flags_model->endResetModel();
 
     tree->showItemsNumber(flags_proxy_model->rowCount());
-
-    // TODO: this is not a very good place for the following:
-    QStringList flagNames;
-    for (const FlagDescription &i : flags)
-        flagNames.append(i.name);
-    main->refreshOmniBar(flagNames);
 }
 
 void FlagsWidget::setScrollMode()
@@ -16,11 +16,13 @@
 class MainWindow;
 class QTreeWidgetItem;
 class FlagsWidget;
+class FlagsSortFilterProxyModel;
 
 
 class FlagsModel: public AddressableItemModel<QAbstractListModel>
 {
     friend FlagsWidget;
+    friend FlagsSortFilterProxyModel;
 
 private:
     QList<FlagDescription> *flags;
@@ -55,7 +57,11 @@ public:
 
 protected:
     bool filterAcceptsRow(int row, const QModelIndex &parent) const override;
-    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+    QString rowFilterText(int row) const override;
+    bool lessThanRows(int column, int leftRow, int rightRow) const override;
+
+private:
+    const QList<FlagDescription> *flags;
 };
 
 
@@ -5,12 +5,14 @@
 #include "common/Helpers.h"
 #include "dialogs/RenameDialog.h"
 #include "common/FunctionsTask.h"
+#include "common/PreviewCache.h"
 #include "common/TempConfig.h"
 #include "menus/AddressableItemContextMenu.h"
 
 #include <algorithm>
 #include <QMenu>
 #include <QDebug>
+#include <QHash>
 #include <QString>
 #include <QResource>
 #include <QShortcut>
@@ -21,7 +23,6 @@
 namespace {
 
 static const int kMaxTooltipWidth = 400;
-static const int kMaxTooltipDisasmPreviewLines = 10;
 static const int kMaxTooltipHighlightsLines = 5;
 
 }
@@ -41,6 +42,7 @@ FunctionModel::FunctionModel(QList<FunctionDescription> *functions, QSet<RVA> *i
     connect(Core(), SIGNAL(seekChanged(RVA)), this, SLOT(seekChanged(RVA)));
     connect(Core(), SIGNAL(functionRenamed(const QString &, const QString &)), this,
             SLOT(functionRenamed(QString, QString)));
+    connect(Core(), &CutterCore::varsChanged, this, &FunctionModel::varsChanged);
 }
 
 QModelIndex FunctionModel::index(int row, int column, const QModelIndex &parent) const
@@ -109,11 +111,14 @@ QVariant FunctionModel::data(const QModelIndex &index, int role) const
         subnode = false;
     }
 
-    const FunctionDescription &function = functions->at(function_index);
-
     if (function_index >= functions->count())
         return QVariant();
 
+    if (role == Qt::DisplayRole && showsDetails(index, subnode))
+        loadDetails(function_index);
+
+    const FunctionDescription &function = functions->at(function_index);
+
     switch (role) {
     case Qt::DisplayRole:
         if (nested) {
@@ -186,10 +191,13 @@ QVariant FunctionModel::data(const QModelIndex &index, int role) const
         return static_cast<int>(Qt::AlignLeft | Qt::AlignVCenter);
 
     case Qt::ToolTipRole: {
-
-        QStringList disasmPreview = Core()->getDisassemblyPreview(function.offset,
-                                                                  kMaxTooltipDisasmPreviewLines);
-        const QStringList &summary = Core()->cmdList(QString("pdsf @ %1").arg(function.offset));
+        // generated in the background, the widget shows the tooltip once it is ready
+        AddressPreview preview;
+        if (!Core()->getPreviewCache()->getPreview(PreviewCache::FunctionPreview, function.offset,
+                                                   &preview))
+            return QVariant();
+        const QStringList &disasmPreview = preview.disassembly;
+        const QStringList &summary = preview.summary;
         const QFont &fnt = Config()->getFont();
         QFontMetrics fm{ fnt };
 
@@ -299,10 +307,15 @@ QString FunctionModel::name(const QModelIndex &index) const
 }
 
 void FunctionModel::seekChanged(RVA)
+{
+    updateCurrentIndexAndRows();
+}
+
+void FunctionModel::updateCurrentIndexAndRows()
 {
     int previousIndex = currentIndex;
     if (updateCurrentIndex()) {
-        if (previousIndex >= 0) {
+        if (previousIndex >= 0 && previousIndex < functions->count()) {
             emit dataChanged(index(previousIndex, 0), index(previousIndex, columnCount() - 1));
         }
         if (currentIndex >= 0) {
@@ -346,40 +359,191 @@ void FunctionModel::functionRenamed(const QString &prev_name, const QString &new
     }
 }
 
+void FunctionModel::varsChanged()
+{
+    if (functions->isEmpty())
+        return;
+
+    for (int i = 0; i < functions->count(); i++) {
+        (*functions)[i].detailsLoaded = false;
+        if (allDetailsNeeded)
+            loadDetails(i);
+    }
+    emit dataChanged(index(0, 0), index(functions->count() - 1, columnCount() - 1));
+}
+
+bool FunctionModel::showsDetails(const QModelIndex &index, bool subnode) const
+{
+    if (nested) {
+        // sub-nodes with nargs, nlocals and edges
+        return subnode && (index.row() == 3 || index.row() == 5 || index.row() == 7);
+    }
+    return isDetailColumn(index.column());
+}
+
+void FunctionModel::loadDetails(int row) const
+{
+    FunctionDescription &function = (*functions)[row];
+    if (!function.detailsLoaded)
+        Core()->loadFunctionDetails(function);
+}
+
+void FunctionModel::setAllDetailsNeeded(bool needed)
+{
+    allDetailsNeeded = needed;
+    if (needed) {
+        for (int i = 0; i < functions->count(); i++)
+            loadDetails(i);
+    }
+}
+
+void FunctionModel::setFunctions(const QList<FunctionDescription> &functions)
+{
+    beginResetModel();
+    *this->functions = functions;
+    if (allDetailsNeeded) {
+        for (int i = 0; i < functions.count(); i++)
+            loadDetails(i);
+    }
+    updateCurrentIndex();
+    endResetModel();
+}
+
+void FunctionModel::updateFunctions(const QList<FunctionDescription> &functions)
+{
+    QHash<RVA, int> newRows;
+    newRows.reserve(functions.count());
+    for (int i = 0; i < functions.count(); i++)
+        newRows.insert(functions.at(i).offset, i);
+
+    QSet<RVA> oldOffsets;
+    oldOffsets.reserve(this->functions->count());
+    int removed = 0;
+    for (const FunctionDescription &function : *this->functions) {
+        oldOffsets.insert(function.offset);
+        if (!newRows.contains(function.offset))
+            removed++;
+    }
+    int added = functions.count() - (this->functions->count() - removed);
+
+    // many single row changes are slower than rebuilding everything
+    if (this->functions->isEmpty() || removed + added > this->functions->count() / 2) {
+        setFunctions(functions);
+        return;
+    }
+
+    // remove the functions that are gone, one run of consecutive rows at a time
+    for (int last = this->functions->count() - 1; last >= 0; last--) {
+        if (newRows.contains(this->functions->at(last).offset))
+            continue;
+        int first = last;
+        while (first > 0 && !newRows.contains(this->functions->at(first - 1).offset))
+            first--;
+        beginRemoveRows(QModelIndex(), first, last);
+        this->functions->erase(this->functions->begin() + first, this->functions->begin() + last + 1);
+        endRemoveRows();
+        last = first;
+    }
+
+    // update renamed and resized functions in place
+    for (int i = 0; i < this->functions->count(); i++) {
+        FunctionDescription &function = (*this->functions)[i];
+        const FunctionDescription &updated = functions.at(newRows.value(function.offset));
+        if (function.name == updated.name && function.linearSize == updated.linearSize
+                && function.nbbs == updated.nbbs && function.calltype == updated.calltype
+                && function.stackframe == updated.stackframe)
+            continue;
+        function = updated;
+        if (allDetailsNeeded)
+            loadDetails(i);
+        emit dataChanged(index(i, 0), index(i, columnCount() - 1));
+    }
+
+    QList<FunctionDescription> addedFunctions;
+    for (const FunctionDescription &function : functions) {
+        if (!oldOffsets.contains(function.offset))
+            addedFunctions.append(function);
+    }
+    if (!addedFunctions.isEmpty()) {
+        int first = this->functions->count();
+        beginInsertRows(QModelIndex(), first, first + addedFunctions.count() - 1);
+        this->functions->append(addedFunctions);
+        if (allDetailsNeeded) {
+            for (int i = first; i < this->functions->count(); i++)
+                loadDetails(i);
+        }
+        endInsertRows();
+    }
+
+    updateCurrentIndexAndRows();
+}
+
+void FunctionModel::addFunction(const FunctionDescription &function)
+{
+    for (int i = 0; i < functions->count(); i++) {
+        if (functions->at(i).offset == function.offset)
+            return;
+    }
+    int row = functions->count();
+    beginInsertRows(QModelIndex(), row, row);
+    functions->append(function);
+    if (allDetailsNeeded)
+        loadDetails(row);
+    endInsertRows();
+    updateCurrentIndexAndRows();
+}
+
+void FunctionModel::removeFunction(RVA offset)
+{
+    for (int i = 0; i < functions->count(); i++) {
+        if (functions->at(i).offset == offset) {
+            beginRemoveRows(QModelIndex(), i, i);
+            functions->removeAt(i);
+            endRemoveRows();
+            updateCurrentIndexAndRows();
+            return;
+        }
+    }
+}
+
 FunctionSortFilterProxyModel::FunctionSortFilterProxyModel(FunctionModel *source_model,
                                                            QObject *parent)
-    : AddressableFilterProxyModel(source_model, parent)
+    : AddressableFilterProxyModel(source_model, parent),
+      functionModel(source_model)
 {
     setFilterCaseSensitivity(Qt::CaseInsensitive);
     setSortCaseSensitivity(Qt::CaseInsensitive);
+    enableRowIndex();
 }
 
-bool FunctionSortFilterProxyModel::filterAcceptsRow(int row, const QModelIndex &parent) const
+void FunctionSortFilterProxyModel::sort(int column, Qt::SortOrder order)
 {
-    QModelIndex index = sourceModel()->index(row, 0, parent);
-    FunctionDescription function = index.data(
-                                       FunctionModel::FunctionDescriptionRole).value<FunctionDescription>();
-    return function.name.contains(filterRegExp());
+    // details are only loaded for displayed rows unless they are compared
+    functionModel->setAllDetailsNeeded(!functionModel->isNested()
+                                       && FunctionModel::isDetailColumn(column));
+    AddressableFilterProxyModel::sort(column, order);
 }
 
-bool FunctionSortFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+bool FunctionSortFilterProxyModel::filterAcceptsRow(int row, const QModelIndex &parent) const
 {
-    if (!left.isValid() || !right.isValid())
-        return false;
-
-    if (left.parent().isValid() || right.parent().isValid())
-        return false;
+    // sub-nodes of nested functions are shown together with their function
+    return rowMatchesFilter(parent.isValid() ? parent.row() : row);
+}
 
-    FunctionDescription left_function = left.data(
-                                            FunctionModel::FunctionDescriptionRole).value<FunctionDescription>();
-    FunctionDescription right_function = right.data(
-                                             FunctionModel::FunctionDescriptionRole).value<FunctionDescription>();
+QString FunctionSortFilterProxyModel::rowFilterText(int row) const
+{
+    return functionModel->functions->at(row).name;
+}
 
+bool FunctionSortFilterProxyModel::lessThanRows(int column, int leftRow, int rightRow) const
+{
+    const FunctionDescription &left_function = functionModel->functions->at(leftRow);
+    const FunctionDescription &right_function = functionModel->functions->at(rightRow);
 
-    if (static_cast<FunctionModel *>(sourceModel())->isNested()) {
+    if (functionModel->nested) {
         return left_function.name < right_function.name;
     } else {
-        switch (left.column()) {
+        switch (column) {
         case FunctionModel::OffsetColumn:
             return left_function.offset < right_function.offset;
         case FunctionModel::SizeColumn:
@@ -387,10 +551,10 @@ bool FunctionSortFilterProxyModel::lessThan(const QModelIndex &left, const QMode
                 return left_function.linearSize < right_function.linearSize;
             break;
         case FunctionModel::ImportColumn: {
-            bool left_is_import = left.data(FunctionModel::IsImportRole).toBool();
-            bool right_is_import = right.data(FunctionModel::IsImportRole).toBool();
-            if (!left_is_import && right_is_import)
-                return true;
+            bool left_is_import = functionModel->functionIsImport(left_function.offset);
+            bool right_is_import = functionModel->functionIsImport(right_function.offset);
+            if (left_is_import != right_is_import)
+                return !left_is_import;
             break;
         }
         case FunctionModel::NameColumn:
@@ -480,6 +644,13 @@ FunctionsWidget::FunctionsWidget(MainWindow *main, QAction *action) :
     connect(this, SIGNAL(customContextMenuRequested(const QPoint &)),
             this, SLOT(showTitleContextMenu(const QPoint &)));
 
+    connect(Core()->getPreviewCache(), &PreviewCache::previewReady, this, [this](int type) {
+        if (type == PreviewCache::FunctionPreview) {
+            qhelpers::showPendingToolTip(ui->treeView);
+        }
+    });
+    connect(Core(), &CutterCore::functionAdded, this, &FunctionsWidget::functionAdded);
+    connect(Core(), &CutterCore::functionRemoved, functionModel, &FunctionModel::removeFunction);
     connect(Core(), &CutterCore::functionsChanged, this, &FunctionsWidget::refreshTree);
     connect(Core(), &CutterCore::codeRebased, this, &FunctionsWidget::refreshTree);
     connect(Core(), &CutterCore::refreshAll, this, &FunctionsWidget::refreshTree);
@@ -496,19 +667,20 @@ void FunctionsWidget::refreshTree()
     task = QSharedPointer<FunctionsTask>(new FunctionsTask());
     connect(task.data(), &FunctionsTask::fetchFinished,
     this, [this] (const QList<FunctionDescription> &functions) {
-        functionModel->beginResetModel();
-
-        this->functions = functions;
-
-        importAddresses.clear();
+        QSet<RVA> imports;
         for (const ImportDescription &import : Core()->getAllImports()) {
-            importAddresses.insert(import.plt);
+            imports.insert(import.plt);
         }
+        ut64 main = (ut64)Core()->cmdj("iMj").object()["vaddr"].toInt();
 
-        mainAdress = (ut64)Core()->cmdj("iMj").object()["vaddr"].toInt();
-
-        functionModel->updateCurrentIndex();
-        functionModel->endResetModel();
+        if (imports != importAddresses || main != mainAdress) {
+            // import and main highlighting may change on any row
+            importAddresses = imports;
+            mainAdress = main;
+            functionModel->setFunctions(functions);
+        } else {
+            functionModel->updateFunctions(functions);
+        }
 
         // resize offset and size columns
         qhelpers::adjustColumns(ui->treeView, 3, 0);
@@ -516,6 +688,14 @@ void FunctionsWidget::refreshTree()
     Core()->getAsyncTaskManager()->start(task);
 }
 
+void FunctionsWidget::functionAdded(RVA offset)
+{
+    FunctionDescription function;
+    if (Core()->getFunctionDescription(offset, function)) {
+        functionModel->addFunction(function);
+    }
+}
+
 void FunctionsWidget::changeSizePolicy(QSizePolicy::Policy hor, QSizePolicy::Policy ver)
 {
     ui->dockWidgetContents->setSizePolicy(hor, ver);
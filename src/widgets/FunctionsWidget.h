@@ -10,12 +10,14 @@
 class MainWindow;
 class FunctionsTask;
 class FunctionsWidget;
+class FunctionSortFilterProxyModel;
 
 class FunctionModel : public AddressableItemModel<>
 {
     Q_OBJECT
 
     friend FunctionsWidget;
+    friend FunctionSortFilterProxyModel;
 
 private:
     QList<FunctionDescription> *functions;
@@ -29,10 +31,19 @@ private:
 
     int currentIndex;
 
+    /**
+     * Count arguments, locals and edges of every function, not only of the displayed ones
+     */
+    bool allDetailsNeeded = false;
+
     bool functionIsImport(ut64 addr) const;
 
     bool functionIsMain(ut64 addr) const;
 
+    bool showsDetails(const QModelIndex &index, bool subnode) const;
+    void loadDetails(int row) const;
+    void updateCurrentIndexAndRows();
+
 public:
     static const int FunctionDescriptionRole = Qt::UserRole;
     static const int IsImportRole = Qt::UserRole + 1;
@@ -65,11 +76,37 @@ public:
         return nested;
     }
 
+    static bool isDetailColumn(int column)
+    {
+        return column == NargsColumn || column == NlocalsColumn || column == EdgesColumn;
+    }
+
+    /**
+     * @brief Load the details of all functions now and whenever they change, needed to sort by them
+     */
+    void setAllDetailsNeeded(bool needed);
+
+    /**
+     * @brief Replace all functions, resetting the model
+     */
+    void setFunctions(const QList<FunctionDescription> &functions);
+
+    /**
+     * @brief Replace all functions with row-level changes, keeping selection and scroll position
+     *
+     * Rows whose function did not change keep their loaded details.
+     */
+    void updateFunctions(const QList<FunctionDescription> &functions);
+
+    void addFunction(const FunctionDescription &function);
+    void removeFunction(RVA offset);
+
     RVA address(const QModelIndex &index) const override;
     QString name(const QModelIndex &index) const override;
 private slots:
     void seekChanged(RVA addr);
     void functionRenamed(const QString &prev_name, const QString &new_name);
+    void varsChanged();
 };
 
 
@@ -80,9 +117,15 @@ class FunctionSortFilterProxyModel : public AddressableFilterProxyModel
 public:
     FunctionSortFilterProxyModel(FunctionModel *source_model, QObject *parent = nullptr);
 
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
 protected:
     bool filterAcceptsRow(int row, const QModelIndex &parent) const override;
-    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+    QString rowFilterText(int row) const override;
+    bool lessThanRows(int column, int leftRow, int rightRow) const override;
+
+private:
+    FunctionModel *functionModel;
 };
 
 
@@ -104,6 +147,7 @@ private slots:
     void showTitleContextMenu(const QPoint &pt);
     void setTooltipStylesheet();
     void refreshTree();
+    void functionAdded(RVA offset);
 
 protected:
     void resizeEvent(QResizeEvent *event) override;
@@ -112,7 +156,7 @@ private:
     QSharedPointer<FunctionsTask> task;
     QList<FunctionDescription> functions;
     QSet<RVA> importAddresses;
-    ut64 mainAdress;
+    ut64 mainAdress = 0;
     FunctionModel *functionModel;
     FunctionSortFilterProxyModel *functionProxyModel;
 
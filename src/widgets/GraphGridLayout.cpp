@@ -5,6 +5,7 @@
 #include <queue>
 #include <stack>
 #include <cassert>
+#include <algorithm>
 
 // Vector functions
 template<class T>
@@ -93,6 +94,15 @@ std::vector<ut64> GraphGridLayout::topoSort(LayoutState &state, ut64 entry)
 
 void GraphGridLayout::CalculateLayout(std::unordered_map<ut64, GraphBlock> &blocks, ut64 entry,
                                       int &width, int &height) const
+{
+    CalculateLayoutInterruptible(blocks, entry, width, height, []() {
+        return false;
+    });
+}
+
+void GraphGridLayout::CalculateLayoutInterruptible(std::unordered_map<ut64, GraphBlock> &blocks,
+                                                   ut64 entry, int &width, int &height,
+                                                   const std::function<bool()> &interrupted) const
 {
     LayoutState layoutState;
     layoutState.blocks = &blocks;
@@ -104,7 +114,13 @@ void GraphGridLayout::CalculateLayout(std::unordered_map<ut64, GraphBlock> &bloc
     }
 
     auto block_order = topoSort(layoutState, entry);
+    if (interrupted()) {
+        return;
+    }
     computeAllBlockPlacement(block_order, layoutState);
+    if (interrupted()) {
+        return;
+    }
 
     for (auto &blockIt : blocks) {
         layoutState.edge[blockIt.first].resize(blockIt.second.edges.size());
@@ -120,44 +136,48 @@ void GraphGridLayout::CalculateLayout(std::unordered_map<ut64, GraphBlock> &bloc
         }
     }
     row_count += 2;
-    EdgesVector horiz_edges, vert_edges;
-    horiz_edges.resize(row_count + 1);
-    vert_edges.resize(row_count + 1);
-    Matrix<bool> edge_valid;
-    edge_valid.resize(row_count + 1);
-    for (int row = 0; row < row_count + 1; row++) {
-        horiz_edges[row].resize(col_count + 1);
-        vert_edges[row].resize(col_count + 1);
-        edge_valid[row].assign(col_count + 1, true);
-    }
+    // Horizontal lanes per row, vertical lanes per column
+    EdgesVector horiz_edges(row_count + 1);
+    EdgesVector vert_edges(col_count + 1);
 
+    // Sorted rows occupied by a block, per column. Vertical edges can't pass through them.
+    Matrix<int> block_rows(col_count + 1);
     for (auto &blockIt : layoutState.grid_blocks) {
         auto &block = blockIt.second;
-        edge_valid[block.row][block.col + 1] = false;
+        block_rows[block.col + 1].push_back(block.row);
+    }
+    for (auto &rows : block_rows) {
+        std::sort(rows.begin(), rows.end());
     }
 
     // Perform edge routing
+    size_t routedBlocks = 0;
     for (ut64 blockId : block_order) {
+        if ((++routedBlocks & 0xff) == 0 && interrupted()) {
+            return;
+        }
         GraphBlock &block = blocks[blockId];
         GridBlock &start = layoutState.grid_blocks[blockId];
         size_t i = 0;
         for (const auto &edge : block.edges) {
             GridBlock &end = layoutState.grid_blocks[edge.target];
-            layoutState.edge[blockId][i++] = routeEdge(horiz_edges, vert_edges, edge_valid, start, end);
+            layoutState.edge[blockId][i++] = routeEdge(horiz_edges, vert_edges, block_rows, start, end);
         }
     }
 
+    if (interrupted()) {
+        return;
+    }
+
     // Compute edge counts for each row and column
     std::vector<int> col_edge_count, row_edge_count;
-    col_edge_count.assign(col_count + 1, 0);
-    row_edge_count.assign(row_count + 1, 0);
+    col_edge_count.resize(col_count + 1);
+    row_edge_count.resize(row_count + 1);
     for (int row = 0; row < row_count + 1; row++) {
-        for (int col = 0; col < col_count + 1; col++) {
-            if (int(horiz_edges[row][col].size()) > row_edge_count[row])
-                row_edge_count[row] = int(horiz_edges[row][col].size());
-            if (int(vert_edges[row][col].size()) > col_edge_count[col])
-                col_edge_count[col] = int(vert_edges[row][col].size());
-        }
+        row_edge_count[row] = horiz_edges[row].laneCount();
+    }
+    for (int col = 0; col < col_count + 1; col++) {
+        col_edge_count[col] = vert_edges[col].laneCount();
     }
 
 
@@ -369,33 +389,75 @@ void GraphGridLayout::adjustGraphLayout(GridBlock &block,
 }
 
 // Edge computing stuff
-bool GraphGridLayout::isEdgeMarked(EdgesVector &edges, int row, int col, int index)
+bool GraphGridLayout::EdgeLanes::isFree(int lane, int from, int to) const
 {
-    if (index >= int(edges[row][col].size()))
-        return false;
-    return edges[row][col][index];
+    if (lane >= int(lanes.size())) {
+        return true;
+    }
+    const Intervals &intervals = lanes[lane];
+    // Intervals are disjoint, so the last one starting before the end of the range is the only
+    // one that can overlap it
+    auto it = intervals.upper_bound(to);
+    if (it == intervals.begin()) {
+        return true;
+    }
+    --it;
+    return it->second < from;
 }
 
-void GraphGridLayout::markEdge(EdgesVector &edges, int row, int col, int index, bool used)
+void GraphGridLayout::EdgeLanes::mark(int lane, int from, int to)
 {
-    while (int(edges[row][col].size()) <= index)
-        edges[row][col].push_back(false);
-    edges[row][col][index] = used;
+    assert(isFree(lane, from, to));
+    if (lane >= int(lanes.size())) {
+        lanes.resize(lane + 1);
+    }
+    lanes[lane][from] = to;
+}
+
+void GraphGridLayout::EdgeLanes::unmark(int lane, int position)
+{
+    if (lane >= int(lanes.size())) {
+        return;
+    }
+    Intervals &intervals = lanes[lane];
+    auto it = intervals.upper_bound(position);
+    if (it == intervals.begin()) {
+        return;
+    }
+    --it;
+    int from = it->first;
+    int to = it->second;
+    if (to < position) {
+        return;
+    }
+    intervals.erase(it);
+    if (from < position) {
+        intervals[from] = position - 1;
+    }
+    if (position < to) {
+        intervals[position + 1] = to;
+    }
+}
+
+int GraphGridLayout::EdgeLanes::allocate(int from, int to)
+{
+    int lane = 0;
+    while (!isFree(lane, from, to)) {
+        lane++;
+    }
+    mark(lane, from, to);
+    return lane;
 }
 
 GraphGridLayout::GridEdge GraphGridLayout::routeEdge(EdgesVector &horiz_edges,
                                                      EdgesVector &vert_edges,
-                                                     Matrix<bool> &edge_valid, GridBlock &start, GridBlock &end) const
+                                                     const Matrix<int> &block_rows, GridBlock &start, GridBlock &end) const
 {
     GridEdge edge;
     edge.dest = end.id;
 
     //Find edge index for initial outgoing line
-    int i = 0;
-    while (isEdgeMarked(vert_edges, start.row + 1, start.col + 1, i)) {
-        i += 1;
-    }
-    markEdge(vert_edges, start.row + 1, start.col + 1, i);
+    int i = vert_edges[start.col + 1].allocate(start.row + 1, start.row + 1);
     edge.addPoint(start.row + 1, start.col + 1);
     edge.start_index = i;
     bool horiz = false;
@@ -411,15 +473,12 @@ GraphGridLayout::GridEdge GraphGridLayout::routeEdge(EdgesVector &horiz_edges,
     }
     int col = start.col + 1;
     if (min_row != max_row) {
-        auto checkColumn = [min_row, max_row, &edge_valid](int column) {
-            if (column < 0 || column >= int(edge_valid[min_row].size()))
+        auto checkColumn = [min_row, max_row, &block_rows](int column) {
+            if (column < 0 || column >= int(block_rows.size()))
                 return false;
-            for (int row = min_row; row < max_row; row++) {
-                if (!edge_valid[row][column]) {
-                    return false;
-                }
-            }
-            return true;
+            const auto &rows = block_rows[column];
+            auto it = std::lower_bound(rows.begin(), rows.end(), min_row);
+            return it == rows.end() || *it >= max_row;
         };
 
         if (!checkColumn(col)) {
@@ -454,7 +513,7 @@ GraphGridLayout::GridEdge GraphGridLayout::routeEdge(EdgesVector &horiz_edges,
             min_col = start.col + 1;
             max_col = col;
         }
-        int index = findHorizEdgeIndex(horiz_edges, start.row + 1, min_col, max_col);
+        int index = horiz_edges[start.row + 1].allocate(min_col, max_col);
         edge.addPoint(start.row + 1, col, index);
         horiz = true;
     }
@@ -462,8 +521,8 @@ GraphGridLayout::GridEdge GraphGridLayout::routeEdge(EdgesVector &horiz_edges,
     if (end.row != (start.row + 1)) {
         //Not in same row, need to generate a line for moving to the correct row
         if (col == (start.col + 1))
-            markEdge(vert_edges, start.row + 1, start.col + 1, i, false);
-        int index = findVertEdgeIndex(vert_edges, col, min_row, max_row);
+            vert_edges[start.col + 1].unmark(i, start.row + 1);
+        int index = vert_edges[col].allocate(min_row, max_row);
         if (col == (start.col + 1))
             edge.start_index = index;
         edge.addPoint(end.row, col, index);
@@ -480,61 +539,17 @@ GraphGridLayout::GridEdge GraphGridLayout::routeEdge(EdgesVector &horiz_edges,
             min_col = end.col + 1;
             max_col = col;
         }
-        int index = findHorizEdgeIndex(horiz_edges, end.row, min_col, max_col);
+        int index = horiz_edges[end.row].allocate(min_col, max_col);
         edge.addPoint(end.row, end.col + 1, index);
         horiz = true;
     }
 
     //If last line was horizontal, choose the ending edge index for the incoming edge
     if (horiz) {
-        int index = findVertEdgeIndex(vert_edges, end.col + 1, end.row, end.row);
+        int index = vert_edges[end.col + 1].allocate(end.row, end.row);
         edge.points[int(edge.points.size()) - 1].index = index;
     }
 
     return edge;
 }
 
-
-int GraphGridLayout::findHorizEdgeIndex(EdgesVector &edges, int row, int min_col, int max_col)
-{
-    //Find a valid index
-    int i = 0;
-    while (true) {
-        bool valid = true;
-        for (int col = min_col; col < max_col + 1; col++)
-            if (isEdgeMarked(edges, row, col, i)) {
-                valid = false;
-                break;
-            }
-        if (valid)
-            break;
-        i++;
-    }
-
-    //Mark chosen index as used
-    for (int col = min_col; col < max_col + 1; col++)
-        markEdge(edges, row, col, i);
-    return i;
-}
-
-int GraphGridLayout::findVertEdgeIndex(EdgesVector &edges, int col, int min_row, int max_row)
-{
-    //Find a valid index
-    int i = 0;
-    while (true) {
-        bool valid = true;
-        for (int row = min_row; row < max_row + 1; row++)
-            if (isEdgeMarked(edges, row, col, i)) {
-                valid = false;
-                break;
-            }
-        if (valid)
-            break;
-        i++;
-    }
-
-    //Mark chosen index as used
-    for (int row = min_row; row < max_row + 1; row++)
-        markEdge(edges, row, col, i);
-    return i;
-}
@@ -4,6 +4,8 @@
 #include "core/Cutter.h"
 #include "GraphLayout.h"
 
+#include <map>
+
 class GraphGridLayout : public GraphLayout
 {
 public:
@@ -18,6 +20,9 @@ public:
                                  ut64 entry,
                                  int &width,
                                  int &height) const override;
+    virtual void CalculateLayoutInterruptible(std::unordered_map<ut64, GraphBlock> &blocks,
+                                              ut64 entry, int &width, int &height,
+                                              const std::function<bool()> &interrupted) const override;
 private:
     LayoutType layoutType;
 
@@ -78,14 +83,39 @@ private:
     // Edge computing stuff
     template<typename T>
     using Matrix = std::vector<std::vector<T>>;
-    using EdgesVector = Matrix<std::vector<bool>>;
+
+    /**
+     * @brief Edge lanes along one grid line, a row for horizontal edges or a column for vertical ones.
+     *
+     * Each lane keeps the positions used by edges as disjoint intervals, so routing cost depends
+     * on the number of edges and not on the size of the grid.
+     */
+    class EdgeLanes
+    {
+    public:
+        void mark(int lane, int from, int to);
+        void unmark(int lane, int position);
+        /**
+         * @brief Find the lowest lane which is free in [from, to] and mark it as used
+         * @return lane index
+         */
+        int allocate(int from, int to);
+        /**
+         * @brief Number of lanes that were used at some point on this line
+         */
+        int laneCount() const { return int(lanes.size()); }
+
+    private:
+        // First position -> last position, both inclusive
+        using Intervals = std::map<int, int>;
+        std::vector<Intervals> lanes;
+
+        bool isFree(int lane, int from, int to) const;
+    };
+    using EdgesVector = std::vector<EdgeLanes>;
 
     GridEdge routeEdge(EdgesVector &horiz_edges, EdgesVector &vert_edges,
-                       Matrix<bool> &edge_valid, GridBlock &start, GridBlock &end) const;
-    static int findVertEdgeIndex(EdgesVector &edges, int col, int min_row, int max_row);
-    static bool isEdgeMarked(EdgesVector &edges, int row, int col, int index);
-    static void markEdge(EdgesVector &edges, int row, int col, int index, bool used = true);
-    static int findHorizEdgeIndex(EdgesVector &edges, int row, int min_col, int max_col);
+                       const Matrix<int> &block_rows, GridBlock &start, GridBlock &end) const;
 };
 
 #endif // GRAPHGRIDLAYOUT_H
@@ -3,6 +3,7 @@
 
 #include "core/Cutter.h"
 
+#include <functional>
 #include <unordered_map>
 
 class GraphLayout
@@ -40,6 +41,18 @@ public:
     virtual ~GraphLayout() {}
     virtual void CalculateLayout(Graph &blocks, ut64 entry, int &width,
                                  int &height) const = 0;
+    /**
+     * @brief Same as CalculateLayout(), but return early once interrupted() is true. The
+     * blocks are left in an unspecified state then. Layouts that can't stop midway only
+     * check it before starting.
+     */
+    virtual void CalculateLayoutInterruptible(Graph &blocks, ut64 entry, int &width, int &height,
+                                              const std::function<bool()> &interrupted) const
+    {
+        if (!interrupted()) {
+            CalculateLayout(blocks, entry, width, height);
+        }
+    }
 protected:
     LayoutConfig layoutConfig;
 };
@@ -0,0 +1,139 @@
+#include "GraphSpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Preferred size of a grid cell in logical graph coordinates
+ */
+static const qreal CELL_SIZE = 256;
+
+/**
+ * Limit for the number of cells, cells get bigger for huge graphs
+ */
+static const qreal MAX_CELLS = 1 << 18;
+
+/**
+ * Extra space around edge polylines for arrow heads and pen width
+ */
+static const qreal EDGE_MARGIN = 8;
+
+void GraphSpatialIndex::clear()
+{
+    items.clear();
+    cells.clear();
+    cols = 0;
+    rows = 0;
+    builtBlockCount = 0;
+}
+
+void GraphSpatialIndex::build(const GraphLayout::Graph &blocks)
+{
+    clear();
+    builtBlockCount = blocks.size();
+
+    std::vector<Item> newItems;
+    QRectF bounds;
+    for (const auto &blockIt : blocks) {
+        const GraphLayout::GraphBlock &block = blockIt.second;
+        Item blockItem = { block.entry, -1, QRectF(block.x, block.y, block.width, block.height) };
+        newItems.push_back(blockItem);
+        bounds |= blockItem.rect;
+        for (size_t i = 0; i < block.edges.size(); i++) {
+            const QPolygonF &polyline = block.edges[i].polyline;
+            if (polyline.empty()) {
+                continue;
+            }
+            Item edgeItem = { block.entry, static_cast<int>(i),
+                              polyline.boundingRect().adjusted(-EDGE_MARGIN, -EDGE_MARGIN,
+                                                               EDGE_MARGIN, EDGE_MARGIN)
+                            };
+            newItems.push_back(edgeItem);
+            bounds |= edgeItem.rect;
+        }
+    }
+    if (newItems.empty()) {
+        return;
+    }
+
+    origin = bounds.topLeft();
+    cellSize = CELL_SIZE;
+    qreal cellCount = std::ceil(bounds.width() / cellSize) * std::ceil(bounds.height() / cellSize);
+    if (cellCount > MAX_CELLS) {
+        cellSize *= std::ceil(std::sqrt(cellCount / MAX_CELLS));
+    }
+    cols = std::max(1, static_cast<int>(std::ceil(bounds.width() / cellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil(bounds.height() / cellSize)));
+    cells.resize(static_cast<size_t>(cols) * static_cast<size_t>(rows));
+
+    items.reserve(newItems.size());
+    for (const Item &item : newItems) {
+        addItem(item);
+    }
+}
+
+int GraphSpatialIndex::cellColumn(qreal x) const
+{
+    return qBound(0, static_cast<int>((x - origin.x()) / cellSize), cols - 1);
+}
+
+int GraphSpatialIndex::cellRow(qreal y) const
+{
+    return qBound(0, static_cast<int>((y - origin.y()) / cellSize), rows - 1);
+}
+
+void GraphSpatialIndex::addItem(const Item &item)
+{
+    int index = static_cast<int>(items.size());
+    items.push_back(item);
+    int right = cellColumn(item.rect.right());
+    int bottom = cellRow(item.rect.bottom());
+    for (int row = cellRow(item.rect.top()); row <= bottom; row++) {
+        for (int col = cellColumn(item.rect.left()); col <= right; col++) {
+            cells[static_cast<size_t>(row) * cols + col].push_back(index);
+        }
+    }
+}
+
+std::vector<const GraphSpatialIndex::Item *> GraphSpatialIndex::itemsIn(const QRectF &rect) const
+{
+    std::vector<const Item *> result;
+    if (items.empty()) {
+        return result;
+    }
+    std::vector<int> indices;
+    int right = cellColumn(rect.right());
+    int bottom = cellRow(rect.bottom());
+    for (int row = cellRow(rect.top()); row <= bottom; row++) {
+        for (int col = cellColumn(rect.left()); col <= right; col++) {
+            const std::vector<int> &cell = cells[static_cast<size_t>(row) * cols + col];
+            indices.insert(indices.end(), cell.begin(), cell.end());
+        }
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    result.reserve(indices.size());
+    for (int index : indices) {
+        const Item &item = items[static_cast<size_t>(index)];
+        if (item.rect.intersects(rect)) {
+            result.push_back(&item);
+        }
+    }
+    return result;
+}
+
+ut64 GraphSpatialIndex::blockAt(const QPoint &point) const
+{
+    if (items.empty()) {
+        return RVA_INVALID;
+    }
+    const std::vector<int> &cell = cells[static_cast<size_t>(cellRow(point.y())) * cols
+                                         + cellColumn(point.x())];
+    for (int index : cell) {
+        const Item &item = items[static_cast<size_t>(index)];
+        if (item.edge < 0 && item.rect.toRect().contains(point)) {
+            return item.block;
+        }
+    }
+    return RVA_INVALID;
+}
@@ -0,0 +1,60 @@
+#ifndef GRAPHSPATIALINDEX_H
+#define GRAPHSPATIALINDEX_H
+
+#include "widgets/GraphLayout.h"
+
+#include <QRectF>
+#include <vector>
+
+/**
+ * @brief Uniform grid over the bounding rectangles of graph blocks and edges.
+ *
+ * Built once per layout, it allows painting and hit-testing only the items around
+ * the area of interest instead of walking the whole graph.
+ */
+class GraphSpatialIndex
+{
+public:
+    struct Item {
+        ut64 block;
+        /**
+         * Index in GraphBlock::edges, -1 for the block itself
+         */
+        int edge;
+        QRectF rect;
+    };
+
+    void build(const GraphLayout::Graph &blocks);
+    void clear();
+
+    /**
+     * @return number of blocks the index was built from
+     */
+    size_t blockCount() const { return builtBlockCount; }
+
+    /**
+     * @brief Get all items whose bounding rectangle intersects rect, in the order they were
+     * added, which is each block followed by its edges.
+     */
+    std::vector<const Item *> itemsIn(const QRectF &rect) const;
+
+    /**
+     * @return entry of the block containing point or RVA_INVALID
+     */
+    ut64 blockAt(const QPoint &point) const;
+
+private:
+    std::vector<Item> items;
+    std::vector<std::vector<int>> cells;
+    QPointF origin;
+    qreal cellSize = 0;
+    int cols = 0;
+    int rows = 0;
+    size_t builtBlockCount = 0;
+
+    int cellColumn(qreal x) const;
+    int cellRow(qreal y) const;
+    void addItem(const Item &item);
+};
+
+#endif // GRAPHSPATIALINDEX_H
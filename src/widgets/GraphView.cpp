@@ -5,6 +5,7 @@
 #include "GraphvizLayout.h"
 #endif
 #include "Helpers.h"
+#include "common/GraphLayoutTask.h"
 
 #include <vector>
 #include <QPainter>
@@ -36,11 +37,13 @@ GraphView::GraphView(QWidget *parent)
         glWidget = nullptr;
     }
 #endif
+    tiles.setMaxCost(MAX_TILES_COST);
     setGraphLayout(Layout::GridMedium);
 }
 
 GraphView::~GraphView()
 {
+    cancelLayoutTask();
 }
 
 // Callbacks
@@ -107,6 +110,10 @@ void GraphView::blockContextMenuRequested(GraphView::GraphBlock &, QContextMenuE
 {
 }
 
+void GraphView::graphLayoutComputed()
+{
+}
+
 bool GraphView::event(QEvent *event)
 {
     if (event->type() == QEvent::ToolTip) {
@@ -129,15 +136,183 @@ void GraphView::contextMenuEvent(QContextMenuEvent *event)
     }
 }
 
+/**
+ * Graphs with more blocks are laid out in the background
+ */
+static const size_t MAX_BLOCKS_SYNC_LAYOUT = 300;
+
+/**
+ * @brief Cheap layout shown while the real one is computed: rows of blocks by distance
+ * from entry, connected with straight edges.
+ */
+static void computeProvisionalLayout(GraphLayout::Graph &blocks, ut64 entry, int &width,
+                                     int &height)
+{
+    const int margin = 20;
+    std::unordered_map<ut64, size_t> depth;
+    std::vector<std::vector<ut64>> rows;
+    std::queue<ut64> queue;
+    auto visit = [&](ut64 id, size_t level) {
+        if (!depth.emplace(id, level).second) {
+            return;
+        }
+        if (rows.size() <= level) {
+            rows.resize(level + 1);
+        }
+        rows[level].push_back(id);
+        queue.push(id);
+    };
+    auto walk = [&]() {
+        while (!queue.empty()) {
+            ut64 id = queue.front();
+            queue.pop();
+            for (const auto &edge : blocks[id].edges) {
+                if (blocks.find(edge.target) != blocks.end()) {
+                    visit(edge.target, depth[id] + 1);
+                }
+            }
+        }
+    };
+    if (blocks.find(entry) != blocks.end()) {
+        visit(entry, 0);
+        walk();
+    }
+    for (const auto &blockIt : blocks) {
+        if (depth.find(blockIt.first) == depth.end()) {
+            visit(blockIt.first, rows.size());
+            walk();
+        }
+    }
+
+    width = 0;
+    int y = margin;
+    for (const auto &row : rows) {
+        int x = margin;
+        int rowHeight = 0;
+        for (ut64 id : row) {
+            auto &block = blocks[id];
+            block.x = x;
+            block.y = y;
+            x += block.width + margin;
+            rowHeight = std::max(rowHeight, block.height);
+        }
+        width = std::max(width, x);
+        y += rowHeight + 4 * margin;
+    }
+    height = y;
+
+    for (auto &blockIt : blocks) {
+        auto &block = blockIt.second;
+        for (auto &edge : block.edges) {
+            const auto &target = blocks[edge.target];
+            edge.polyline.clear();
+            if (target.y > block.y) {
+                edge.polyline << QPointF(block.x + block.width / 2, block.y + block.height)
+                              << QPointF(target.x + target.width / 2, target.y);
+                edge.arrow = GraphLayout::GraphEdge::Down;
+            } else {
+                edge.polyline << QPointF(block.x + block.width / 2, block.y)
+                              << QPointF(target.x + target.width / 2, target.y + target.height);
+                edge.arrow = GraphLayout::GraphEdge::Up;
+            }
+        }
+    }
+}
+
 // This calculates the full graph starting at block entry.
 void GraphView::computeGraph(ut64 entry)
 {
-    graphLayoutSystem->CalculateLayout(blocks, entry, width, height);
+    cancelLayoutTask();
+    if (blocks.size() <= MAX_BLOCKS_SYNC_LAYOUT) {
+        graphLayoutSystem->CalculateLayout(blocks, entry, width, height);
+    } else {
+        computeProvisionalLayout(blocks, entry, width, height);
+
+        layoutTask.reset(new GraphLayoutTask(graphLayoutSystem, blocks, entry));
+        GraphLayoutTask *task = layoutTask.data();
+        connect(task, &AsyncTask::finished, this, [this, task]() {
+            applyLayoutTask(task);
+        });
+        layoutTaskStarted = false;
+        startLayoutTask();
+    }
+    spatialIndexDirty = true;
+    setCacheDirty();
+    ready = true;
+
+    viewport()->update();
+}
+
+void GraphView::setComputedGraph(const GraphLayout::Graph &blocks, int width, int height)
+{
+    cancelLayoutTask();
+    this->blocks = blocks;
+    this->width = width;
+    this->height = height;
+    spatialIndexDirty = true;
+    setCacheDirty();
     ready = true;
 
     viewport()->update();
 }
 
+void GraphView::startLayoutTask()
+{
+    if (!layoutTask || layoutTaskStarted || !abandonedLayoutTasks.isEmpty()) {
+        return;
+    }
+    layoutTaskStarted = true;
+    Core()->getAsyncTaskManager()->start(layoutTask);
+}
+
+void GraphView::cancelLayoutTask()
+{
+    if (!layoutTask) {
+        return;
+    }
+    if (layoutTaskStarted) {
+        // Its result is ignored, it is only kept until it stopped
+        layoutTask->interrupt();
+        abandonedLayoutTasks.append(layoutTask);
+    }
+    layoutTask.clear();
+}
+
+void GraphView::applyLayoutTask(GraphLayoutTask *task)
+{
+    if (task != layoutTask.data()) {
+        for (int i = 0; i < abandonedLayoutTasks.size(); i++) {
+            if (abandonedLayoutTasks[i].data() == task) {
+                abandonedLayoutTasks.removeAt(i);
+                break;
+            }
+        }
+        startLayoutTask();
+        return;
+    }
+    QSharedPointer<GraphLayoutTask> finishedTask = layoutTask;
+    layoutTask.clear();
+
+    // Blocks may have been replaced without a new layout
+    GraphLayout::Graph &result = finishedTask->getBlocks();
+    if (result.size() != blocks.size()) {
+        return;
+    }
+    for (const auto &blockIt : result) {
+        if (blocks.find(blockIt.first) == blocks.end()) {
+            return;
+        }
+    }
+    blocks.swap(result);
+    width = finishedTask->getWidth();
+    height = finishedTask->getHeight();
+    spatialIndexDirty = true;
+    setCacheDirty();
+    clampViewOffset();
+    viewport()->update();
+    graphLayoutComputed();
+}
+
 void GraphView::beginMouseDrag(QMouseEvent *event)
 {
     scroll_base_x = event->x();
@@ -158,48 +333,71 @@ void GraphView::setViewScale(qreal scale)
     emit viewScaleChanged(scale);
 }
 
-QSize GraphView::getCacheSize()
-{
-    return
 #ifndef CUTTER_NO_OPENGL_GRAPH
-        useGL ? cacheSize :
-#endif
-        pixmap.size();
-}
-
-qreal GraphView::getCacheDevicePixelRatioF()
+QSize GraphView::getRequiredCacheSize()
 {
-    return
-#ifndef CUTTER_NO_OPENGL_GRAPH
-        useGL ? 1.0 :
-#endif
-        qhelpers::devicePixelRatio(&pixmap);
+    return viewport()->size() * qhelpers::devicePixelRatio(this);
 }
+#endif
 
-QSize GraphView::getRequiredCacheSize()
+void GraphView::setCacheDirty()
 {
-    return viewport()->size() * qhelpers::devicePixelRatio(this);
+    cacheDirty = true;
+    tiles.clear();
 }
 
-qreal GraphView::getRequiredCacheDevicePixelRatioF()
+void GraphView::setBlockDirty(ut64 entry)
 {
-    return
-#ifndef CUTTER_NO_OPENGL_GRAPH
-        useGL ? 1.0f :
-#endif
-        qhelpers::devicePixelRatio(this);
+    auto blockIt = blocks.find(entry);
+    if (blockIt == blocks.end() || tiles.isEmpty()) {
+        return;
+    }
+    cacheDirty = true;
+
+    // The block, its outgoing and its incoming edges
+    QVector<QRectF> dirtyRects;
+    const GraphBlock &block = blockIt->second;
+    dirtyRects << QRectF(block.x, block.y, block.width, block.height);
+    for (const auto &it : blocks) {
+        for (const GraphEdge &edge : it.second.edges) {
+            if ((it.first == entry || edge.target == entry) && !edge.polyline.empty()) {
+                dirtyRects << edge.polyline.boundingRect();
+            }
+        }
+    }
+
+    for (const TileKey &key : tiles.keys()) {
+        qreal tileLogicalSize = TILE_SIZE / key.scale;
+        QRectF tileRect(key.x * tileLogicalSize, key.y * tileLogicalSize,
+                        tileLogicalSize, tileLogicalSize);
+        for (const QRectF &rect : dirtyRects) {
+            // Pens and arrows reach a bit outside the rectangles
+            if (tileRect.intersects(rect.adjusted(-8, -8, 8, 8))) {
+                tiles.remove(key);
+                break;
+            }
+        }
+    }
 }
 
 void GraphView::paintEvent(QPaintEvent *)
 {
-#ifndef CUTTER_NO_OPENGL_GRAPH
-    if (useGL) {
-        glWidget->makeCurrent();
+    if (!useGL) {
+        QPainter p(viewport());
+        paintTiles(p);
+        cacheDirty = false;
+        if (layoutTask) {
+            p.setPen(palette().color(QPalette::WindowText));
+            p.drawText(viewport()->rect().adjusted(8, 8, -8, -8), Qt::AlignTop | Qt::AlignRight,
+                       tr("Computing graph layout..."));
+        }
+        return;
     }
-#endif
 
-    if (!qFuzzyCompare(getCacheDevicePixelRatioF(), getRequiredCacheDevicePixelRatioF())
-            || getCacheSize() != getRequiredCacheSize()) {
+#ifndef CUTTER_NO_OPENGL_GRAPH
+    glWidget->makeCurrent();
+
+    if (cacheSize != getRequiredCacheSize()) {
         setCacheDirty();
     }
 
@@ -208,21 +406,66 @@ void GraphView::paintEvent(QPaintEvent *)
         cacheDirty = false;
     }
 
-    if (useGL) {
-#ifndef CUTTER_NO_OPENGL_GRAPH
-        auto gl = glWidget->context()->extraFunctions();
-        gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, cacheFBO);
-        gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, glWidget->defaultFramebufferObject());
-        auto dpr = qhelpers::devicePixelRatio(this);
-        gl->glBlitFramebuffer(0, 0, cacheSize.width(), cacheSize.height(),
-                              0, 0, viewport()->width() * dpr, viewport()->height() * dpr,
-                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
-        glWidget->doneCurrent();
+    auto gl = glWidget->context()->extraFunctions();
+    gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, cacheFBO);
+    gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, glWidget->defaultFramebufferObject());
+    auto dpr = qhelpers::devicePixelRatio(this);
+    gl->glBlitFramebuffer(0, 0, cacheSize.width(), cacheSize.height(),
+                          0, 0, viewport()->width() * dpr, viewport()->height() * dpr,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glWidget->doneCurrent();
 #endif
-    } else {
-        QPainter p(viewport());
-        p.drawPixmap(QPoint(0, 0), pixmap);
+}
+
+static int floorDiv(int a, int b)
+{
+    return a / b - (a % b < 0 ? 1 : 0);
+}
+
+void GraphView::paintTiles(QPainter &p)
+{
+    qreal dpr = qhelpers::devicePixelRatio(this);
+    if (!qFuzzyCompare(dpr, tileDevicePixelRatio)) {
+        tiles.clear();
+        tileDevicePixelRatio = dpr;
     }
+
+    // Tiles split the graph scaled to screen pixels, starting at logical position 0,0
+    QPoint origin(qRound(offset.x() * current_scale), qRound(offset.y() * current_scale));
+    int firstCol = floorDiv(origin.x(), TILE_SIZE);
+    int firstRow = floorDiv(origin.y(), TILE_SIZE);
+    int lastCol = floorDiv(origin.x() + viewport()->width() - 1, TILE_SIZE);
+    int lastRow = floorDiv(origin.y() + viewport()->height() - 1, TILE_SIZE);
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int col = firstCol; col <= lastCol; col++) {
+            TileKey key = { current_scale, col, row };
+            QPixmap tile;
+            if (QPixmap *cached = tiles.object(key)) {
+                tile = *cached;
+            } else {
+                tile = renderTile(key);
+                int cost = tile.width() * tile.height() * tile.depth() / (8 * 1024);
+                tiles.insert(key, new QPixmap(tile), cost);
+            }
+            p.drawPixmap(col * TILE_SIZE - origin.x(), row * TILE_SIZE - origin.y(), tile);
+        }
+    }
+}
+
+QPixmap GraphView::renderTile(const TileKey &key)
+{
+    QPixmap tile(QSize(TILE_SIZE, TILE_SIZE) * tileDevicePixelRatio);
+    tile.setDevicePixelRatio(tileDevicePixelRatio);
+    tile.fill(backgroundColor);
+
+    qreal tileLogicalSize = TILE_SIZE / key.scale;
+    QRectF window(key.x * tileLogicalSize, key.y * tileLogicalSize, tileLogicalSize, tileLogicalSize);
+    QPainter p(&tile);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.scale(key.scale, key.scale);
+    p.translate(-window.topLeft());
+    paintItems(p, window, key.scale, true);
+    return tile;
 }
 
 void GraphView::clampViewOffset()
@@ -249,61 +492,49 @@ void GraphView::addViewOffset(QPoint move, bool emitSignal)
     setViewOffsetInternal(offset + move, emitSignal);
 }
 
+#ifndef CUTTER_NO_OPENGL_GRAPH
 void GraphView::paintGraphCache()
 {
-#ifndef CUTTER_NO_OPENGL_GRAPH
     std::unique_ptr<QOpenGLPaintDevice> paintDevice;
-#endif
     QPainter p;
-    if (useGL) {
-#ifndef CUTTER_NO_OPENGL_GRAPH
-        auto gl = QOpenGLContext::currentContext()->functions();
-
-        bool resizeTex = false;
-        QSize sizeNeed = getRequiredCacheSize();
-        if (!cacheTexture) {
-            gl->glGenTextures(1, &cacheTexture);
-            gl->glBindTexture(GL_TEXTURE_2D, cacheTexture);
-            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            resizeTex = true;
-        } else if (cacheSize != sizeNeed) {
-            gl->glBindTexture(GL_TEXTURE_2D, cacheTexture);
-            resizeTex = true;
-        }
-        if (resizeTex) {
-            cacheSize = sizeNeed;
-            gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, cacheSize.width(), cacheSize.height(), 0, GL_RGBA,
-                             GL_UNSIGNED_BYTE, nullptr);
-            gl->glGenFramebuffers(1, &cacheFBO);
-            gl->glBindFramebuffer(GL_FRAMEBUFFER, cacheFBO);
-            gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cacheTexture, 0);
-        } else {
-            gl->glBindFramebuffer(GL_FRAMEBUFFER, cacheFBO);
-        }
-        gl->glViewport(0, 0, viewport()->width(), viewport()->height());
-        gl->glClearColor(backgroundColor.redF(), backgroundColor.greenF(), backgroundColor.blueF(), 1.0f);
-        gl->glClear(GL_COLOR_BUFFER_BIT);
-
-        paintDevice.reset(new QOpenGLPaintDevice(cacheSize));
-        p.begin(paintDevice.get());
-#endif
+    auto gl = QOpenGLContext::currentContext()->functions();
+
+    bool resizeTex = false;
+    QSize sizeNeed = getRequiredCacheSize();
+    if (!cacheTexture) {
+        gl->glGenTextures(1, &cacheTexture);
+        gl->glBindTexture(GL_TEXTURE_2D, cacheTexture);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        resizeTex = true;
+    } else if (cacheSize != sizeNeed) {
+        gl->glBindTexture(GL_TEXTURE_2D, cacheTexture);
+        resizeTex = true;
+    }
+    if (resizeTex) {
+        cacheSize = sizeNeed;
+        gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, cacheSize.width(), cacheSize.height(), 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, nullptr);
+        gl->glGenFramebuffers(1, &cacheFBO);
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, cacheFBO);
+        gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cacheTexture, 0);
     } else {
-        auto dpr = qhelpers::devicePixelRatio(this);
-        pixmap = QPixmap(getRequiredCacheSize() * dpr);
-        pixmap.setDevicePixelRatio(dpr);
-        pixmap.fill(backgroundColor);
-        p.begin(&pixmap);
-        p.setRenderHint(QPainter::Antialiasing);
-        p.setViewport(this->viewport()->rect());
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, cacheFBO);
     }
+    gl->glViewport(0, 0, viewport()->width(), viewport()->height());
+    gl->glClearColor(backgroundColor.redF(), backgroundColor.greenF(), backgroundColor.blueF(), 1.0f);
+    gl->glClear(GL_COLOR_BUFFER_BIT);
+
+    paintDevice.reset(new QOpenGLPaintDevice(cacheSize));
+    p.begin(paintDevice.get());
     paint(p, offset, this->viewport()->rect(), current_scale);
 
     p.end();
 }
+#endif
 
 void GraphView::paint(QPainter &p, QPoint offset, QRect viewport, qreal scale, bool interactive)
 {
@@ -318,80 +549,88 @@ void GraphView::paint(QPainter &p, QPoint offset, QRect viewport, qreal scale, b
     p.setWindow(window);
     QRectF windowF(window.x(), window.y(), window.width(), window.height());
 
-    for (auto &blockIt : blocks) {
-        GraphBlock &block = blockIt.second;
+    paintItems(p, windowF, scale, interactive);
+}
 
-        QRectF blockRect(block.x, block.y, block.width, block.height);
+void GraphView::paintItems(QPainter &p, const QRectF &windowF, qreal scale, bool interactive)
+{
+    // Only touch the blocks and edges that are visible
+    for (const GraphSpatialIndex::Item *item : getSpatialIndex().itemsIn(windowF)) {
+        auto blockIt = blocks.find(item->block);
+        if (blockIt == blocks.end()) {
+            continue;
+        }
+        GraphBlock &block = blockIt->second;
 
-        // Check if block is visible by checking if block intersects with view area
-        if (blockRect.intersects(windowF)) {
+        if (item->edge < 0) {
             drawBlock(p, block, interactive);
+            continue;
         }
 
         p.setBrush(Qt::gray);
 
-        // Always draw edges
-        // TODO: Only draw edges if they are actually visible ...
         // Draw edges
-        for (GraphEdge &edge : block.edges) {
-            if (edge.polyline.empty()) {
-                continue;
-            }
-            QPolygonF polyline = edge.polyline;
-            EdgeConfiguration ec = edgeConfiguration(block, &blocks[edge.target]);
-            QPen pen(ec.color);
-            pen.setStyle(ec.lineStyle);
-            pen.setWidthF(pen.width() * ec.width_scale);
-            if (scale_thickness_multiplier && ec.width_scale > 1.01 && pen.widthF() * scale < 2) {
-                pen.setWidthF(ec.width_scale / scale);
-            }
-            if (pen.widthF() * scale < 2) {
-                pen.setWidth(0);
-            }
-            p.setPen(pen);
-            p.setBrush(ec.color);
-            p.drawPolyline(polyline);
-            pen.setStyle(Qt::SolidLine);
+        if (item->edge >= static_cast<int>(block.edges.size())) {
+            continue;
+        }
+        GraphEdge &edge = block.edges[item->edge];
+        if (edge.polyline.empty()) {
+            continue;
+        }
+        QPolygonF polyline = edge.polyline;
+        EdgeConfiguration ec = edgeConfiguration(block, &blocks[edge.target]);
+        QPen pen(ec.color);
+        pen.setStyle(ec.lineStyle);
+        pen.setWidthF(pen.width() * ec.width_scale);
+        if (scale_thickness_multiplier && ec.width_scale > 1.01 && pen.widthF() * scale < 2) {
+            pen.setWidthF(ec.width_scale / scale);
+        }
+        if (pen.widthF() * scale < 2) {
+            pen.setWidth(0);
+        }
+        p.setPen(pen);
+        p.setBrush(ec.color);
+        p.drawPolyline(polyline);
+        pen.setStyle(Qt::SolidLine);
+        p.setPen(pen);
+
+        auto drawArrow = [&](QPointF tip, QPointF dir) {
+            pen.setWidth(0);
             p.setPen(pen);
-
-            auto drawArrow = [&](QPointF tip, QPointF dir) {
-                pen.setWidth(0);
-                p.setPen(pen);
-                QPolygonF arrow;
-                arrow << tip;
-                QPointF dy(-dir.y(), dir.x());
-                QPointF base = tip - dir * 6;
-                arrow << base + 3 * dy;
-                arrow << base - 3 * dy;
-                p.drawConvexPolygon(arrow);
-            };
-
-            if (!polyline.empty()) {
-                if (ec.start_arrow) {
-                    auto firstPt = edge.polyline.first();
-                    drawArrow(firstPt, QPointF(0, 1));
-                }
-                if (ec.end_arrow) {
-                    auto lastPt = edge.polyline.last();
-                    QPointF dir(0, -1);
-                    switch (edge.arrow) {
-                    case GraphLayout::GraphEdge::Down:
-                        dir = QPointF(0, 1);
-                        break;
-                    case GraphLayout::GraphEdge::Up:
-                        dir = QPointF(0, -1);
-                        break;
-                    case GraphLayout::GraphEdge::Left:
-                        dir = QPointF(-1, 0);
-                        break;
-                    case GraphLayout::GraphEdge::Right:
-                        dir = QPointF(1, 0);
-                        break;
-                    default:
-                        break;
-                    }
-                    drawArrow(lastPt, dir);
+            QPolygonF arrow;
+            arrow << tip;
+            QPointF dy(-dir.y(), dir.x());
+            QPointF base = tip - dir * 6;
+            arrow << base + 3 * dy;
+            arrow << base - 3 * dy;
+            p.drawConvexPolygon(arrow);
+        };
+
+        if (!polyline.empty()) {
+            if (ec.start_arrow) {
+                auto firstPt = edge.polyline.first();
+                drawArrow(firstPt, QPointF(0, 1));
+            }
+            if (ec.end_arrow) {
+                auto lastPt = edge.polyline.last();
+                QPointF dir(0, -1);
+                switch (edge.arrow) {
+                case GraphLayout::GraphEdge::Down:
+                    dir = QPointF(0, 1);
+                    break;
+                case GraphLayout::GraphEdge::Up:
+                    dir = QPointF(0, -1);
+                    break;
+                case GraphLayout::GraphEdge::Left:
+                    dir = QPointF(-1, 0);
+                    break;
+                case GraphLayout::GraphEdge::Right:
+                    dir = QPointF(1, 0);
+                    break;
+                default:
+                    break;
                 }
+                drawArrow(lastPt, dir);
             }
         }
     }
@@ -492,16 +731,18 @@ void GraphView::showRectangle(const QRect &block, bool anywhere)
 
 GraphView::GraphBlock *GraphView::getBlockContaining(QPoint p)
 {
-    // Check if a block was clicked
-    for (auto &blockIt : blocks) {
-        GraphBlock &block = blockIt.second;
+    auto blockIt = blocks.find(getSpatialIndex().blockAt(p));
+    return blockIt != blocks.end() ? &blockIt->second : nullptr;
+}
 
-        QRect rec(block.x, block.y, block.width, block.height);
-        if (rec.contains(p)) {
-            return &block;
-        }
+const GraphSpatialIndex &GraphView::getSpatialIndex()
+{
+    // blocks is also modified directly by subclasses, a different size catches most of that
+    if (spatialIndexDirty || spatialIndex.blockCount() != blocks.size()) {
+        spatialIndex.build(blocks);
+        spatialIndexDirty = false;
     }
-    return nullptr;
+    return spatialIndex;
 }
 
 QPoint GraphView::viewToLogicalCoordinates(QPoint p)
@@ -544,6 +785,7 @@ void GraphView::setGraphLayout(GraphView::Layout layout)
 void GraphView::addBlock(GraphView::GraphBlock block)
 {
     blocks[block.entry] = block;
+    spatialIndexDirty = true;
 }
 
 void GraphView::setEntry(ut64 e)
@@ -583,26 +825,31 @@ void GraphView::mousePressEvent(QMouseEvent *event)
 
     // Check if a line beginning/end  was clicked
     if (event->button() == Qt::LeftButton) {
-        for (auto &blockIt : blocks) {
-            GraphBlock &block = blockIt.second;
-            for (GraphEdge &edge : block.edges) {
-                if (edge.polyline.length() < 2) {
-                    continue;
-                }
-                QPointF start = edge.polyline.first();
-                QPointF end = edge.polyline.last();
-                if (checkPointClicked(start, pos.x(), pos.y())) {
-                    showBlock(blocks[edge.target]);
-                    // TODO: Callback to child
-                    return;
-                    break;
-                }
-                if (checkPointClicked(end, pos.x(), pos.y(), true)) {
-                    showBlock(block);
-                    // TODO: Callback to child
-                    return;
-                    break;
-                }
+        QRectF clickArea(pos.x() - 16, pos.y() - 16, 32, 32);
+        for (const GraphSpatialIndex::Item *item : getSpatialIndex().itemsIn(clickArea)) {
+            auto blockIt = blocks.find(item->block);
+            if (item->edge < 0 || blockIt == blocks.end()
+                    || item->edge >= static_cast<int>(blockIt->second.edges.size())) {
+                continue;
+            }
+            GraphBlock &block = blockIt->second;
+            GraphEdge &edge = block.edges[item->edge];
+            if (edge.polyline.length() < 2) {
+                continue;
+            }
+            QPointF start = edge.polyline.first();
+            QPointF end = edge.polyline.last();
+            if (checkPointClicked(start, pos.x(), pos.y())) {
+                showBlock(blocks[edge.target]);
+                // TODO: Callback to child
+                return;
+                break;
+            }
+            if (checkPointClicked(end, pos.x(), pos.y(), true)) {
+                showBlock(block);
+                // TODO: Callback to child
+                return;
+                break;
             }
         }
     }
@@ -8,6 +8,8 @@
 #include <QScrollBar>
 #include <QElapsedTimer>
 #include <QHelpEvent>
+#include <QCache>
+#include <QSharedPointer>
 
 #include <unordered_map>
 #include <unordered_set>
@@ -16,6 +18,7 @@
 
 #include "core/Cutter.h"
 #include "widgets/GraphLayout.h"
+#include "widgets/GraphSpatialIndex.h"
 
 #if defined(QT_NO_OPENGL) || QT_VERSION < QT_VERSION_CHECK(5, 6, 0)
 // QOpenGLExtraFunctions were introduced in 5.6
@@ -26,6 +29,8 @@
 class QOpenGLWidget;
 #endif
 
+class GraphLayoutTask;
+
 class GraphView : public QAbstractScrollArea
 {
     Q_OBJECT
@@ -91,11 +96,31 @@ protected:
     // Padding inside the block
     int block_padding = 16;
 
-    void setCacheDirty()    { cacheDirty = true; }
+    /**
+     * @brief Drop all rendered graph content, it will be painted again on the next repaint
+     */
+    void setCacheDirty();
+    /**
+     * @brief Repaint only the parts of the graph showing the block or its edges
+     */
+    void setBlockDirty(ut64 entry);
+    /**
+     * @brief Call after modifying blocks directly, without addBlock() or computeGraph()
+     */
+    void setSpatialIndexDirty()    { spatialIndexDirty = true; }
 
     void addBlock(GraphView::GraphBlock block);
     void setEntry(ut64 e);
+    ut64 getEntry() const { return entry; }
     void computeGraph(ut64 entry);
+    /**
+     * @brief Replace the graph with blocks that were laid out before
+     */
+    void setComputedGraph(const GraphLayout::Graph &blocks, int width, int height);
+    /**
+     * @brief Whether the blocks are still in the provisional layout of computeGraph()
+     */
+    bool isLayoutPending() const    { return !layoutTask.isNull(); }
 
     // Callbacks that should be overridden
     /**
@@ -115,6 +140,10 @@ protected:
                                                 bool interactive = true);
     virtual void blockContextMenuRequested(GraphView::GraphBlock &block, QContextMenuEvent *event,
                                            QPoint pos);
+    /**
+     * @brief Called when a layout computed in the background replaced the provisional one
+     */
+    virtual void graphLayoutComputed();
 
     bool event(QEvent *event) override;
     void contextMenuEvent(QContextMenuEvent *event) override;
@@ -141,10 +170,20 @@ private:
     void centerX(bool emitSignal);
     void centerY(bool emitSignal);
 
-    void paintGraphCache();
+    /**
+     * @brief Draw blocks and edges intersecting windowF, painter must be set up for logical coordinates
+     */
+    void paintItems(QPainter &p, const QRectF &windowF, qreal scale, bool interactive);
 
     bool checkPointClicked(QPointF &point, int x, int y, bool above_y = false);
 
+    /**
+     * @brief Blocks and edges by position, rebuilt lazily after the graph changed
+     */
+    GraphSpatialIndex spatialIndex;
+    bool spatialIndexDirty = true;
+    const GraphSpatialIndex &getSpatialIndex();
+
     // Zoom data
     qreal current_scale = 1.0;
 
@@ -152,7 +191,22 @@ private:
 
     ut64 entry;
 
-    std::unique_ptr<GraphLayout> graphLayoutSystem;
+    std::shared_ptr<GraphLayout> graphLayoutSystem;
+
+    /**
+     * @brief Layout of a big graph running in the background, a provisional layout is shown
+     * until it is done
+     */
+    QSharedPointer<GraphLayoutTask> layoutTask;
+    bool layoutTaskStarted = false;
+    /**
+     * @brief Interrupted layout tasks that are still running. layoutTask is only started
+     * after all of them finished, so layouts that can't stop midway don't pile up.
+     */
+    QList<QSharedPointer<GraphLayoutTask>> abandonedLayoutTasks;
+    void startLayoutTask();
+    void cancelLayoutTask();
+    void applyLayoutTask(GraphLayoutTask *task);
 
     bool ready = false;
 
@@ -164,15 +218,49 @@ private:
     bool useGL;
 
     /**
-     * @brief pixmap that caches the graph nodes
+     * @brief Part of the graph rendered at some scale, in screen pixels starting at
+     * logical position 0,0
+     */
+    struct TileKey {
+        qreal scale;
+        int x;
+        int y;
+
+        bool operator==(const TileKey &other) const
+        {
+            return scale == other.scale && x == other.x && y == other.y;
+        }
+
+        friend uint qHash(const TileKey &key, uint seed = 0)
+        {
+            return ::qHash(key.scale, seed) ^ ::qHash((qint64(key.x) << 32) | quint32(key.y), seed);
+        }
+    };
+
+    /**
+     * @brief Width and height of a tile in device independent pixels
+     */
+    static const int TILE_SIZE = 256;
+    /**
+     * @brief Memory for rendered tiles in KiB
      */
-    QPixmap pixmap;
+    static const int MAX_TILES_COST = 64 * 1024;
+
+    /**
+     * @brief rendered tiles for the scales used recently, used when not drawing with OpenGL
+     */
+    QCache<TileKey, QPixmap> tiles;
+    qreal tileDevicePixelRatio = 1.0;
+    void paintTiles(QPainter &p);
+    QPixmap renderTile(const TileKey &key);
 
 #ifndef CUTTER_NO_OPENGL_GRAPH
     uint32_t cacheTexture;
     uint32_t cacheFBO;
     QSize cacheSize;
     QOpenGLWidget *glWidget;
+    void paintGraphCache();
+    QSize getRequiredCacheSize();
 #endif
     Layout graphLayout;
 
@@ -180,10 +268,6 @@ private:
      * @brief flag to control if the cache is invalid and should be re-created in the next draw
      */
     bool cacheDirty = true;
-    QSize getCacheSize();
-    qreal getCacheDevicePixelRatioF();
-    QSize getRequiredCacheSize();
-    qreal getRequiredCacheDevicePixelRatioF();
 
     void beginMouseDrag(QMouseEvent *event);
 public:
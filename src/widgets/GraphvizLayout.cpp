@@ -9,8 +9,16 @@
 #include <iomanip>
 #include <set>
 
+#include <QMutex>
+#include <QMutexLocker>
+
 #include <gvc.h>
 
+/**
+ * Graphviz keeps global state, layouts may run on several threads at once
+ */
+static QMutex graphvizMutex;
+
 GraphvizLayout::GraphvizLayout(LineType lineType, Direction direction)
     : GraphLayout({})
     , direction(direction)
@@ -90,6 +98,8 @@ void GraphvizLayout::CalculateLayout(std::unordered_map<ut64, GraphBlock> &block
     //https://gitlab.com/graphviz/graphviz/issues/1441
 #define STR(v) const_cast<char*>(v)
 
+    QMutexLocker locker(&graphvizMutex);
+
     width = height = 10;
     GVC_t *gvc = gvContext();
     Agraph_t *g = agopen(STR("G"), Agdirected, nullptr);
@@ -2,6 +2,7 @@
 #define HEXWIDGET_H
 
 #include "Cutter.h"
+#include "common/IOPageCache.h"
 #include "dialogs/HexdumpRangeDialog.h"
 #include <QScrollArea>
 #include <QTimer>
@@ -121,21 +122,30 @@ public:
 
     void fetch(uint64_t address, int length) override
     {
-        // FIXME: reuse data if possible
-        const uint64_t blockSize = 0x1000ULL;
+        const uint64_t blockSize = IOPageCache::PAGE_BYTES;
         uint64_t alignedAddr = address & ~(blockSize - 1);
         int offset = address - alignedAddr;
         int len = (offset + length + (blockSize - 1)) & ~(blockSize - 1);
+        uint64_t prevFirstBlockAddr = m_firstBlockAddr;
         m_firstBlockAddr = alignedAddr;
         m_lastValidAddr = length ? alignedAddr + len - 1 : 0;
         if (m_lastValidAddr < m_firstBlockAddr) {
             m_lastValidAddr = -1;
             len = m_lastValidAddr - m_firstBlockAddr + 1;
         }
+        IOPageCache *cache = Core()->getIOPageCache();
         m_blocks.clear();
         uint64_t addr = alignedAddr;
         for (ut64 i = 0; i < len / blockSize; ++i, addr += blockSize) {
-            m_blocks.append(Core()->ioRead(addr, blockSize));
+            m_blocks.append(cache->page(addr));
+        }
+
+        // Read the next screen in scroll direction ahead
+        if (len > 0 && alignedAddr > prevFirstBlockAddr && m_lastValidAddr != UINT64_MAX) {
+            cache->prefetch(m_lastValidAddr + 1, len);
+        } else if (len > 0 && alignedAddr < prevFirstBlockAddr && alignedAddr > 0) {
+            uint64_t prefetchAddr = alignedAddr > uint64_t(len) ? alignedAddr - len : 0;
+            cache->prefetch(prefetchAddr, alignedAddr - prefetchAddr);
         }
     }
 
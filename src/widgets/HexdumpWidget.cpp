@@ -5,6 +5,7 @@
 #include "common/Configuration.h"
 #include "common/TempConfig.h"
 #include "common/SyntaxHighlighter.h"
+#include "common/HashTask.h"
 #include "core/MainWindow.h"
 
 #include <QJsonObject>
@@ -118,7 +119,10 @@ void HexdumpWidget::onSeekChanged(RVA addr)
     refresh(addr);
 }
 
-HexdumpWidget::~HexdumpWidget() {}
+HexdumpWidget::~HexdumpWidget()
+{
+    cancelHashTask();
+}
 
 QString HexdumpWidget::getWidgetType()
 {
@@ -192,12 +196,26 @@ void HexdumpWidget::fontsUpdated()
 
 void HexdumpWidget::clearParseWindow()
 {
+    cancelHashTask();
     ui->hexDisasTextEdit->setPlainText("");
-    ui->bytesEntropy->setText("");
-    ui->bytesMD5->setText("");
-    ui->bytesSHA1->setText("");
-    ui->bytesSHA256->setText("");
-    ui->bytesCRC32->setText("");
+    setHashesText("");
+}
+
+void HexdumpWidget::cancelHashTask()
+{
+    if (hashTask) {
+        hashTask->interrupt();
+        hashTask.clear();
+    }
+}
+
+void HexdumpWidget::setHashesText(const QString &text)
+{
+    ui->bytesEntropy->setText(text);
+    ui->bytesMD5->setText(text);
+    ui->bytesSHA1->setText(text);
+    ui->bytesSHA256->setText(text);
+    ui->bytesCRC32->setText(text);
 }
 
 void HexdumpWidget::showSidePanel(bool show)
@@ -276,16 +294,34 @@ void HexdumpWidget::updateParseWindow(RVA start_address, int size)
         }
         ui->hexDisasTextEdit->setPlainText(selectedCommand != "" ? Core()->cmd(selectedCommand + " " + argument) : "");
     } else {
-        // Fill the information tab hashes and entropy
-        ui->bytesMD5->setText(Core()->cmd("ph md5 " + argument).trimmed());
-        ui->bytesSHA1->setText(Core()->cmd("ph sha1 " + argument).trimmed());
-        ui->bytesSHA256->setText(Core()->cmd("ph sha256 " + argument).trimmed());
-        ui->bytesCRC32->setText(Core()->cmd("ph crc32 " + argument).trimmed());
-        ui->bytesEntropy->setText(Core()->cmd("ph entropy " + argument).trimmed());
-        ui->bytesMD5->setCursorPosition(0);
-        ui->bytesSHA1->setCursorPosition(0);
-        ui->bytesSHA256->setCursorPosition(0);
-        ui->bytesCRC32->setCursorPosition(0);
+        // Fill the information tab hashes and entropy in the background
+        cancelHashTask();
+        setHashesText(tr("Computing..."));
+
+        hashTask.reset(new HashTask(start_address, static_cast<ut64>(size)));
+        HashTask *task = hashTask.data();
+        connect(task, &HashTask::progress, this, [this, task](int percent) {
+            if (task == hashTask.data()) {
+                setHashesText(tr("Computing... %1%").arg(percent));
+            }
+        });
+        connect(task, &AsyncTask::finished, this, [this, task]() {
+            if (task != hashTask.data()) {
+                return;
+            }
+            const HashTask::Result &result = task->getResult();
+            ui->bytesMD5->setText(result.md5);
+            ui->bytesSHA1->setText(result.sha1);
+            ui->bytesSHA256->setText(result.sha256);
+            ui->bytesCRC32->setText(result.crc32);
+            ui->bytesEntropy->setText(result.entropy);
+            ui->bytesMD5->setCursorPosition(0);
+            ui->bytesSHA1->setCursorPosition(0);
+            ui->bytesSHA256->setCursorPosition(0);
+            ui->bytesCRC32->setCursorPosition(0);
+            hashTask.clear();
+        });
+        Core()->getAsyncTaskManager()->start(hashTask);
     }
 }
 
@@ -5,6 +5,7 @@
 #include <QTextEdit>
 #include <QMouseEvent>
 #include <QAction>
+#include <QSharedPointer>
 
 #include <array>
 #include <memory>
@@ -25,6 +26,7 @@ class HexdumpWidget;
 }
 
 class RefreshDeferrer;
+class HashTask;
 class QSyntaxHighlighter;
 
 class HexdumpWidget : public MemoryDockWidget
@@ -51,6 +53,11 @@ private:
     RefreshDeferrer *refreshDeferrer;
     QSyntaxHighlighter *syntaxHighLighter;
 
+    /**
+     * @brief Hashes of the current selection being computed, results of any other task are dropped
+     */
+    QSharedPointer<HashTask> hashTask;
+
     void refresh();
     void refresh(RVA addr);
     void selectHexPreview();
@@ -60,6 +67,8 @@ private:
     void refreshSelectionInfo();
     void updateParseWindow(RVA start_address, int size);
     void clearParseWindow();
+    void cancelHashTask();
+    void setHashesText(const QString &text);
     void showSidePanel(bool show);
 
     QString getWindowTitle() const override;
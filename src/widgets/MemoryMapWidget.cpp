@@ -2,6 +2,7 @@
 #include "ui_ListDockWidget.h"
 #include "core/MainWindow.h"
 #include "common/Helpers.h"
+#include "common/DebugStateSnapshot.h"
 #include <QShortcut>
 
 MemoryMapModel::MemoryMapModel(QList<MemoryMapDescription> *memoryMaps, QObject *parent)
@@ -144,7 +145,7 @@ void MemoryMapWidget::refreshMemoryMap()
         return;
     }
     memoryModel->beginResetModel();
-    memoryMaps = Core()->getMemoryMap();
+    memoryMaps = Core()->getDebugState()->getMemoryMap();
     memoryModel->endResetModel();
 
     ui->treeView->resizeColumnToContents(0);
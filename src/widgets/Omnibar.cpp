@@ -1,5 +1,6 @@
 #include "Omnibar.h"
 #include "core/MainWindow.h"
+#include "common/NameIndexTask.h"
 #include "CutterSeekable.h"
 
 #include <QStringListModel>
@@ -7,6 +8,16 @@
 #include <QShortcut>
 #include <QAbstractItemView>
 
+/**
+ * Number of names shown in the completion popup
+ */
+static const int MAX_COMPLETIONS = 50;
+
+/**
+ * Delay before rebuilding the index, so bursts of changes only rebuild it once
+ */
+static const int INDEX_REBUILD_DELAY_MS = 1000;
+
 
 Omnibar::Omnibar(MainWindow *main, QWidget *parent) :
     QLineEdit(parent),
@@ -20,41 +31,127 @@ Omnibar::Omnibar(MainWindow *main, QWidget *parent) :
     this->setTextMargins(10, 0, 0, 0);
     this->setClearButtonEnabled(true);
 
+    // The index already filtered and ordered the completions
+    completionModel = new QStringListModel(this);
+    QCompleter *completer = new QCompleter(completionModel, this);
+    completer->setMaxVisibleItems(20);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    this->setCompleter(completer);
+
     connect(this, SIGNAL(returnPressed()), this, SLOT(on_gotoEntry_returnPressed()));
+    connect(this, &QLineEdit::textEdited, this, &Omnibar::updateCompletions);
 
     // Esc clears omnibar
     QShortcut *clear_shortcut = new QShortcut(QKeySequence(Qt::Key_Escape), this);
     connect(clear_shortcut, SIGNAL(activated()), this, SLOT(clear()));
     clear_shortcut->setContext(Qt::WidgetWithChildrenShortcut);
+
+    rebuildTimer.setSingleShot(true);
+    rebuildTimer.setInterval(INDEX_REBUILD_DELAY_MS);
+    connect(&rebuildTimer, &QTimer::timeout, this, &Omnibar::rebuildIndex);
+
+    connect(Core(), &CutterCore::refreshAll, this, &Omnibar::scheduleIndexRebuild);
+    connect(Core(), &CutterCore::codeRebased, this, &Omnibar::scheduleIndexRebuild);
+    connect(Core(), &CutterCore::flagsChanged, this, &Omnibar::scheduleIndexRebuild);
+    connect(Core(), &CutterCore::functionsChanged, this, &Omnibar::functionsChanged);
+    connect(Core(), &CutterCore::functionRenamed, this, &Omnibar::functionRenamed);
+    connect(Core(), &CutterCore::functionAdded, this, &Omnibar::functionAdded);
+    connect(Core(), &CutterCore::functionRemoved, this, &Omnibar::functionRemoved);
 }
 
-void Omnibar::setupCompleter()
+void Omnibar::updateCompletions(const QString &text)
 {
-    // Set gotoEntry completer for jump history
-    QCompleter *completer = new QCompleter(flags, this);
-    completer->setMaxVisibleItems(20);
-    completer->setCompletionMode(QCompleter::PopupCompletion);
-    completer->setModelSorting(QCompleter::CaseSensitivelySortedModel);
-    completer->setCaseSensitivity(Qt::CaseInsensitive);
-    completer->setFilterMode(Qt::MatchContains);
+    QStringList names;
+    completionOffsets.clear();
+    if (index) {
+        for (const NameIndexEntry &entry : index->search(text, MAX_COMPLETIONS)) {
+            if (!completionOffsets.contains(entry.name)) {
+                completionOffsets.insert(entry.name, entry.offset);
+                names.append(entry.name);
+            }
+        }
+    }
+    completionModel->setStringList(names);
+    if (!names.isEmpty()) {
+        completer()->complete();
+    }
+}
 
-    this->setCompleter(completer);
+void Omnibar::scheduleIndexRebuild()
+{
+    if (indexTask) {
+        indexTaskOutdated = true;
+    }
+    rebuildTimer.start();
 }
 
-void Omnibar::refresh(const QStringList &flagList)
+void Omnibar::rebuildIndex()
 {
-    flags = flagList;
+    if (indexTask) {
+        // rebuilt again once the running task finished
+        indexTaskOutdated = true;
+        return;
+    }
 
-    setupCompleter();
+    indexTaskOutdated = false;
+    indexTask.reset(new NameIndexTask());
+    NameIndexTask *task = indexTask.data();
+    connect(task, &AsyncTask::finished, this, [this, task]() {
+        if (task != indexTask.data()) {
+            return;
+        }
+        if (task->getIndex()) {
+            index = task->getIndex();
+        }
+        indexTask.clear();
+        if (indexTaskOutdated) {
+            scheduleIndexRebuild();
+        }
+    });
+    Core()->getAsyncTaskManager()->start(indexTask);
+}
+
+void Omnibar::functionRenamed(const QString &prevName, const QString &newName)
+{
+    if (indexTask) {
+        indexTaskOutdated = true;
+    }
+    if (index) {
+        index->rename(prevName, newName);
+    }
+}
+
+void Omnibar::functionAdded(RVA offset)
+{
+    functionsUpdated = true;
+    if (indexTask) {
+        indexTaskOutdated = true;
+    }
+    FunctionDescription function;
+    if (index && Core()->getFunctionDescription(offset, function)) {
+        index->add({ function.name, function.offset, NameIndexEntry::Function });
+    }
+}
+
+void Omnibar::functionRemoved(RVA offset)
+{
+    functionsUpdated = true;
+    if (indexTask) {
+        indexTaskOutdated = true;
+    }
+    if (index) {
+        index->remove(NameIndexEntry::Function, offset);
+    }
 }
 
-void Omnibar::restoreCompleter()
+void Omnibar::functionsChanged()
 {
-    QCompleter *completer = this->completer();
-    if (!completer) {
+    if (functionsUpdated) {
+        functionsUpdated = false;
         return;
     }
-    completer->setFilterMode(Qt::MatchContains);
+    scheduleIndexRebuild();
 }
 
 void Omnibar::clear()
@@ -70,10 +167,16 @@ void Omnibar::on_gotoEntry_returnPressed()
 {
     QString str = this->text();
     if (!str.isEmpty()) {
+        // Expressions, registers and flags are evaluated by r2 as before. Only names r2 can't
+        // evaluate, such as demangled ones, are seeked to through the index.
+        RVA offset = Core()->math(str);
+        auto it = completionOffsets.constFind(str);
+        bool fromIndex = !offset && it != completionOffsets.constEnd();
         if (auto memoryWidget = main->getLastMemoryWidget()) {
-            RVA offset = Core()->math(str);
-            memoryWidget->getSeekable()->seek(offset);
+            memoryWidget->getSeekable()->seek(fromIndex ? it.value() : offset);
             memoryWidget->raiseMemoryWidget();
+        } else if (fromIndex) {
+            Core()->seekAndShow(it.value());
         } else {
             Core()->seekAndShow(str);
         }
@@ -81,5 +184,6 @@ void Omnibar::on_gotoEntry_returnPressed()
 
     this->setText("");
     this->clearFocus();
-    this->restoreCompleter();
+    completionOffsets.clear();
+    completionModel->setStringList(QStringList());
 }
@@ -1,9 +1,17 @@
 #ifndef OMNIBAR_H
 #define OMNIBAR_H
 
+#include "core/CutterCommon.h"
+#include "common/NameIndex.h"
+
 #include <QLineEdit>
+#include <QHash>
+#include <QSharedPointer>
+#include <QTimer>
 
 class MainWindow;
+class NameIndexTask;
+class QStringListModel;
 
 class Omnibar : public QLineEdit
 {
@@ -11,21 +19,38 @@ class Omnibar : public QLineEdit
 public:
     explicit Omnibar(MainWindow *main, QWidget *parent = nullptr);
 
-    void refresh(const QStringList &flagList);
-
 private slots:
     void on_gotoEntry_returnPressed();
 
-    void restoreCompleter();
+    void updateCompletions(const QString &text);
+    void scheduleIndexRebuild();
+    void rebuildIndex();
+
+    void functionRenamed(const QString &prevName, const QString &newName);
+    void functionAdded(RVA offset);
+    void functionRemoved(RVA offset);
+    void functionsChanged();
 
 public slots:
     void clear();
 
 private:
-    void setupCompleter();
-
     MainWindow          *main;
-    QStringList         flags;
+
+    QSharedPointer<NameIndex> index;
+    QSharedPointer<NameIndexTask> indexTask;
+    /**
+     * Names changed while indexTask was running, so its index is outdated already
+     */
+    bool indexTaskOutdated = false;
+    /**
+     * The next functionsChanged() was already handled by functionAdded() or functionRemoved()
+     */
+    bool functionsUpdated = false;
+    QTimer rebuildTimer;
+
+    QStringListModel    *completionModel;
+    QHash<QString, RVA> completionOffsets;
 };
 
 #endif // OMNIBAR_H
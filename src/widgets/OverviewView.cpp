@@ -21,6 +21,7 @@ void OverviewView::setData(int baseWidth, int baseHeight,
     width = baseWidth;
     height = baseHeight;
     blocks = baseBlocks;
+    setSpatialIndexDirty();
     edgeConfigurations = baseEdgeConfigurations;
     scaleAndCenter();
     setCacheDirty();
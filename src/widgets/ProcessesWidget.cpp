@@ -2,6 +2,7 @@
 #include "ProcessesWidget.h"
 #include "ui_ProcessesWidget.h"
 #include "common/JsonModel.h"
+#include "common/DebugStateSnapshot.h"
 #include "QuickFilterView.h"
 #include <r_debug.h>
 
@@ -108,7 +109,7 @@ QString ProcessesWidget::translateStatus(QString status)
 
 void ProcessesWidget::setProcessesGrid()
 {
-    QJsonArray processesValues = Core()->getChildProcesses(DEBUGGED_PID).array();
+    const QJsonArray &processesValues = Core()->getDebugState()->getProcesses();
     int i = 0;
     QFont font;
 
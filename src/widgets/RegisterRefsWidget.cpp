@@ -2,6 +2,7 @@
 #include "ui_RegisterRefsWidget.h"
 #include "core/MainWindow.h"
 #include "common/Helpers.h"
+#include "common/DebugStateSnapshot.h"
 
 #include <QMenu>
 #include <QClipboard>
@@ -161,7 +162,7 @@ void RegisterRefsWidget::refreshRegisterRef()
     }
 
     registerRefModel->beginResetModel();
-    registerRefs = Core()->getRegisterRefs();
+    registerRefs = Core()->getDebugState()->getRegisterRefs();
     registerRefModel->endResetModel();
 
     ui->registerRefTreeView->resizeColumnToContents(0);
@@ -1,6 +1,7 @@
 #include "RegistersWidget.h"
 #include "ui_RegistersWidget.h"
 #include "common/JsonModel.h"
+#include "common/DebugStateSnapshot.h"
 
 #include "core/MainWindow.h"
 
@@ -51,8 +52,12 @@ void RegistersWidget::setRegisterGrid()
     QString regValue;
     QLabel *registerLabel;
     QLineEdit *registerEditValue;
-    QJsonObject registerValues = Core()->getRegisterValues().object();
-    QJsonObject registerRefs = Core()->getRegisterJson();
+    DebugStateSnapshot *debugState = Core()->getDebugState();
+    const QJsonObject &registerValues = debugState->getRegisterValues();
+    QHash<QString, QString> registerRefs;
+    for (const RegisterRefDescription &regRef : debugState->getRegisterRefs()) {
+        registerRefs.insert(regRef.reg, regRef.ref);
+    }
     QStringList registerNames = registerValues.keys();
 
     QCollator collator;
@@ -107,7 +112,7 @@ void RegistersWidget::setRegisterGrid()
         registerLabel->setText(key);
         if (registerRefs.contains(key)) {
             // add register references to tooltips
-            QString reference = registerRefs[key].toObject()["ref"].toString();
+            QString reference = registerRefs[key];
             registerLabel->setToolTip(reference);
             registerEditValue->setToolTip(reference);
         }
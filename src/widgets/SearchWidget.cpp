@@ -131,26 +131,28 @@ RVA SearchModel::address(const QModelIndex &index) const
 
 
 SearchSortFilterProxyModel::SearchSortFilterProxyModel(SearchModel *source_model, QObject *parent)
-    : AddressableFilterProxyModel(source_model, parent)
+    : AddressableFilterProxyModel(source_model, parent),
+      search(source_model->search)
 {
+    enableRowIndex();
 }
 
-bool SearchSortFilterProxyModel::filterAcceptsRow(int row, const QModelIndex &parent) const
+bool SearchSortFilterProxyModel::filterAcceptsRow(int row, const QModelIndex &) const
 {
-    QModelIndex index = sourceModel()->index(row, 0, parent);
-    SearchDescription search = index.data(
-                                   SearchModel::SearchDescriptionRole).value<SearchDescription>();
-    return search.code.contains(filterRegExp());
+    return rowMatchesFilter(row);
 }
 
-bool SearchSortFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+QString SearchSortFilterProxyModel::rowFilterText(int row) const
 {
-    SearchDescription left_search = left.data(
-                                        SearchModel::SearchDescriptionRole).value<SearchDescription>();
-    SearchDescription right_search = right.data(
-                                         SearchModel::SearchDescriptionRole).value<SearchDescription>();
+    return search->at(row).code;
+}
+
+bool SearchSortFilterProxyModel::lessThanRows(int column, int leftRow, int rightRow) const
+{
+    const SearchDescription &left_search = search->at(leftRow);
+    const SearchDescription &right_search = search->at(rightRow);
 
-    switch (left.column()) {
+    switch (column) {
     case SearchModel::SIZE:
         return left_search.size < right_search.size;
     case SearchModel::OFFSET:
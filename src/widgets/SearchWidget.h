@@ -13,6 +13,7 @@
 class MainWindow;
 class QTreeWidgetItem;
 class SearchWidget;
+class SearchSortFilterProxyModel;
 
 
 class SearchModel: public AddressableItemModel<QAbstractListModel>
@@ -20,6 +21,7 @@ class SearchModel: public AddressableItemModel<QAbstractListModel>
     Q_OBJECT
 
     friend SearchWidget;
+    friend SearchSortFilterProxyModel;
 
 private:
     QList<SearchDescription> *search;
@@ -50,7 +52,11 @@ public:
 
 protected:
     bool filterAcceptsRow(int row, const QModelIndex &parent) const override;
-    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+    QString rowFilterText(int row) const override;
+    bool lessThanRows(int column, int leftRow, int rightRow) const override;
+
+private:
+    const QList<SearchDescription> *search;
 };
 
 
@@ -3,6 +3,7 @@
 #include "core/MainWindow.h"
 #include "common/Helpers.h"
 #include "common/Configuration.h"
+#include "common/SectionStatistics.h"
 #include "ui_ListDockWidget.h"
 
 #include <QGraphicsSceneMouseEvent>
@@ -73,6 +74,15 @@ QVariant SectionsModel::data(const QModelIndex &index, int role) const
         if (index.column() == 0)
             return colors[index.row() % colors.size()];
         return QVariant();
+    case Qt::ToolTipRole:
+        if (index.column() == SectionsModel::EntropyColumn) {
+            FileRangeStatistics statistics;
+            if (Core()->getSectionStatistics()->getStatistics(section.paddr, section.size,
+                                                              &statistics)) {
+                return tr("MD5: %1\nSHA256: %2").arg(statistics.md5, statistics.sha256);
+            }
+        }
+        return QVariant();
     case SectionsModel::SectionDescriptionRole:
         return QVariant::fromValue(section);
     default:
@@ -216,6 +226,8 @@ void SectionsWidget::initConnects()
 {
     connect(Core(), &CutterCore::refreshAll, this, &SectionsWidget::refreshSections);
     connect(Core(), &CutterCore::codeRebased, this, &SectionsWidget::refreshSections);
+    connect(Core()->getSectionStatistics(), &SectionStatistics::statisticsReady,
+            this, &SectionsWidget::updateSectionStatistics);
     connect(this, &QDockWidget::visibilityChanged, this, [ = ](bool visibility) {
         if (visibility) {
             refreshSections();
@@ -241,12 +253,31 @@ void SectionsWidget::refreshSections()
         return;
     }
     sectionsModel->beginResetModel();
+    // Entropy is filled in by updateSectionStatistics() once it was computed in the background
     sections = Core()->getAllSections();
     sectionsModel->endResetModel();
+    updateSectionStatistics();
     qhelpers::adjustColumns(ui->treeView, SectionsModel::ColumnCount, 0);
     refreshDocks();
 }
 
+void SectionsWidget::updateSectionStatistics()
+{
+    SectionStatistics *sectionStatistics = Core()->getSectionStatistics();
+    for (int i = 0; i < sections.size(); i++) {
+        SectionDescription &section = sections[i];
+        if (!section.entropy.isEmpty()) {
+            continue;
+        }
+        FileRangeStatistics statistics;
+        if (sectionStatistics->getStatistics(section.paddr, section.size, &statistics)) {
+            section.entropy = QString::number(statistics.entropy, 'f', 8);
+            QModelIndex index = sectionsModel->index(i, SectionsModel::EntropyColumn);
+            emit sectionsModel->dataChanged(index, index);
+        }
+    }
+}
+
 void SectionsWidget::refreshDocks()
 {
     if (!dockRefreshDeferrer->attemptRefresh(nullptr)) {
@@ -73,6 +73,7 @@ public:
 private slots:
     void refreshSections();
     void refreshDocks();
+    void updateSectionStatistics();
 protected:
     void resizeEvent(QResizeEvent *event) override;
 
@@ -2,6 +2,7 @@
 #include "ui_StackWidget.h"
 #include "common/JsonModel.h"
 #include "common/Helpers.h"
+#include "common/DebugStateSnapshot.h"
 #include "dialogs/EditInstructionDialog.h"
 
 #include "core/MainWindow.h"
@@ -156,43 +157,45 @@ static inline const QString append_var(QString &dst, const QString val, const QS
 
 void StackModel::reload()
 {
-    QList<QJsonObject> stackItems = Core()->getStack();
+    const QList<AddrRefChain> &stackItems = Core()->getDebugState()->getStack();
 
     beginResetModel();
     values.clear();
-    for (const QJsonObject &stackItem : stackItems) {
+    for (const AddrRefChain &stackItem : stackItems) {
+        if (stackItem.isEmpty()) {
+            continue;
+        }
         Item item;
 
-        item.offset = stackItem["addr"].toVariant().toULongLong();
-        item.value = RAddressString(stackItem["value"].toVariant().toULongLong());
+        item.offset = stackItem.first().addr;
+        item.value = RAddressString(stackItem.first().value);
 
-        QJsonObject refItem = stackItem["ref"].toObject();
-        if (!refItem.empty()) {
-            QString str = refItem["string"].toVariant().toString();
-            if (!str.isEmpty()) {
-                item.description = str;
+        if (stackItem.size() > 1) {
+            const AddrRefDescription &refItem = stackItem.at(1);
+            if (!refItem.string.isEmpty()) {
+                item.description = refItem.string;
                 item.descriptionColor = ConfigColor("comment");
             } else {
                 QString type, string;
-                do {
+                for (int i = 1; i < stackItem.size(); i++) {
+                    const AddrRefDescription &ref = stackItem.at(i);
                     item.description += " ->";
-                    append_var(item.description, refItem["reg"].toVariant().toString(), " @", "");
-                    append_var(item.description, refItem["mapname"].toVariant().toString(), " (", ")");
-                    append_var(item.description, refItem["section"].toVariant().toString(), " (", ")");
-                    append_var(item.description, refItem["func"].toVariant().toString(), " ", "");
-                    type = append_var(item.description, refItem["type"].toVariant().toString(), " ", "");
-                    append_var(item.description, refItem["perms"].toVariant().toString(), " ", "");
-                    append_var(item.description, refItem["asm"].toVariant().toString(), " \"", "\"");
-                    string = append_var(item.description, refItem["string"].toVariant().toString(), " ", "");
+                    append_var(item.description, ref.reg, " @", "");
+                    append_var(item.description, ref.mapname, " (", ")");
+                    append_var(item.description, ref.section, " (", ")");
+                    append_var(item.description, ref.fcn, " ", "");
+                    type = append_var(item.description, ref.type, " ", "");
+                    append_var(item.description, ref.perms, " ", "");
+                    append_var(item.description, ref.asmText, " \"", "\"");
+                    string = append_var(item.description, ref.string, " ", "");
                     if (!string.isNull()) {
                         // There is no point in adding ascii and addr info after a string
                         break;
                     }
-                    if (!refItem["value"].isNull()) {
-                        append_var(item.description, RAddressString(refItem["value"].toVariant().toULongLong()), " ", "");
+                    if (ref.hasValue) {
+                        append_var(item.description, RAddressString(ref.value), " ", "");
                     }
-                    refItem = refItem["ref"].toObject();
-                } while (!refItem.empty());
+                }
 
                 // Set the description's color according to the last item type
                 if (type == "ascii" || !string.isEmpty()) {
@@ -94,47 +94,50 @@ const StringDescription *StringsModel::description(const QModelIndex &index) con
 }
 
 StringsProxyModel::StringsProxyModel(StringsModel *sourceModel, QObject *parent)
-    : AddressableFilterProxyModel(sourceModel, parent)
+    : AddressableFilterProxyModel(sourceModel, parent),
+      strings(sourceModel->strings)
 {
     setFilterCaseSensitivity(Qt::CaseInsensitive);
     setSortCaseSensitivity(Qt::CaseInsensitive);
+    enableRowIndex();
 }
 
-bool StringsProxyModel::filterAcceptsRow(int row, const QModelIndex &parent) const
+bool StringsProxyModel::filterAcceptsRow(int row, const QModelIndex &) const
 {
-    QModelIndex index = sourceModel()->index(row, 0, parent);
-    StringDescription str = index.data(StringsModel::StringDescriptionRole).value<StringDescription>();
-    if (selectedSection.isEmpty())
-        return str.string.contains(filterRegExp());
-    else
-        return selectedSection == str.section && str.string.contains(filterRegExp());
+    if (!selectedSection.isEmpty() && selectedSection != strings->at(row).section)
+        return false;
+    return rowMatchesFilter(row);
 }
 
-bool StringsProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+QString StringsProxyModel::rowFilterText(int row) const
 {
-    auto model = static_cast<StringsModel *>(sourceModel());
-    auto leftStr = model->description(left);
-    auto rightStr = model->description(right);
+    return strings->at(row).string;
+}
+
+bool StringsProxyModel::lessThanRows(int column, int leftRow, int rightRow) const
+{
+    const StringDescription &leftStr = strings->at(leftRow);
+    const StringDescription &rightStr = strings->at(rightRow);
 
-    switch (left.column()) {
+    switch (column) {
     case StringsModel::OffsetColumn:
-        return leftStr->vaddr < rightStr->vaddr;
+        return leftStr.vaddr < rightStr.vaddr;
     case StringsModel::StringColumn: // sort by string
-        return leftStr->string < rightStr->string;
+        return leftStr.string < rightStr.string;
     case StringsModel::TypeColumn: // sort by type
-        return leftStr->type < rightStr->type;
+        return leftStr.type < rightStr.type;
     case StringsModel::SizeColumn: // sort by size
-        return leftStr->size < rightStr->size;
+        return leftStr.size < rightStr.size;
     case StringsModel::LengthColumn: // sort by length
-        return leftStr->length < rightStr->length;
+        return leftStr.length < rightStr.length;
     case StringsModel::SectionColumn:
-        return leftStr->section < rightStr->section;
+        return leftStr.section < rightStr.section;
     default:
         break;
     }
 
     // fallback
-    return leftStr->vaddr < rightStr->vaddr;
+    return leftStr.vaddr < rightStr.vaddr;
 }
 
 StringsWidget::StringsWidget(MainWindow *main, QAction *action) :
@@ -211,17 +214,39 @@ StringsWidget::StringsWidget(MainWindow *main, QAction *action) :
     header->setResizeContentsPrecision(256);
 }
 
-StringsWidget::~StringsWidget() {}
+StringsWidget::~StringsWidget()
+{
+    if (task) {
+        task->interrupt();
+        task->wait();
+    }
+}
 
 void StringsWidget::refreshStrings()
 {
     if (task) {
+        task->interrupt();
         task->wait();
     }
 
+    model->beginResetModel();
+    strings.clear();
+    model->endResetModel();
+    tree->showItemsNumber(proxyModel->rowCount());
+
+    int generation = ++searchGeneration;
     task = QSharedPointer<StringsTask>(new StringsTask());
-    connect(task.data(), &StringsTask::stringSearchFinished, this,
-            &StringsWidget::stringSearchFinished);
+    connect(task.data(), &StringsTask::stringsFound, this,
+            [this, generation](const QList<StringDescription> &found) {
+        if (generation == searchGeneration) {
+            addStrings(found);
+        }
+    });
+    connect(task.data(), &StringsTask::stringSearchFinished, this, [this, generation]() {
+        if (generation == searchGeneration) {
+            stringSearchFinished();
+        }
+    });
     Core()->getAsyncTaskManager()->start(task);
 
     refreshSectionCombo();
@@ -241,13 +266,21 @@ void StringsWidget::refreshSectionCombo()
     proxyModel->selectedSection.clear();
 }
 
-void StringsWidget::stringSearchFinished(const QList<StringDescription> &strings)
+void StringsWidget::addStrings(const QList<StringDescription> &found)
 {
-    model->beginResetModel();
-    this->strings = strings;
-    model->endResetModel();
+    if (found.isEmpty()) {
+        return;
+    }
+    model->beginInsertRows(QModelIndex(), strings.count(), strings.count() + found.count() - 1);
+    strings.append(found);
+    model->endInsertRows();
 
     tree->showItemsNumber(proxyModel->rowCount());
+}
+
+void StringsWidget::stringSearchFinished()
+{
+    tree->showItemsNumber(proxyModel->rowCount());
 
     task.clear();
 }
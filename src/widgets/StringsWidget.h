@@ -15,6 +15,7 @@
 class MainWindow;
 class QTreeWidgetItem;
 class StringsWidget;
+class StringsProxyModel;
 
 namespace Ui {
 class StringsWidget;
@@ -25,6 +26,7 @@ class StringsModel: public AddressableItemModel<QAbstractListModel>
     Q_OBJECT
 
     friend StringsWidget;
+    friend StringsProxyModel;
 
 private:
     QList<StringDescription> *strings;
@@ -59,12 +61,19 @@ public:
 
 protected:
     bool filterAcceptsRow(int row, const QModelIndex &parent) const override;
-    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+    QString rowFilterText(int row) const override;
+    bool lessThanRows(int column, int leftRow, int rightRow) const override;
 
+    const QList<StringDescription> *strings;
     QString selectedSection;
 };
 
 
+/**
+ * @brief Lists the strings of the whole file, found by a StringsTask.
+ *
+ * Unlike "izz", UTF-16 and UTF-32 strings are only listed if they consist of printable ASCII.
+ */
 class StringsWidget : public CutterDockWidget
 {
     Q_OBJECT
@@ -75,7 +84,8 @@ public:
 
 private slots:
     void refreshStrings();
-    void stringSearchFinished(const QList<StringDescription> &strings);
+    void addStrings(const QList<StringDescription> &strings);
+    void stringSearchFinished();
     void refreshSectionCombo();
 
     void on_actionCopy();
@@ -84,6 +94,10 @@ private:
     std::unique_ptr<Ui::StringsWidget> ui;
 
     QSharedPointer<StringsTask> task;
+    /**
+     * Incremented on every refresh, batches from older searches are dropped
+     */
+    int searchGeneration = 0;
 
     StringsModel *model;
     StringsProxyModel *proxyModel;
@@ -2,6 +2,7 @@
 #include "ThreadsWidget.h"
 #include "ui_ThreadsWidget.h"
 #include "common/JsonModel.h"
+#include "common/DebugStateSnapshot.h"
 #include "QuickFilterView.h"
 #include <r_debug.h>
 
@@ -107,7 +108,7 @@ QString ThreadsWidget::translateStatus(QString status)
 
 void ThreadsWidget::setThreadsGrid()
 {
-    QJsonArray threadsValues = Core()->getProcessThreads(DEBUGGED_PID).array();
+    const QJsonArray &threadsValues = Core()->getDebugState()->getThreads();
     int i = 0;
     QFont font;
                 
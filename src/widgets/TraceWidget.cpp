@@ -0,0 +1,177 @@
+#include "TraceWidget.h"
+#include "ui_TraceWidget.h"
+#include "common/Configuration.h"
+#include "common/Helpers.h"
+#include "common/TraceManager.h"
+
+#include "core/MainWindow.h"
+
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QSignalBlocker>
+
+#include <algorithm>
+#include <limits>
+
+TraceWidget::TraceWidget(MainWindow *main, QAction *action) :
+    CutterDockWidget(main, action),
+    ui(new Ui::TraceWidget)
+{
+    ui->setupUi(this);
+    ui->stateTreeWidget->setFont(Config()->getFont());
+
+    TraceManager *traceManager = Core()->getTraceManager();
+    connect(ui->recordButton, &QPushButton::clicked, this, &TraceWidget::toggleRecording);
+    connect(ui->openButton, &QPushButton::clicked, this, &TraceWidget::openTrace);
+    connect(ui->closeButton, &QPushButton::clicked, traceManager, &TraceManager::closeTrace);
+    connect(ui->applyButton, &QPushButton::clicked, this, &TraceWidget::applyState);
+    connect(ui->stateSlider, &QSlider::valueChanged, ui->stateSpinBox, &QSpinBox::setValue);
+    connect(ui->stateSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, &TraceWidget::showState);
+
+    connect(traceManager, &TraceManager::traceChanged, this, &TraceWidget::traceChanged);
+    connect(traceManager, &TraceManager::recordingChanged, this, &TraceWidget::updateActions);
+    connect(traceManager, &TraceManager::applyingStateChanged, this, &TraceWidget::updateActions);
+    connect(traceManager, &TraceManager::recordingFailed, this, [this](const QString & errorString) {
+        QMessageBox::critical(this, tr("Trace"), tr("Recording failed: %1").arg(errorString));
+    });
+    connect(Core(), &CutterCore::debugTaskStateChanged, this, &TraceWidget::updateActions);
+    connect(Core(), &CutterCore::toggleDebugView, this, &TraceWidget::updateActions);
+    connect(Config(), &Configuration::fontsUpdated, this, &TraceWidget::fontsUpdatedSlot);
+
+    traceChanged();
+}
+
+TraceWidget::~TraceWidget() {}
+
+void TraceWidget::toggleRecording()
+{
+    TraceManager *traceManager = Core()->getTraceManager();
+    if (traceManager->isRecording()) {
+        traceManager->stopRecording();
+        return;
+    }
+    QString path = QFileDialog::getSaveFileName(this, tr("Record Trace"),
+                                                QDir::home().filePath("trace.ctrace"),
+                                                tr("Traces (*.ctrace)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    traceManager->startRecording(path, static_cast<quint64>(ui->maxStepsSpinBox->value()));
+}
+
+void TraceWidget::openTrace()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Open Trace"), QDir::homePath(),
+                                                tr("Traces (*.ctrace);;All Files (*)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    QString errorString;
+    if (!Core()->getTraceManager()->openTrace(path, &errorString)) {
+        QMessageBox::critical(this, tr("Trace"),
+                              tr("Could not open %1: %2").arg(path, errorString));
+    }
+}
+
+void TraceWidget::applyState()
+{
+    Core()->getTraceManager()->applyState(static_cast<quint64>(ui->stateSpinBox->value()));
+}
+
+void TraceWidget::traceChanged()
+{
+    QSharedPointer<TraceFile> trace = Core()->getTraceManager()->getTrace();
+    int maxState = 0;
+    if (trace && trace->getStateCount() > 0) {
+        maxState = static_cast<int>(std::min<quint64>(trace->getStateCount() - 1,
+                                                      std::numeric_limits<int>::max()));
+    }
+    {
+        QSignalBlocker sliderBlocker(ui->stateSlider);
+        QSignalBlocker spinBoxBlocker(ui->stateSpinBox);
+        ui->stateSlider->setRange(0, maxState);
+        ui->stateSlider->setValue(0);
+        ui->stateSpinBox->setRange(0, maxState);
+        ui->stateSpinBox->setValue(0);
+    }
+
+    ui->stateTreeWidget->clear();
+    if (!trace) {
+        ui->infoLabel->setText(tr("No trace"));
+    } else {
+        ui->infoLabel->setText(tr("%1: %2 steps").arg(QFileInfo(trace->getPath()).fileName())
+                               .arg(trace->getStateCount() ? trace->getStateCount() - 1 : 0));
+        if (trace->getStateCount() > 0) {
+            showState(0);
+        }
+    }
+    updateActions();
+}
+
+void TraceWidget::updateActions()
+{
+    TraceManager *traceManager = Core()->getTraceManager();
+    bool recording = traceManager->isRecording();
+    bool hasTrace = !traceManager->getTrace().isNull();
+    ui->recordButton->setText(recording ? tr("Stop") : tr("Record"));
+    ui->recordButton->setEnabled(recording
+                                 || (Core()->currentlyDebugging && !Core()->isDebugTaskInProgress()));
+    ui->maxStepsSpinBox->setEnabled(!recording);
+    ui->openButton->setEnabled(!recording);
+    ui->closeButton->setEnabled(hasTrace && !recording);
+    ui->stateSlider->setEnabled(hasTrace);
+    ui->stateSpinBox->setEnabled(hasTrace);
+    ui->applyButton->setEnabled(traceManager->canApplyState());
+}
+
+void TraceWidget::showState(int index)
+{
+    QSharedPointer<TraceFile> trace = Core()->getTraceManager()->getTrace();
+    if (!trace) {
+        return;
+    }
+    {
+        QSignalBlocker sliderBlocker(ui->stateSlider);
+        ui->stateSlider->setValue(index);
+    }
+    auto stateIndex = static_cast<quint64>(index);
+    TraceState state = trace->getState(stateIndex);
+    if (state.pc == RVA_INVALID) {
+        return;
+    }
+    TraceState previous = stateIndex > 0 ? trace->getState(stateIndex - 1) : state;
+
+    ui->stateTreeWidget->clear();
+    QFont changedFont = Config()->getFont();
+    changedFont.setBold(true);
+    auto addItem = [&](const QString & name, const QString & value, bool changed) {
+        auto item = new QTreeWidgetItem(ui->stateTreeWidget, { name, value });
+        if (changed) {
+            item->setFont(0, changedFont);
+            item->setFont(1, changedFont);
+        }
+    };
+
+    addItem(tr("PC"), RAddressString(state.pc), false);
+    const QStringList &registerNames = trace->getRegisterNames();
+    for (int i = 0; i < registerNames.size() && i < state.registers.size(); i++) {
+        bool changed = i < previous.registers.size() && previous.registers[i] != state.registers[i];
+        addItem(registerNames[i], RAddressString(state.registers[i]), changed);
+    }
+    for (const TraceMemoryWrite &write : trace->getWrites(stateIndex)) {
+        addItem(RAddressString(write.addr),
+                QString("%1 -> %2").arg(QString(write.oldData.toHex()), QString(write.newData.toHex())),
+                true);
+    }
+    qhelpers::adjustColumns(ui->stateTreeWidget, 0);
+
+    Core()->seek(state.pc);
+}
+
+void TraceWidget::fontsUpdatedSlot()
+{
+    ui->stateTreeWidget->setFont(Config()->getFont());
+}
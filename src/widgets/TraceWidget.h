@@ -0,0 +1,39 @@
+#ifndef TRACEWIDGET_H
+#define TRACEWIDGET_H
+
+#include <memory>
+
+#include "core/Cutter.h"
+#include "CutterDockWidget.h"
+
+class MainWindow;
+
+namespace Ui {
+class TraceWidget;
+}
+
+/**
+ * @brief Records execution traces and steps back and forth through the open one
+ */
+class TraceWidget : public CutterDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TraceWidget(MainWindow *main, QAction *action = nullptr);
+    ~TraceWidget();
+
+private slots:
+    void toggleRecording();
+    void openTrace();
+    void applyState();
+    void traceChanged();
+    void updateActions();
+    void showState(int index);
+    void fontsUpdatedSlot();
+
+private:
+    std::unique_ptr<Ui::TraceWidget> ui;
+};
+
+#endif // TRACEWIDGET_H
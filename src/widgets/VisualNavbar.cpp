@@ -1,26 +1,20 @@
 #include "VisualNavbar.h"
 #include "core/MainWindow.h"
 #include "common/TempConfig.h"
+#include "common/DebugStateSnapshot.h"
+#include "common/TraceManager.h"
 
-#include <QGraphicsView>
 #include <QComboBox>
-#include <QGraphicsScene>
-#include <QGraphicsRectItem>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QJsonParseError>
+#include <QPainter>
 #include <QToolTip>
 #include <QMouseEvent>
 
-#include <array>
+#include <algorithm>
 #include <cmath>
 
 VisualNavbar::VisualNavbar(MainWindow *main, QWidget *parent) :
     QToolBar(main),
-    graphicsView(new QGraphicsView),
-    seekGraphicsItem(nullptr),
-    PCGraphicsItem(nullptr),
+    canvas(new QWidget),
     main(main)
 {
     Q_UNUSED(parent);
@@ -39,33 +33,24 @@ VisualNavbar::VisualNavbar(MainWindow *main, QWidget *parent) :
     addsCombo->addItem("Entry points");
     addsCombo->addItem("Marks");
     */
-    addWidget(this->graphicsView);
+    addWidget(this->canvas);
     //addWidget(addsCombo);
 
     connect(Core(), SIGNAL(seekChanged(RVA)), this, SLOT(on_seekChanged(RVA)));
     connect(Core(), SIGNAL(registersChanged()), this, SLOT(drawPCCursor()));
     connect(Core(), SIGNAL(refreshAll()), this, SLOT(fetchAndPaintData()));
-    connect(Core(), SIGNAL(functionsChanged()), this, SLOT(fetchAndPaintData()));
-    connect(Core(), SIGNAL(flagsChanged()), this, SLOT(fetchAndPaintData()));
-
-    graphicsScene = new QGraphicsScene(this);
-
-    const QBrush bg = QBrush(QColor(74, 74, 74));
-
-    graphicsScene->setBackgroundBrush(bg);
-
-    this->graphicsView->setAlignment(Qt::AlignLeft);
-    this->graphicsView->setMinimumHeight(15);
-    this->graphicsView->setMaximumHeight(15);
-    this->graphicsView->setFrameShape(QFrame::NoFrame);
-    this->graphicsView->setRenderHints(0);
-    this->graphicsView->setScene(graphicsScene);
-    this->graphicsView->setRenderHints(QPainter::Antialiasing);
-    this->graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    this->graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    // So the graphicsView doesn't intercept mouse events.
-    this->graphicsView->setEnabled(false);
-    this->graphicsView->setMouseTracking(true);
+    // Only the function counts change, flags are not shown at all
+    connect(Core(), SIGNAL(functionsChanged()), this, SLOT(updateFunctionStats()));
+    connect(Core()->getTraceManager(), &TraceManager::hitCountsChanged,
+            this, &VisualNavbar::updateTraceColumns);
+
+    this->canvas->setMinimumHeight(15);
+    this->canvas->setMaximumHeight(15);
+    this->canvas->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    // So the canvas doesn't intercept mouse events.
+    this->canvas->setAttribute(Qt::WA_TransparentForMouseEvents);
+    this->canvas->setAttribute(Qt::WA_OpaquePaintEvent);
+    this->canvas->installEventFilter(this);
     setMouseTracking(true);
 }
 
@@ -79,13 +64,18 @@ unsigned int nextPow2(unsigned int n)
     return (1u << b);
 }
 
-void VisualNavbar::paintEvent(QPaintEvent *event)
+bool VisualNavbar::eventFilter(QObject *obj, QEvent *event)
 {
-    Q_UNUSED(event);
-
-    QPainter painter(this);
+    if (obj == canvas && event->type() == QEvent::Paint) {
+        paintCanvas();
+        return true;
+    }
+    return QToolBar::eventFilter(obj, event);
+}
 
-    auto w = static_cast<unsigned int>(width());
+void VisualNavbar::paintCanvas()
+{
+    auto w = static_cast<unsigned int>(canvas->width());
     bool fetch = false;
     if (statsWidth < w) {
         statsWidth = nextPow2(w);
@@ -96,17 +86,42 @@ void VisualNavbar::paintEvent(QPaintEvent *event)
     }
 
     if (fetch) {
-        fetchAndPaintData();
-    } else if (previousWidth != w) {
-        this->previousWidth = w;
-        updateGraphicsScene();
+        fetchStats();
+        updateImage();
+    } else if (previousWidth != canvas->width()) {
+        updateImage();
+    }
+
+    QPainter painter(canvas);
+    painter.drawImage(canvas->rect(), image);
+
+    // Executed code of the open trace, as a strip along the bottom
+    TraceManager *traceManager = Core()->getTraceManager();
+    const int traceHeight = 3;
+    for (int x = 0; x < traceColumns.size(); x++) {
+        if (traceColumns[x]) {
+            painter.fillRect(QRect(x, canvas->height() - traceHeight, 1, traceHeight),
+                             traceManager->colorForHitCount(traceColumns[x]));
+        }
+    }
+
+    // Cursors are drawn over the cached image
+    auto drawCursor = [this, &painter](RVA addr, const QColor & color) {
+        double cursor_x = addressToLocalX(addr);
+        if (!std::isnan(cursor_x)) {
+            painter.fillRect(QRectF(cursor_x, 0, 2, canvas->height()), color);
+        }
+    };
+    if (PCAddr != RVA_INVALID) {
+        drawCursor(PCAddr, Config()->getColor("gui.navbar.pc"));
     }
+    drawCursor(Core()->getOffset(), Config()->getColor("gui.navbar.seek"));
 }
 
 void VisualNavbar::fetchAndPaintData()
 {
     fetchStats();
-    updateGraphicsScene();
+    updateImage();
 }
 
 void VisualNavbar::fetchStats()
@@ -114,116 +129,143 @@ void VisualNavbar::fetchStats()
     stats = Core()->getBlockStatistics(statsWidth);
 }
 
-enum class DataType : int { Empty, Code, String, Symbol, Count };
-
-void VisualNavbar::updateGraphicsScene()
+void VisualNavbar::updateFunctionStats()
 {
-    graphicsScene->clear();
-    xToAddress.clear();
-    seekGraphicsItem = nullptr;
-    PCGraphicsItem = nullptr;
-    graphicsScene->setBackgroundBrush(QBrush(Config()->getColor("gui.navbar.empty")));
-
-    if (stats.to <= stats.from) {
+    if (stats.blocks.size() != blockTypes.size()) {
+        fetchAndPaintData();
         return;
     }
-
-    int w = graphicsView->width();
-    int h = graphicsView->height();
-
-    RVA totalSize = stats.to - stats.from;
-    RVA beginAddr = stats.from;
-
-    double widthPerByte = (double)w / (double)totalSize;
-    auto xFromAddr = [widthPerByte, beginAddr] (RVA addr) -> double {
-        return (addr - beginAddr) * widthPerByte;
-    };
-
-    std::array<QBrush, static_cast<int>(DataType::Count)> dataTypeBrushes;
-    dataTypeBrushes[static_cast<int>(DataType::Code)] = QBrush(Config()->getColor("gui.navbar.code"));
-    dataTypeBrushes[static_cast<int>(DataType::String)] = QBrush(Config()->getColor("gui.navbar.str"));
-    dataTypeBrushes[static_cast<int>(DataType::Symbol)] = QBrush(Config()->getColor("gui.navbar.sym"));
-
-    DataType lastDataType = DataType::Empty;
-    QGraphicsRectItem *dataItem = nullptr;
-    QRectF dataItemRect(0.0, 0.0, 0.0, h);
-    for (const BlockDescription &block : stats.blocks) {
-        // Keep track of where which memory segment is mapped so we are able to convert from
-        // address to X coordinate and vice versa.
-        XToAddress x2a;
-        x2a.x_start = xFromAddr(block.addr);
-        x2a.x_end = xFromAddr(block.addr + block.size);
-        x2a.address_from = block.addr;
-        x2a.address_to = block.addr + block.size;
-        xToAddress.append(x2a);
-
-        DataType dataType;
-        if (block.functions > 0) {
-            dataType = DataType::Code;
-        } else if (block.strings > 0) {
-            dataType = DataType::String;
-        } else if (block.symbols > 0) {
-            dataType = DataType::Symbol;
-        } else if (block.inFunctions > 0) {
-            dataType = DataType::Code;
-        } else {
-            lastDataType = DataType::Empty;
+    Core()->updateBlockFunctionStatistics(stats);
+
+    // Only repaint the columns of blocks that changed
+    int dirtyFrom = image.width();
+    int dirtyTo = 0;
+    for (int i = 0; i < stats.blocks.size(); i++) {
+        DataType dataType = dataTypeForBlock(stats.blocks[i]);
+        if (dataType == blockTypes[i]) {
             continue;
         }
+        blockTypes[i] = dataType;
+        int from, to;
+        blockPixels(i, &from, &to);
+        dirtyFrom = std::min(dirtyFrom, from);
+        dirtyTo = std::max(dirtyTo, to);
+    }
+    if (dirtyFrom < dirtyTo) {
+        paintImage(dirtyFrom, dirtyTo);
+        canvas->update();
+    }
+}
 
-        if (dataType == lastDataType) {
-            double r = xFromAddr(block.addr + block.size);
-            if (r > dataItemRect.right()) {
-                dataItemRect.setRight(r);
-                dataItem->setRect(dataItemRect);
-            }
-            dataItem->setRect(dataItemRect);
-            continue;
-        }
+VisualNavbar::DataType VisualNavbar::dataTypeForBlock(const BlockDescription &block)
+{
+    if (block.functions > 0) {
+        return DataType::Code;
+    } else if (block.strings > 0) {
+        return DataType::String;
+    } else if (block.symbols > 0) {
+        return DataType::Symbol;
+    } else if (block.inFunctions > 0) {
+        return DataType::Code;
+    }
+    return DataType::Empty;
+}
 
-        dataItemRect.setX(xFromAddr(block.addr));
-        dataItemRect.setRight(xFromAddr(block.addr + block.size));
+void VisualNavbar::updateImage()
+{
+    xToAddress.clear();
+    blockTypes.clear();
+
+    int w = canvas->width();
+    previousWidth = w;
+    image = QImage(std::max(w, 1), 1, QImage::Format_RGB32);
+
+    dataTypeColors[static_cast<int>(DataType::Empty)] = Config()->getColor("gui.navbar.empty");
+    dataTypeColors[static_cast<int>(DataType::Code)] = Config()->getColor("gui.navbar.code");
+    dataTypeColors[static_cast<int>(DataType::String)] = Config()->getColor("gui.navbar.str");
+    dataTypeColors[static_cast<int>(DataType::Symbol)] = Config()->getColor("gui.navbar.sym");
+
+    if (stats.to > stats.from) {
+        RVA totalSize = stats.to - stats.from;
+        RVA beginAddr = stats.from;
+
+        double widthPerByte = (double)w / (double)totalSize;
+        auto xFromAddr = [widthPerByte, beginAddr] (RVA addr) -> double {
+            return (addr - beginAddr) * widthPerByte;
+        };
+
+        xToAddress.reserve(stats.blocks.size());
+        blockTypes.reserve(stats.blocks.size());
+        for (const BlockDescription &block : stats.blocks) {
+            // Keep track of where which memory segment is mapped so we are able to convert from
+            // address to X coordinate and vice versa.
+            XToAddress x2a;
+            x2a.x_start = xFromAddr(block.addr);
+            x2a.x_end = xFromAddr(block.addr + block.size);
+            x2a.address_from = block.addr;
+            x2a.address_to = block.addr + block.size;
+            xToAddress.append(x2a);
+            blockTypes.append(dataTypeForBlock(block));
+        }
+    }
 
-        dataItem = new QGraphicsRectItem();
-        dataItem->setPen(Qt::NoPen);
-        dataItem->setBrush(dataTypeBrushes[static_cast<int>(dataType)]);
-        graphicsScene->addItem(dataItem);
+    paintImage(0, image.width());
+    updateTraceColumns();
+}
 
-        lastDataType = dataType;
+void VisualNavbar::updateTraceColumns()
+{
+    traceColumns.clear();
+    const QHash<RVA, quint32> &hitCounts = Core()->getTraceManager()->getHitCounts();
+    if (!hitCounts.isEmpty()) {
+        traceColumns.fill(0, image.width());
+        for (auto it = hitCounts.constBegin(); it != hitCounts.constEnd(); ++it) {
+            double x = addressToLocalX(it.key());
+            if (std::isnan(x)) {
+                continue;
+            }
+            int column = std::min(static_cast<int>(x), traceColumns.size() - 1);
+            traceColumns[column] = std::max(traceColumns[column], it.value());
+        }
     }
+    canvas->update();
+}
 
-    // Update scene width
-    graphicsScene->setSceneRect(0, 0, w, h);
-
-    drawSeekCursor();
+void VisualNavbar::blockPixels(int blockIndex, int *from, int *to) const
+{
+    const XToAddress &x2a = xToAddress[blockIndex];
+    *from = std::max(0, static_cast<int>(std::floor(x2a.x_start)));
+    *to = std::min(image.width(), std::max(*from + 1, static_cast<int>(std::ceil(x2a.x_end))));
 }
 
-void VisualNavbar::drawCursor(RVA addr, QColor color, QGraphicsRectItem *&graphicsItem)
+void VisualNavbar::paintImage(int from, int to)
 {
-    double cursor_x = addressToLocalX(addr);
-    if (graphicsItem != nullptr) {
-        graphicsScene->removeItem(graphicsItem);
-        delete graphicsItem;
-        graphicsItem = nullptr;
-    }
-    if (std::isnan(cursor_x)) {
-        return;
+    QPainter painter(&image);
+    painter.fillRect(QRect(from, 0, to - from, 1), dataTypeColors[static_cast<int>(DataType::Empty)]);
+    for (int i = 0; i < blockTypes.size(); i++) {
+        if (blockTypes[i] == DataType::Empty) {
+            continue;
+        }
+        int blockFrom, blockTo;
+        blockPixels(i, &blockFrom, &blockTo);
+        blockFrom = std::max(blockFrom, from);
+        blockTo = std::min(blockTo, to);
+        if (blockFrom < blockTo) {
+            painter.fillRect(QRect(blockFrom, 0, blockTo - blockFrom, 1),
+                             dataTypeColors[static_cast<int>(blockTypes[i])]);
+        }
     }
-    int h = this->graphicsView->height();
-    graphicsItem = new QGraphicsRectItem(cursor_x, 0, 2, h);
-    graphicsItem->setPen(Qt::NoPen);
-    graphicsItem->setBrush(QBrush(color));
-    graphicsScene->addItem(graphicsItem);
 }
 
 void VisualNavbar::drawPCCursor()
 {
-    drawCursor(Core()->getProgramCounterValue(), Config()->getColor("gui.navbar.pc"), PCGraphicsItem);
+    PCAddr = Core()->getDebugState()->getProgramCounter();
+    canvas->update();
 }
 
 void VisualNavbar::drawSeekCursor()
 {
-    drawCursor(Core()->getOffset(), Config()->getColor("gui.navbar.seek"), seekGraphicsItem);
+    canvas->update();
 }
 
 void VisualNavbar::on_seekChanged(RVA addr)
@@ -235,7 +277,7 @@ void VisualNavbar::on_seekChanged(RVA addr)
 
 void VisualNavbar::mousePressEvent(QMouseEvent *event)
 {
-    qreal x = event->localPos().x();
+    qreal x = event->localPos().x() - canvas->x();
     RVA address = localXToAddress(x);
     if (address != RVA_INVALID) {
         QToolTip::showText(event->globalPos(), toolTipForAddress(address), this);
@@ -254,26 +296,38 @@ void VisualNavbar::mouseMoveEvent(QMouseEvent *event)
 
 RVA VisualNavbar::localXToAddress(double x)
 {
-    for (const XToAddress &x2a : xToAddress) {
-        if ((x2a.x_start <= x) && (x <= x2a.x_end)) {
-            double offset = (x - x2a.x_start) / (x2a.x_end - x2a.x_start);
-            double size = x2a.address_to - x2a.address_from;
-            return x2a.address_from + (offset * size);
-        }
+    auto it = std::upper_bound(xToAddress.begin(), xToAddress.end(), x,
+    [](double x, const XToAddress & x2a) {
+        return x < x2a.x_start;
+    });
+    if (it == xToAddress.begin()) {
+        return RVA_INVALID;
     }
-    return RVA_INVALID;
+    const XToAddress &x2a = *(it - 1);
+    if (x > x2a.x_end) {
+        return RVA_INVALID;
+    }
+    double offset = (x - x2a.x_start) / (x2a.x_end - x2a.x_start);
+    double size = x2a.address_to - x2a.address_from;
+    return x2a.address_from + (offset * size);
 }
 
 double VisualNavbar::addressToLocalX(RVA address)
 {
-    for (const XToAddress &x2a : xToAddress) {
-        if ((x2a.address_from <= address) && (address < x2a.address_to)) {
-            double offset = (double)(address - x2a.address_from) / (double)(x2a.address_to - x2a.address_from);
-            double size = x2a.x_end - x2a.x_start;
-            return x2a.x_start + (offset * size);
-        }
+    auto it = std::upper_bound(xToAddress.begin(), xToAddress.end(), address,
+    [](RVA address, const XToAddress & x2a) {
+        return address < x2a.address_from;
+    });
+    if (it == xToAddress.begin()) {
+        return nan("");
+    }
+    const XToAddress &x2a = *(it - 1);
+    if (address >= x2a.address_to) {
+        return nan("");
     }
-    return nan("");
+    double offset = (double)(address - x2a.address_from) / (double)(x2a.address_to - x2a.address_from);
+    double size = x2a.x_end - x2a.x_start;
+    return x2a.x_start + (offset * size);
 }
 
 QList<QString> VisualNavbar::sectionsForAddress(RVA address)
@@ -2,12 +2,13 @@
 #define VISUALNAVBAR_H
 
 #include <QToolBar>
-#include <QGraphicsScene>
+#include <QImage>
+
+#include <array>
 
 #include "core/Cutter.h"
 
 class MainWindow;
-class QGraphicsView;
 
 class VisualNavbar : public QToolBar
 {
@@ -20,39 +21,57 @@ class VisualNavbar : public QToolBar
         RVA address_to;
     };
 
+    enum class DataType : int { Empty, Code, String, Symbol, Count };
+
 public:
     explicit VisualNavbar(MainWindow *main, QWidget *parent = nullptr);
 
 public slots:
-    void paintEvent(QPaintEvent *event) override;
-    void updateGraphicsScene();
+    void updateImage();
 
 private slots:
     void fetchAndPaintData();
     void fetchStats();
+    void updateFunctionStats();
     void drawSeekCursor();
     void drawPCCursor();
-    void drawCursor(RVA addr, QColor color, QGraphicsRectItem *&graphicsItem);
+    void updateTraceColumns();
     void on_seekChanged(RVA addr);
 
 private:
-    QGraphicsView     *graphicsView;
-    QGraphicsScene    *graphicsScene;
-    QGraphicsRectItem *seekGraphicsItem;
-    QGraphicsRectItem *PCGraphicsItem;
+    QWidget           *canvas;
     MainWindow        *main;
 
+    /**
+     * @brief Block types rasterized with one pixel per column, stretched to the height of canvas
+     */
+    QImage             image;
+    std::array<QColor, static_cast<int>(DataType::Count)> dataTypeColors;
+
     BlockStatistics    stats;
+    QVector<DataType>  blockTypes;
     unsigned int       statsWidth = 0;
-    unsigned int       previousWidth = 0;
+    int                previousWidth = -1;
+    RVA                PCAddr = RVA_INVALID;
+
+    /**
+     * @brief Highest hit count of the open trace in each column of canvas
+     */
+    QVector<quint32>   traceColumns;
 
     QList<XToAddress> xToAddress;
 
+    static DataType dataTypeForBlock(const BlockDescription &block);
+    void blockPixels(int blockIndex, int *from, int *to) const;
+    void paintImage(int from, int to);
+    void paintCanvas();
+
     RVA localXToAddress(double x);
     double addressToLocalX(RVA address);
     QList<QString> sectionsForAddress(RVA address);
     QString toolTipForAddress(RVA address);
 
+    bool eventFilter(QObject *obj, QEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
 };